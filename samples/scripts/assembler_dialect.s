@@ -0,0 +1,164 @@
+# Assembler dialect coverage for check_assembler.py: labels, REG declarations, data
+# directives, strings holding '#' and '\"', .loc/.file, %hi/%lo/%gp_rel, negative and
+# signed immediates, and ELF assignments, in the forms the TRaX LLVM backend writes them.
+# It only has to assemble and run to completion, what it computes doesn't matter.
+	REG	$HI
+	REG	$LO
+	REG	$zero
+	REG	$at
+	REG	$1
+	REG	$2
+	REG	$3
+	REG	$4
+	REG	$5
+	REG	$6
+	REG	$7
+	REG	$8
+	REG	$9
+	REG	$10
+	REG	$11
+	REG	$12
+	REG	$13
+	REG	$14
+	REG	$15
+	REG	$16
+	REG	$17
+	REG	$18
+	REG	$19
+	REG	$20
+	REG	$21
+	REG	$22
+	REG	$23
+	REG	$24
+	REG	$25
+	REG	$26
+	REG	$27
+	REG	$gp
+	REG	$sp
+	REG	$fp
+	REG	$ra
+	REG	$f0
+	REG	$f1
+	REG	$f2
+	REG	$f3
+	REG	$f4
+	REG	$f5
+	REG	$f6
+	REG	$f7
+	REG	$f8
+	REG	$f9
+	REG	$f10
+	REG	$f11
+	REG	$f12
+	REG	$f13
+	REG	$f14
+	REG	$f15
+	REG	$f16
+	REG	$f17
+	REG	$f18
+	REG	$f19
+	REG	$f20
+	REG	$f21
+	REG	$f22
+	REG	$f23
+	REG	$f24
+	REG	$f25
+	REG	$f26
+	REG	$f27
+	REG	$f28
+	REG	$f29
+	REG	$f30
+	REG	$f31
+	REG	$fcc0
+
+	.section .mdebug.abi32
+	.globl	main
+	.align	2
+	.type	main,@function
+	.ent	main   # @main
+	.set	noreorder
+	.previous
+	.file	1 "assembler_dialect.c"
+	.file	2 "/no/such/dir/inc.h"
+.TRaX_START_PREAMBLE:
+	xor_m	$zero, $zero, $zero
+	xor_m	$gp, $gp, $gp
+	LOADIMM	$sp, 16000
+	bal	$ra, .TRaX_INIT
+	nop
+.start:
+	bal	$ra, main
+	nop
+	HALT
+.TRaX_END_PREAMBLE:
+	.text
+main:                                   # @main
+# BB#0:                                 # %entry
+	.loc	1 12 3 prologue_end     # assembler_dialect.c:12:3
+	addiu	$sp, $sp, -24
+	sw	$ra, 20($sp)            # 4-byte Folded Spill
+	lui	$2, %hi($.str)
+	addiu	$4, $2, %lo($.str)
+	lw	$3, %gp_rel(counter)($gp)
+	lw	$5, %lo(table)($2)
+	LOADIMM	$6, -17
+	LOADIMM	$7, +9
+	addiu	$8, $zero, 16
+	addiu	$6, $zero, 3
+	.loc	2 7 11
+	beq	$6, $zero, $BB0_3
+	nop
+$BB0_2:                                 # %for.body
+                                        # =>This Inner Loop Header: Depth=1
+	lbu	$3, 0($5)
+	sb	$3, 0($2)
+	addiu	$5, $5, 1
+	addiu	$6, $6, -1
+	bne	$6, $zero, $BB0_2
+	nop
+	.loc	1 20 0
+$BB0_3:
+	addiu	$9, $zero, sizeish
+	addiu	$10, $zero, diff
+	lw	$ra, 20($sp)            # 4-byte Folded Reload
+	jr	$ra
+	addiu	$sp, $sp, 24
+$tmp0:
+	.size	main, ($tmp0)-main
+sizeish = ($tmp0)-main
+diff = ($tmp0)+$BB0_2
+
+	.type	$.str,@object           # @.str
+	.section	.rodata.str1.1,"aMS",@progbits,1
+$.str:
+	.asciz	 "hi # there\n\t\"x\" \101\\"
+	.size	$.str, 20
+$.str1:
+	.ascii	"abc#def"   # trailing comment "quoted"
+	.asciz	"a"
+	.data
+	.globl	counter
+	.align	2
+counter:
+	.4byte	5
+	.2byte	-3
+	.byte	7
+	.byte	-1
+	.space	12
+	.size	counter, 4
+table:
+	.4byte	$BB0_2
+	.4byte	main
+	.4byte	$.str1
+	.4byte	counter
+	.4byte	-42
+	.section .debug_abbrev
+$section_abbrev:
+	.byte	1
+	.byte	17
+	.section .debug_info
+$.debug_info_begin0:
+	.4byte	34
+	.2byte	2
+	.text
+.TRaX_INIT:
@@ -0,0 +1,159 @@
+#!/usr/bin/env python
+# Simulator throughput benchmark. Runs a fixed matrix of workloads, hardware configs and
+# simulation thread counts, and records wall time, simulated cycles per second and peak
+# RSS of each run as JSON. Given a baseline from an earlier run it reports any run that
+# got slower or bigger by more than the tolerance, and exits non-zero if one did.
+#
+# The sample kernels have to be compiled first (samples/ cmake + install, or each sample's
+# Makefile). Workloads whose assembly can't be found are skipped.
+#
+# usage: bench.py --simtrax <path to simtrax> [--output bench.json] [--baseline old.json]
+#                 [--tolerance 0.10] [--threads 1,2,4,8] [--configs tiny,default,bigcache]
+#                 [--workloads helloworld,...] [--size 64] [--cornell-assembly <file>]
+
+from __future__ import print_function
+import json
+import optparse
+import os
+import re
+import subprocess
+import sys
+import time
+
+SAMPLES = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+CONFIGS = os.path.join(SAMPLES, 'configs')
+CORNELL = os.path.join(SAMPLES, 'scenes', 'cornell')
+
+# cmake installs the sample kernels under bin/, their Makefiles leave them next to the source
+def sample_assembly(name):
+  return [os.path.join(SAMPLES, 'bin', name, name + '_rt-llvm.s'),
+          os.path.join(SAMPLES, 'src', name, 'rt-llvm.s')]
+
+# (name, assembly search path, scene arguments)
+WORKLOADS = [
+  ('helloworld', sample_assembly('helloworld'), ['--no-scene']),
+  ('gradient', sample_assembly('gradient'), ['--no-scene']),
+  ('mandelbrot', sample_assembly('mandelbrot'), ['--no-scene']),
+  ('simd_mandelbrot', sample_assembly('simd_mandelbrot'), ['--no-scene']),
+  # the samples have no ray tracer, so the cornell kernel is given on the command line
+  ('cornell', [], ['--view-file', os.path.join(CORNELL, 'cornell.view'),
+                   '--model', os.path.join(CORNELL, 'CornellBox.obj'),
+                   '--light-file', os.path.join(CORNELL, 'cornell.light')]),
+]
+
+COMMON_ARGS = [
+  '--dcacheparams', os.path.join(CONFIGS, 'dcacheparams.txt'),
+  '--icacheparams', os.path.join(CONFIGS, 'icacheparams.txt'),
+  '--usimm-config', os.path.join(CONFIGS, 'usimm_configs', 'gddr5_8ch.cfg'),
+  '--vi-file', os.path.join(CONFIGS, 'usimm_configs', '1Gb_x16_amd2GHz.vi'),
+  '--num-TMs', '8',
+  '--num-thread-procs', '16',
+  '--no-png',
+]
+
+
+def run(simtrax, assembly, scene, config, threads, size):
+  args = [simtrax, '--load-assembly', assembly,
+          '--config-file', os.path.join(CONFIGS, config + '.config'),
+          '--simulation-threads', str(threads),
+          '--width', str(size), '--height', str(size)] + COMMON_ARGS + scene
+  start = time.time()
+  child = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+  output = child.stdout.read().decode('utf-8', 'replace')
+  # reap the child ourselves, wait4 is the only way to get its own peak RSS
+  _, status, usage = os.wait4(child.pid, 0)
+  child.stdout.close()
+  child.returncode = status
+  wall = time.time() - start
+  if not os.WIFEXITED(status) or os.WEXITSTATUS(status) != 0:
+    print('  FAILED (status %d): %s' % (status, ' '.join(args)))
+    print(output[-2000:])
+    return None
+  match = re.search(r'Total clock cycles:\s*(\d+)', output)
+  if not match:
+    print('  no cycle count in output of: %s' % ' '.join(args))
+    return None
+  cycles = int(match.group(1))
+  return {'wall_seconds': wall, 'cycles': cycles, 'cycles_per_second': cycles / wall,
+          'peak_rss_kb': usage.ru_maxrss}
+
+
+def compare(results, baseline, tolerance):
+  regressions = 0
+  for key in sorted(results):
+    if key not in baseline:
+      continue
+    new, old = results[key], baseline[key]
+    notes = []
+    if new['cycles_per_second'] < old['cycles_per_second'] * (1. - tolerance):
+      notes.append('cycles/s %.0f -> %.0f' % (old['cycles_per_second'], new['cycles_per_second']))
+    if new['peak_rss_kb'] > old['peak_rss_kb'] * (1. + tolerance):
+      notes.append('peak RSS %d -> %d KB' % (old['peak_rss_kb'], new['peak_rss_kb']))
+    if notes:
+      regressions += 1
+      print('REGRESSION %s: %s' % (key, ', '.join(notes)))
+    # a different simulated result is not a speed problem, but it makes the comparison moot
+    if new['cycles'] != old['cycles']:
+      print('NOTE %s: simulated cycles changed %d -> %d' % (key, old['cycles'], new['cycles']))
+  return regressions
+
+
+def main():
+  parser = optparse.OptionParser()
+  parser.add_option('--simtrax', help='simtrax binary to benchmark')
+  parser.add_option('--output', default='bench.json', help='where to write results')
+  parser.add_option('--baseline', help='earlier results to compare against')
+  parser.add_option('--tolerance', type='float', default=0.10, help='allowed slowdown/growth, default 0.10')
+  parser.add_option('--threads', default='1,2,4,8', help='simulation thread counts')
+  parser.add_option('--configs', default='tiny,default,bigcache', help='hardware configs from samples/configs')
+  parser.add_option('--workloads', default=','.join(w[0] for w in WORKLOADS), help='workloads to run')
+  parser.add_option('--size', type='int', default=64, help='image width and height')
+  parser.add_option('--cornell-assembly', help='ray tracing kernel to run on the cornell scene')
+  options, _ = parser.parse_args()
+  if not options.simtrax:
+    parser.error('--simtrax is required')
+
+  wanted = options.workloads.split(',')
+  configs = options.configs.split(',')
+  threads = [int(t) for t in options.threads.split(',')]
+
+  results = {}
+  for name, search, scene in WORKLOADS:
+    if name not in wanted:
+      continue
+    if name == 'cornell' and options.cornell_assembly:
+      search = [options.cornell_assembly]
+    found = [path for path in search if os.path.exists(path)]
+    if not found:
+      print('skipping %s: no assembly found' % name)
+      continue
+    for config in configs:
+      for thread_count in threads:
+        key = '%s/%s/%dt' % (name, config, thread_count)
+        print(key)
+        result = run(options.simtrax, found[0], scene, config, thread_count, options.size)
+        if result is None:
+          return 1
+        print('  %.2f s, %.0f cycles/s, %d KB' % (result['wall_seconds'], result['cycles_per_second'],
+                                                result['peak_rss_kb']))
+        results[key] = result
+
+  if not results:
+    print('nothing was run, build the samples first')
+    return 1
+  with open(options.output, 'w') as f:
+    json.dump(results, f, indent=2, sort_keys=True)
+  print('wrote %s' % options.output)
+
+  if options.baseline:
+    with open(options.baseline) as f:
+      baseline = json.load(f)
+    regressions = compare(results, baseline, options.tolerance)
+    print('%d regression(s) against %s' % (regressions, options.baseline))
+    if regressions:
+      return 1
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
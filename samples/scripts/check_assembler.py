@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+# Differential check of the assembler's hand written lexer (sim/AsmLexer.cc) against the
+# regular expressions it replaced. Each kernel is run with simtrax --check-assembler, which
+# matches every line both ways and stops at the first disagreement. Exits non-zero if any
+# kernel disagrees or fails to run.
+#
+# assembler_dialect.s next to this script is always checked. The sample kernels are
+# checked too if they have been compiled (see bench.py), any other assembly files can be
+# given on the command line.
+#
+# usage: check_assembler.py --simtrax <path to simtrax> [kernel.s ...]
+
+from __future__ import print_function
+import optparse
+import os
+import subprocess
+import sys
+
+SCRIPTS = os.path.dirname(os.path.abspath(__file__))
+SAMPLES = os.path.normpath(os.path.join(SCRIPTS, '..'))
+CONFIGS = os.path.join(SAMPLES, 'configs')
+
+SAMPLE_KERNELS = ['helloworld', 'gradient', 'mandelbrot', 'simd_mandelbrot']
+
+# One thread on a tiny image, the check is done while assembling
+ARGS = [
+  '--check-assembler',
+  '--no-scene',
+  '--config-file', os.path.join(CONFIGS, 'tiny.config'),
+  '--dcacheparams', os.path.join(CONFIGS, 'dcacheparams.txt'),
+  '--icacheparams', os.path.join(CONFIGS, 'icacheparams.txt'),
+  '--usimm-config', os.path.join(CONFIGS, 'usimm_configs', 'gddr5_8ch.cfg'),
+  '--vi-file', os.path.join(CONFIGS, 'usimm_configs', '1Gb_x16_amd2GHz.vi'),
+  '--num-TMs', '1',
+  '--num-thread-procs', '1',
+  '--width', '1', '--height', '1',
+  '--no-png',
+]
+
+
+def kernels(extra):
+  found = [os.path.join(SCRIPTS, 'assembler_dialect.s')]
+  for name in SAMPLE_KERNELS:
+    # cmake installs the sample kernels under bin/, their Makefiles leave them next to the source
+    for path in [os.path.join(SAMPLES, 'bin', name, name + '_rt-llvm.s'),
+                 os.path.join(SAMPLES, 'src', name, 'rt-llvm.s')]:
+      if os.path.exists(path):
+        found.append(path)
+        break
+    else:
+      print('skipping %s: no assembly found' % name)
+  return found + extra
+
+
+def check(simtrax, assembly):
+  args = [simtrax, '--load-assembly', assembly] + ARGS
+  child = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+  output = child.communicate()[0].decode('utf-8', 'replace')
+  lines = output.splitlines()
+  for i in range(len(lines)):
+    if 'assembler lexer disagrees' in lines[i]:
+      print('DISAGREEMENT %s:' % assembly)
+      print('\n'.join(lines[i:i + 3]))
+      return False
+  if child.returncode != 0:
+    print('FAILED (status %d): %s' % (child.returncode, ' '.join(args)))
+    print(output[-2000:])
+    return False
+  print('ok %s' % assembly)
+  return True
+
+
+def main():
+  parser = optparse.OptionParser(usage='%prog --simtrax <path to simtrax> [kernel.s ...]')
+  parser.add_option('--simtrax', help='simtrax binary to check')
+  options, extra = parser.parse_args()
+  if not options.simtrax:
+    parser.error('--simtrax is required')
+
+  failures = 0
+  for assembly in kernels(extra):
+    if not check(options.simtrax, assembly):
+      failures += 1
+  print('%d kernel(s) disagreed or failed' % failures)
+  return 1 if failures else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
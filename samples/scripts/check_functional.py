@@ -0,0 +1,113 @@
+#!/usr/bin/env python
+# Checks the engines without a full timing model against the cycle-accurate one: each
+# kernel is run cycle-accurate, with --functional and sampled (--sample-interval, which
+# fast-forwards functionally between windows), on one TM and on several, and every run
+# has to finish and write the same image as the cycle-accurate run on the same TMs.
+#
+# functional_atomic.s next to this script is always checked. The scene-less sample
+# kernels are checked too if they have been compiled (see bench.py), any other scene-less
+# assembly files can be given on the command line.
+#
+# usage: check_functional.py --simtrax <path to simtrax> [kernel.s ...]
+
+from __future__ import print_function
+import optparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+SCRIPTS = os.path.dirname(os.path.abspath(__file__))
+SAMPLES = os.path.normpath(os.path.join(SCRIPTS, '..'))
+CONFIGS = os.path.join(SAMPLES, 'configs')
+
+SAMPLE_KERNELS = ['helloworld', 'gradient', 'mandelbrot', 'simd_mandelbrot']
+
+# (name, extra arguments), the first is the reference
+MODES = [
+  ('cycle-accurate', []),
+  ('functional', ['--functional']),
+  ('sampled', ['--sample-interval', '500']),
+]
+
+TM_COUNTS = [1, 4]
+
+ARGS = [
+  '--no-scene',
+  '--config-file', os.path.join(CONFIGS, 'tiny.config'),
+  '--dcacheparams', os.path.join(CONFIGS, 'dcacheparams.txt'),
+  '--icacheparams', os.path.join(CONFIGS, 'icacheparams.txt'),
+  '--usimm-config', os.path.join(CONFIGS, 'usimm_configs', 'gddr5_8ch.cfg'),
+  '--vi-file', os.path.join(CONFIGS, 'usimm_configs', '1Gb_x16_amd2GHz.vi'),
+  '--num-thread-procs', '4',
+  '--width', '16', '--height', '16',
+]
+
+
+def kernels(extra):
+  found = [os.path.join(SCRIPTS, 'functional_atomic.s')]
+  for name in SAMPLE_KERNELS:
+    # cmake installs the sample kernels under bin/, their Makefiles leave them next to the source
+    for path in [os.path.join(SAMPLES, 'bin', name, name + '_rt-llvm.s'),
+                 os.path.join(SAMPLES, 'src', name, 'rt-llvm.s')]:
+      if os.path.exists(path):
+        found.append(path)
+        break
+    else:
+      print('skipping %s: no assembly found' % name)
+  return found + extra
+
+
+# Returns the image the run wrote, or None if it failed
+def run(simtrax, assembly, tms, mode_args, prefix):
+  args = [simtrax, '--load-assembly', assembly, '--num-TMs', str(tms),
+          '--output-prefix', prefix] + ARGS + mode_args
+  child = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+  output = child.communicate()[0].decode('utf-8', 'replace')
+  if child.returncode != 0 or not os.path.exists(prefix + '.ppm'):
+    print('  FAILED (status %d): %s' % (child.returncode, ' '.join(args)))
+    print(output[-2000:])
+    return None
+  with open(prefix + '.ppm', 'rb') as f:
+    return f.read()
+
+
+def check(simtrax, assembly, scratch):
+  ok = True
+  for tms in TM_COUNTS:
+    reference = None
+    for name, mode_args in MODES:
+      image = run(simtrax, assembly, tms, mode_args, os.path.join(scratch, '%s_%d' % (name, tms)))
+      if image is None:
+        ok = False
+      elif reference is None:
+        reference = image
+      elif image != reference:
+        print('  MISMATCH: %s on %d TM(s) wrote a different image than %s' % (name, tms, MODES[0][0]))
+        ok = False
+  print('%s %s' % ('ok' if ok else 'FAILED', assembly))
+  return ok
+
+
+def main():
+  parser = optparse.OptionParser(usage='%prog --simtrax <path to simtrax> [kernel.s ...]')
+  parser.add_option('--simtrax', help='simtrax binary to check')
+  options, extra = parser.parse_args()
+  if not options.simtrax:
+    parser.error('--simtrax is required')
+
+  scratch = tempfile.mkdtemp(prefix='check_functional')
+  failures = 0
+  try:
+    for assembly in kernels(extra):
+      if not check(options.simtrax, assembly, scratch):
+        failures += 1
+  finally:
+    shutil.rmtree(scratch)
+  print('%d kernel(s) failed' % failures)
+  return 1 if failures else 0
+
+
+if __name__ == '__main__':
+  sys.exit(main())
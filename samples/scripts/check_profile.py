@@ -0,0 +1,132 @@
+#!/usr/bin/env python
+# Checks what simtrax --profile attributes to the source: profile_dwarf.s next to this
+# script carries hand written debug info whose line numbers and scopes are known (see its
+# header), and the run has to report exactly those. Three things are checked:
+#   - profile.out: how often each source line's instructions ran
+#   - the runtime profile printed at the end: which scopes ran, nested as in the source
+#   - the DWARF reader read the compile units the run touched, and not the one it didn't
+# Exits non-zero if anything differs or the run fails.
+#
+# usage: check_profile.py --simtrax <path to simtrax>
+
+from __future__ import print_function
+import optparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+SCRIPTS = os.path.dirname(os.path.abspath(__file__))
+SAMPLES = os.path.normpath(os.path.join(SCRIPTS, '..'))
+CONFIGS = os.path.join(SAMPLES, 'configs')
+
+KERNEL = os.path.join(SCRIPTS, 'profile_dwarf.s')
+THREADS = 4
+
+ARGS = [
+  '--load-assembly', KERNEL,
+  '--profile',
+  '--no-scene',
+  '--config-file', os.path.join(CONFIGS, 'tiny.config'),
+  '--dcacheparams', os.path.join(CONFIGS, 'dcacheparams.txt'),
+  '--icacheparams', os.path.join(CONFIGS, 'icacheparams.txt'),
+  '--usimm-config', os.path.join(CONFIGS, 'usimm_configs', 'gddr5_8ch.cfg'),
+  '--vi-file', os.path.join(CONFIGS, 'usimm_configs', '1Gb_x16_amd2GHz.vi'),
+  '--num-TMs', '1',
+  '--num-thread-procs', str(THREADS),
+  '--width', '4', '--height', '4',
+  '--no-png',
+]
+
+# (file, line): executions per thread, from the kernel's header
+LINES = {
+  ('a.c', 18): 2,
+  ('a.c', 20): 2 + 6 * 3 + 5 * 3,
+  ('a.c', 22): 5 * 2,
+  ('a.c', 24): 3,
+  ('b.c', 8): 5,
+  ('b.c', 10): 15,
+  ('b.c', 11): 15,
+  ('b.c', 12): 15 * 2,
+  ('b.c', 13): 5 * 2,
+  ('c.c', 3): 5 * 2,
+  ('c.c', 8): 0,
+  ('d.c', 2): 0,
+}
+
+# (depth, name) in the order simtrax prints them, biggest share first. The shares
+# themselves depend on the timing model, so only the tree is checked.
+SCOPES = [(0, 'main'), (1, 'helper'), (1, 'inl')]
+
+COMPILE_UNITS = 'read 3 of 4 compile units'
+
+
+def check_lines(profile):
+  executions = {}
+  for line in profile.splitlines()[1:]:
+    columns = line.split('\t')
+    if len(columns) == 5:
+      key = (columns[3], int(columns[4]))
+      executions[key] = executions.get(key, 0) + int(columns[1])
+  expected = dict((key, count * THREADS) for key, count in LINES.items())
+  ok = True
+  for key in sorted(set(expected) | set(executions)):
+    if executions.get(key) != expected.get(key):
+      print('  %s:%d ran %s times, expected %s' % (key[0], key[1], executions.get(key), expected.get(key)))
+      ok = False
+  return ok
+
+
+def check_scopes(output):
+  scopes = []
+  for line in output.splitlines():
+    m = re.match(r'^((?:\| )*)(\w+)\t[0-9.]+$', line)
+    if m:
+      scopes.append((len(m.group(1)) // 2, m.group(2)))
+  if scopes != SCOPES:
+    print('  runtime profile is %s, expected %s' % (scopes, SCOPES))
+    return False
+  return True
+
+
+def check_compile_units(output):
+  reads = [line for line in output.splitlines() if line.startswith('Debug info:')]
+  if not reads or COMPILE_UNITS not in reads[-1]:
+    print('  expected the DWARF reader to have %s, got %s' % (COMPILE_UNITS, reads[-1:] or 'nothing'))
+    return False
+  return True
+
+
+def main():
+  parser = optparse.OptionParser(usage='%prog --simtrax <path to simtrax>')
+  parser.add_option('--simtrax', help='simtrax binary to check')
+  options, extra = parser.parse_args()
+  if not options.simtrax:
+    parser.error('--simtrax is required')
+
+  # --profile writes its files to the working directory
+  scratch = tempfile.mkdtemp(prefix='check_profile')
+  try:
+    args = [os.path.abspath(options.simtrax)] + ARGS
+    child = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, cwd=scratch)
+    output = child.communicate()[0].decode('utf-8', 'replace')
+    if child.returncode != 0 or not os.path.exists(os.path.join(scratch, 'profile.out')):
+      print('FAILED (status %d): %s' % (child.returncode, ' '.join(args)))
+      print(output[-2000:])
+      return 1
+    with open(os.path.join(scratch, 'profile.out')) as f:
+      profile = f.read()
+  finally:
+    shutil.rmtree(scratch)
+
+  ok = check_lines(profile)
+  ok = check_scopes(output) and ok
+  ok = check_compile_units(output) and ok
+  print('%s %s' % ('ok' if ok else 'FAILED', KERNEL))
+  return 0 if ok else 1
+
+
+if __name__ == '__main__':
+  sys.exit(main())
@@ -0,0 +1,114 @@
+# Gradient kernel for check_functional.py. Every thread takes pixels from the ATOMIC_INC
+# counter until the image is done, so a single TM issues atomics back to back from all
+# of its threads, which the functional engines have to be able to retry.
+# Pixel i is i / width in red and green, so the image doesn't depend on which thread took it.
+	REG	$HI
+	REG	$LO
+	REG	$zero
+	REG	$at
+	REG	$1
+	REG	$2
+	REG	$3
+	REG	$4
+	REG	$5
+	REG	$6
+	REG	$7
+	REG	$8
+	REG	$9
+	REG	$10
+	REG	$11
+	REG	$12
+	REG	$13
+	REG	$14
+	REG	$15
+	REG	$16
+	REG	$17
+	REG	$18
+	REG	$19
+	REG	$20
+	REG	$21
+	REG	$22
+	REG	$23
+	REG	$24
+	REG	$25
+	REG	$26
+	REG	$27
+	REG	$gp
+	REG	$sp
+	REG	$fp
+	REG	$ra
+	REG	$f0
+	REG	$f1
+	REG	$f2
+	REG	$f3
+	REG	$f4
+	REG	$f5
+	REG	$f6
+	REG	$f7
+	REG	$f8
+	REG	$f9
+	REG	$f10
+	REG	$f11
+	REG	$f12
+	REG	$f13
+	REG	$f14
+	REG	$f15
+	REG	$f16
+	REG	$f17
+	REG	$f18
+	REG	$f19
+	REG	$f20
+	REG	$f21
+	REG	$f22
+	REG	$f23
+	REG	$f24
+	REG	$f25
+	REG	$f26
+	REG	$f27
+	REG	$f28
+	REG	$f29
+	REG	$f30
+	REG	$f31
+	REG	$fcc0
+
+.TRaX_START_PREAMBLE:
+	xor_m	$zero, $zero, $zero
+	xor_m	$gp, $gp, $gp
+	LOADIMM	$sp, 4000000
+	bal	$ra, .TRaX_INIT
+	nop
+.start:
+	bal	$ra, main
+	nop
+	HALT
+.TRaX_END_PREAMBLE:
+	.text
+main:
+	LOAD	$2, $zero, 7
+	LOAD	$3, $zero, 1
+	LOAD	$4, $zero, 4
+	mul	$5, $3, $4
+	addiu	$9, $zero, 3
+	mtc1	$3, $f2
+	cvt_s_w	$f3, $f2
+	ATOMIC_INC	$6, $zero
+$BB0_1:
+	slt	$7, $6, $5
+	beq	$7, $zero, $BB0_2
+	nop
+	mul	$8, $6, $9
+	addu	$8, $8, $2
+	LOAD	$10, $8, 0
+	mtc1	$6, $f0
+	cvt_s_w	$f1, $f0
+	div_s	$f4, $f1, $f3
+	STORE	$8, $f4, 0
+	STORE	$8, $f4, 1
+	STORE	$8, $f3, 2
+	ATOMIC_INC	$6, $zero
+	j	$BB0_1
+	nop
+$BB0_2:
+	jr	$ra
+	nop
+.TRaX_INIT:
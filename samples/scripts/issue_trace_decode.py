@@ -0,0 +1,139 @@
+#!/usr/bin/env python
+# Decodes a binary issue trace (simtrax --issue-verbosity 2, issue_trace.bin) back in to
+# the text files older simtrax versions wrote: t_all_trace.txt with every event, and one
+# tN_trace.txt per thread processor. With more than one TM the per-thread files are
+# tmT_tN_trace.txt, unless --tm picks a single TM. The format is described in
+# sim/IssueTrace.h.
+#
+# usage: issue_trace_decode.py [--tm T] [--output-dir dir] [issue_trace.bin]
+
+from __future__ import print_function
+import optparse
+import os
+import struct
+import sys
+
+MAGIC = b'TRAXITR'
+HEADER = struct.Struct('<8sIii')
+BLOCK = struct.Struct('<II')
+
+ISSUED, DEPENDENCE, PC, THREAD = range(4)
+
+
+def varint(data, pos):
+  value = 0
+  shift = 0
+  while True:
+    byte = data[pos]
+    pos += 1
+    value |= (byte & 0x7f) << shift
+    if byte < 0x80:
+      return value, pos
+    shift += 7
+
+
+def zigzag(value):
+  return (value >> 1) ^ -(value & 1)
+
+
+class TM(object):
+  def __init__(self):
+    self.cycle = 0
+    self.threads = {}  # (thread processor, slot) -> ThreadState address
+
+
+def decode(input, tm_filter, per_thread_name, output_dir):
+  header = input.read(HEADER.size)
+  magic, version, num_TMs, threads_per_TM = HEADER.unpack(header)
+  if magic.rstrip(b'\0') != MAGIC or version != 1:
+    sys.exit('not a version 1 issue trace')
+
+  tms = {}
+  pcs = {}  # PC -> (op name, "op a0 a1 a2\n")
+  outputs = {}
+  all_trace = open(os.path.join(output_dir, 't_all_trace.txt'), 'w')
+
+  def thread_file(tm, proc):
+    key = (tm, proc)
+    if key not in outputs:
+      outputs[key] = open(os.path.join(output_dir, per_thread_name(tm, proc)), 'w')
+    return outputs[key]
+
+  while True:
+    block_header = input.read(BLOCK.size)
+    if len(block_header) < BLOCK.size:
+      break
+    tm_id, size = BLOCK.unpack(block_header)
+    data = bytearray(input.read(size))
+    tm = tms.setdefault(tm_id, TM())
+    keep = tm_filter is None or tm_id == tm_filter
+    pos = 0
+    while pos < size:
+      kind = data[pos]
+      pos += 1
+      if kind == PC:
+        pc, pos = varint(data, pos)
+        length = data[pos]
+        name = data[pos + 1:pos + 1 + length].decode('ascii')
+        pos += 1 + length
+        args = []
+        for i in range(3):
+          arg, pos = varint(data, pos)
+          args.append(zigzag(arg))
+        pcs[pc] = (name, '%s %d %d %d\n' % (name, args[0], args[1], args[2]))
+      elif kind == THREAD:
+        proc, pos = varint(data, pos)
+        slot, pos = varint(data, pos)
+        tm.threads[(proc, slot)] = struct.unpack('<Q', bytes(data[pos:pos + 8]))[0]
+        pos += 8
+      elif kind == ISSUED:
+        delta, pos = varint(data, pos)
+        proc, pos = varint(data, pos)
+        slot, pos = varint(data, pos)
+        pc, pos = varint(data, pos)
+        tm.cycle += zigzag(delta)
+        if keep:
+          name, instruction = pcs[pc]
+          text = instruction + 'Cycle %d: Thread 0x%x: Instruction PC: %d (%s), ISSUED\n' % (
+            tm.cycle, tm.threads[(proc, slot)], pc, name)
+          thread_file(tm_id, proc).write(text)
+          all_trace.write(text)
+      elif kind == DEPENDENCE:
+        delta, pos = varint(data, pos)
+        proc, pos = varint(data, pos)
+        pc, pos = varint(data, pos)
+        id, pos = varint(data, pos)
+        tm.cycle += zigzag(delta)
+        if keep:
+          text = 'Cycle %d: Thread %d: Instruction %d: NR: DATA DEPENDENCY (%s)\n' % (
+            tm.cycle, proc, id, pcs[pc][0])
+          thread_file(tm_id, proc).write(text)
+          all_trace.write(text)
+      else:
+        sys.exit('corrupt issue trace: record type %d' % kind)
+
+  all_trace.close()
+  for output in outputs.values():
+    output.close()
+
+
+def main():
+  parser = optparse.OptionParser(usage='%prog [--tm T] [--output-dir dir] [issue_trace.bin]')
+  parser.add_option('--tm', type='int', default=None, help='only decode this TM')
+  parser.add_option('--output-dir', default='.', help='where to write the text files')
+  options, args = parser.parse_args()
+  filename = args[0] if args else 'issue_trace.bin'
+
+  with open(filename, 'rb') as input:
+    num_TMs = HEADER.unpack(input.read(HEADER.size))[2]
+  if options.tm is not None or num_TMs == 1:
+    per_thread_name = lambda tm, proc: 't%d_trace.txt' % proc
+  else:
+    per_thread_name = lambda tm, proc: 'tm%d_t%d_trace.txt' % (tm, proc)
+
+  with open(filename, 'rb') as input:
+    decode(input, options.tm, per_thread_name, options.output_dir)
+
+
+if __name__ == '__main__':
+  main()
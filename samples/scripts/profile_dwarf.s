@@ -0,0 +1,349 @@
+# Kernel with debug info (as if compiled with -g) for check_profile.py. Four compile units:
+#   a.c  main, with inl inlined in to its loop
+#   b.c  helper, whose loop is a lexical block
+#   c.c  unused, and the declaration of inl, which a.c refers to across units
+#   d.c  never, which nothing runs, so the DWARF reader should never read this unit
+# The source lines the .loc directives point at, and how often each thread runs them:
+#   a.c:18  main's prologue                    1 x 2 instructions
+#   a.c:20  for(int i = 0; i < 5; i++)         2 + 6 x 3 + 5 x 3
+#   a.c:22  helper();                          5 x 2
+#   a.c:24  main's epilogue                    1 x 3
+#   b.c:8   int a = 3;                         5 x 1
+#   b.c:10  int x = --a;                       15 x 1
+#   b.c:11  b = x * x;                         15 x 1
+#   b.c:12  } while(a != 0);                   15 x 2
+#   b.c:13  return b;                          5 x 2
+#   c.c:3   return (i + 7) * (i + 7);          5 x 2 (inlined in to main)
+#   c.c:8   int unused() { return 0; }         0
+#   d.c:2   void never() {}                    0
+	.file	"a.c"
+	.file	1 "a.c"
+	.file	2 "b.c"
+	.file	3 "c.c"
+	.file	4 "d.c"
+	REG	$HI
+	REG	$LO
+	REG	$zero
+	REG	$at
+	REG	$1
+	REG	$2
+	REG	$3
+	REG	$4
+	REG	$5
+	REG	$6
+	REG	$7
+	REG	$8
+	REG	$9
+	REG	$10
+	REG	$11
+	REG	$12
+	REG	$13
+	REG	$14
+	REG	$15
+	REG	$16
+	REG	$17
+	REG	$18
+	REG	$19
+	REG	$20
+	REG	$21
+	REG	$22
+	REG	$23
+	REG	$24
+	REG	$25
+	REG	$26
+	REG	$27
+	REG	$gp
+	REG	$sp
+	REG	$fp
+	REG	$ra
+	REG	$f0
+	REG	$f1
+	REG	$f2
+	REG	$f3
+	REG	$f4
+	REG	$f5
+	REG	$f6
+	REG	$f7
+	REG	$f8
+	REG	$f9
+	REG	$f10
+	REG	$f11
+	REG	$f12
+	REG	$f13
+	REG	$f14
+	REG	$f15
+	REG	$f16
+	REG	$f17
+	REG	$f18
+	REG	$f19
+	REG	$f20
+	REG	$f21
+	REG	$f22
+	REG	$f23
+	REG	$f24
+	REG	$f25
+	REG	$f26
+	REG	$f27
+	REG	$f28
+	REG	$f29
+	REG	$f30
+	REG	$f31
+	REG	$fcc0
+
+.TRaX_START_PREAMBLE:
+	xor_m	$zero, $zero, $zero
+	xor_m	$gp, $gp, $gp
+	LOADIMM	$sp, 16000
+	bal	$ra, .TRaX_INIT
+	nop
+.start:
+	bal	$ra, main
+	nop
+	HALT
+.TRaX_END_PREAMBLE:
+	.text
+main:
+	.loc	1 18 0
+	addiu	$sp, $sp, -8
+	sw	$ra, 4($sp)
+	.loc	1 20 0 prologue_end
+	addiu	$16, $zero, 0
+	addiu	$17, $zero, 5
+$BB0_1:
+	slt	$7, $16, $17
+	beq	$7, $zero, $BB0_2
+	nop
+$inl_begin:
+	.loc	3 3 0
+	addiu	$18, $16, 7
+	mul	$18, $18, $18
+$inl_end:
+	.loc	1 22 0
+	bal	$ra, helper
+	nop
+	.loc	1 20 0
+	addiu	$16, $16, 1
+	j	$BB0_1
+	nop
+$BB0_2:
+	.loc	1 24 0
+	lw	$ra, 4($sp)
+	jr	$ra
+	addiu	$sp, $sp, 8
+$main_end:
+helper:
+	.loc	2 8 0
+	addiu	$2, $zero, 3
+$blk_begin:
+	.loc	2 10 0
+	addiu	$2, $2, -1
+	.loc	2 11 0
+	mul	$3, $2, $2
+	.loc	2 12 0
+	bne	$2, $zero, $blk_begin
+	nop
+$blk_end:
+	.loc	2 13 0
+	jr	$ra
+	nop
+$helper_end:
+unused:
+	.loc	3 8 0
+	jr	$ra
+	nop
+$unused_end:
+never:
+	.loc	4 2 0
+	jr	$ra
+	nop
+$never_end:
+	.section	.rodata.str1.1,"aMS",@progbits,1
+$s_a_c:
+	.asciz	"a.c"
+$s_main:
+	.asciz	"main"
+$s_inl:
+	.asciz	"inl"
+$s_b_c:
+	.asciz	"b.c"
+$s_helper:
+	.asciz	"helper"
+$s_x:
+	.asciz	"x"
+$s_int:
+	.asciz	"int"
+$s_c_c:
+	.asciz	"c.c"
+$s_unused:
+	.asciz	"unused"
+$s_d_c:
+	.asciz	"d.c"
+$s_never:
+	.asciz	"never"
+	.section .debug_abbrev
+$section_abbrev:
+	.byte	1
+	.byte	17
+	.byte	1
+	.byte	3
+	.byte	14
+	.byte	17
+	.byte	1
+	.byte	18
+	.byte	1
+	.byte	0
+	.byte	0
+	.byte	2
+	.byte	46
+	.byte	1
+	.byte	3
+	.byte	14
+	.byte	17
+	.byte	1
+	.byte	18
+	.byte	1
+	.byte	0
+	.byte	0
+	.byte	3
+	.byte	11
+	.byte	1
+	.byte	17
+	.byte	1
+	.byte	18
+	.byte	1
+	.byte	0
+	.byte	0
+	.byte	4
+	.byte	52
+	.byte	0
+	.byte	3
+	.byte	14
+	.byte	73
+	.byte	19
+	.byte	0
+	.byte	0
+	.byte	5
+	.byte	36
+	.byte	0
+	.byte	3
+	.byte	14
+	.byte	0
+	.byte	0
+	.byte	6
+	.byte	46
+	.byte	0
+	.byte	71
+	.byte	16
+	.byte	17
+	.byte	1
+	.byte	18
+	.byte	1
+	.byte	0
+	.byte	0
+	.byte	7
+	.byte	46
+	.byte	0
+	.byte	3
+	.byte	14
+	.byte	0
+	.byte	0
+	.byte	8
+	.byte	17
+	.byte	1
+	.byte	3
+	.byte	14
+	.byte	0
+	.byte	0
+	.byte	0
+	.section .debug_info
+$cu0:
+	.4byte	48
+	.2byte	2
+	.4byte	0
+	.byte	4
+$d_cu0:
+	.byte	1
+	.4byte	$s_a_c
+	.4byte	main
+	.4byte	$main_end
+$d_main:
+	.byte	2
+	.4byte	$s_main
+	.4byte	main
+	.4byte	$main_end
+$d_inl:
+	.byte	6
+	.4byte	$d_inldecl
+	.4byte	$inl_begin
+	.4byte	$inl_end
+	.byte	0
+	.byte	0
+$cu1:
+	.4byte	59
+	.2byte	2
+	.4byte	0
+	.byte	4
+$d_cu1:
+	.byte	1
+	.4byte	$s_b_c
+	.4byte	helper
+	.4byte	$helper_end
+$d_int:
+	.byte	5
+	.4byte	$s_int
+$d_helper:
+	.byte	2
+	.4byte	$s_helper
+	.4byte	helper
+	.4byte	$helper_end
+$d_blk:
+	.byte	3
+	.4byte	$blk_begin
+	.4byte	$blk_end
+$d_x:
+	.byte	4
+	.4byte	$s_x
+	.4byte	24
+	.byte	0
+	.byte	0
+	.byte	0
+$cu2:
+	.4byte	40
+	.2byte	2
+	.4byte	0
+	.byte	4
+$d_cu2:
+	.byte	1
+	.4byte	$s_c_c
+	.4byte	unused
+	.4byte	$unused_end
+$d_inldecl:
+	.byte	7
+	.4byte	$s_inl
+$d_unused:
+	.byte	2
+	.4byte	$s_unused
+	.4byte	unused
+	.4byte	$unused_end
+	.byte	0
+	.byte	0
+$cu3:
+	.4byte	35
+	.2byte	2
+	.4byte	0
+	.byte	4
+$d_cu3:
+	.byte	1
+	.4byte	$s_d_c
+	.4byte	never
+	.4byte	$never_end
+$d_never:
+	.byte	2
+	.4byte	$s_never
+	.4byte	never
+	.4byte	$never_end
+	.byte	0
+	.byte	0
+	.section .debug_str
+	.text
+.TRaX_INIT:
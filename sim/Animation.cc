@@ -0,0 +1,93 @@
+#include "Animation.h"
+#include "BVH.h"
+#include "Material.h"
+#include "OBJLoader.h"
+#include "Triangle.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace simtrax;
+
+Animation::Animation(const char* keyframe_list, int _rebuild_frequency)
+{
+  rebuild_frequency = _rebuild_frequency;
+
+  FILE* input = fopen(keyframe_list, "r");
+  printf("loading keyframe list %s\n", keyframe_list);
+  if (!input)
+    {
+      perror("Failed to open keyframe list for reading.\n");
+      exit(1);
+    }
+
+  char line_buf[1024];
+  while (fgets(line_buf, sizeof(line_buf), input))
+    {
+      // strip trailing whitespace/newlines
+      int len = strlen(line_buf);
+      while(len > 0 && (line_buf[len-1] == '\n' || line_buf[len-1] == '\r' ||
+			line_buf[len-1] == ' ' || line_buf[len-1] == '\t'))
+	line_buf[--len] = '\0';
+
+      if(len == 0 || line_buf[0] == '#')
+	continue;
+      keyframes.push_back(std::string(line_buf));
+    }
+  fclose(input);
+
+  if(keyframes.size() == 0)
+    {
+      printf("Error: keyframe list %s contains no OBJ files\n", keyframe_list);
+      exit(1);
+    }
+  printf("%d keyframes\n", (int)keyframes.size());
+}
+
+void Animation::LoadFrame(int frame, BVH* bvh, FourByte* memory)
+{
+  const char* filename = keyframes[frame % keyframes.size()].c_str();
+
+  // Materials are already in memory from the first frame, only the geometry moves
+  std::vector<Triangle*> tris;
+  std::vector<Material*> matls;
+  int scratch_loc = 0;
+  OBJLoader::LoadModel(filename, &tris, &matls, NULL, 0, scratch_loc, 0);
+
+  if((int)tris.size() != bvh->num_tris)
+    {
+      printf("Error: keyframe %s has %d triangles, first frame had %d\n",
+	     filename, (int)tris.size(), bvh->num_tris);
+      exit(1);
+    }
+
+  // Memory slot i holds the triangle originally loaded at index tri_orders[i]. Write it the
+  // way BVH::LoadTriangles did for the first frame, so the layout matches: the Triangle
+  // constructors have already turned p0/p2 in to edges if Triangle::tri_stores_edges is set
+  for(int i = 0; i < bvh->num_tris; i++)
+    {
+      Triangle* t = tris[bvh->tri_orders[i]];
+      int tri_addr = bvh->start_tris + (i*11);
+      int normal_addr = bvh->start_vertex_normals + (i*9);
+      t->object_id = i;
+      t->LoadIntoMemory(tri_addr, INT_MAX, memory);
+      t->LoadVertexNormals(normal_addr, INT_MAX, memory);
+    }
+
+  for(size_t i = 0; i < tris.size(); i++)
+    delete tris[i];
+  for(size_t i = 0; i < matls.size(); i++)
+    delete matls[i];
+
+  if(rebuild_frequency > 0 && frame % rebuild_frequency == 0)
+    {
+      printf("Frame %d: rebuilding BVH\n", frame);
+      bvh->rebuild(memory);
+    }
+  else
+    {
+      printf("Frame %d: refitting BVH\n", frame);
+      bvh->refit(memory);
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef __SIMHWRT_ANIMATION_H_
+#define __SIMHWRT_ANIMATION_H_
+
+#include <vector>
+#include <string>
+#include "FourByte.h"
+
+class BVH;
+
+// Drives multi-frame simulations. Keyframes are a list of OBJ files (one per line) with
+// identical triangle counts. Each frame's vertices are written directly in to the
+// simulator's memory and the BVH is refit (or rebuilt) in place.
+class Animation {
+public:
+  Animation(const char* keyframe_list, int rebuild_frequency);
+
+  // Applies the vertices of keyframe (frame % num keyframes) to memory and updates the BVH
+  void LoadFrame(int frame, BVH* bvh, FourByte* memory);
+
+  std::vector<std::string> keyframes;
+  int rebuild_frequency; // rebuild the BVH every N frames instead of refitting, 0 for never
+};
+
+#endif // __SIMHWRT_ANIMATION_H_
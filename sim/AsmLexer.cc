@@ -0,0 +1,255 @@
+#include "AsmLexer.h"
+#include "Assembler.h"
+#include <boost/regex.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+bool AsmLexer::check_regex = false;
+
+// The character classes used by the expressions. Past the end of the line At() returns
+// '\0', which none of them accept
+static inline char At(const std::string& line, size_t i)
+{
+  return i < line.length() ? line[i] : '\0';
+}
+
+static inline bool IsDigit(char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+// [\.a-zA-Z\$_]
+static inline bool IsSymbolChar(char c)
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.' || c == '$' || c == '_';
+}
+
+// \s
+static inline bool IsSpace(char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// expSeparator
+static inline bool IsSeparator(char c)
+{
+  return c == ' ' || c == '\t' || c == ',';
+}
+
+// Alternatives in the order the expressions list them
+static const char* const dataLiterals[] = {
+  ".byte", ".2byte", ".4byte", ".space", ".ascii", ".asciz", ".globl",
+  ".data", ".previous", ".align", ".type", ".ent", ".frame", ".mask", ".fmask", ".set", ".size", ".end", ".ascii",
+  NULL
+};
+static const char* const ignoredLiterals[] = {
+  ".data", ".previous", ".align", ".type", ".ent", ".frame", ".mask", ".fmask", ".set", ".size", ".end", ".ascii",
+  NULL
+};
+static const char* const sectionLiterals[] = { ".section", ".text", NULL };
+static const char* const mipsLiterals[] = { "%hi", "%lo", "%gp_rel", NULL };
+static const char* const hiLiteral[] = { "%hi", NULL };
+static const char* const loLiteral[] = { "%lo", NULL };
+static const char* const gpRelLiteral[] = { "%gp_rel", NULL };
+static const char* const srcInfoLiteral[] = { ".loc", NULL };
+static const char* const fileLiteral[] = { ".file", NULL };
+static const char* const assignLiteral[] = { "=", NULL };
+static const char* const textLiteral[] = { ".text", NULL };
+static const char* const debugInfoLiteral[] = { ".debug_info", NULL };
+static const char* const debugAbbrevLiteral[] = { ".debug_abbrev", NULL };
+static const char* const ctorsLiteral[] = { ".ctors", NULL };
+
+bool AsmLexer::Search(const std::string& line, LexPattern pattern, LexMatch& m, size_t from)
+{
+  bool found = false;
+  for (size_t pos = from; pos < line.length(); pos++) {
+    int length = MatchAt(line, pos, pattern);
+    if (length >= 0) {
+      m.position = pos;
+      m.text = line.substr(pos, length);
+      found = true;
+      break;
+    }
+  }
+  if (check_regex)
+    CheckRegex(line, pattern, from, found, m);
+  return found;
+}
+
+int AsmLexer::MatchLiterals(const std::string& line, size_t pos, const char* const* literals)
+{
+  for (; *literals; literals++) {
+    size_t length = strlen(*literals);
+    if (line.compare(pos, length, *literals) == 0)
+      return (int)length;
+  }
+  return -1;
+}
+
+// None of the expressions can backtrack in to a different match: each repeated class is
+// followed by something the class doesn't contain, so matching greedily gives the
+// regex's result
+int AsmLexer::MatchAt(const std::string& line, size_t pos, LexPattern pattern)
+{
+  size_t i = pos;
+  int length;
+  switch (pattern) {
+  case LEX_SYMBOL:
+    while (IsDigit(At(line, i)))
+      i++;
+    if (!IsSymbolChar(At(line, i)))
+      return -1;
+    while (IsSymbolChar(At(line, i)) || IsDigit(At(line, i)))
+      i++;
+    return (int)(i - pos);
+
+  case LEX_INT_LITERAL:
+    if ((At(line, i) == '-' || At(line, i) == '|' || At(line, i) == '+') && IsDigit(At(line, i + 1)))
+      i++;
+    if (!IsDigit(At(line, i)))
+      return -1;
+    while (IsDigit(At(line, i)))
+      i++;
+    return (int)(i - pos);
+
+  case LEX_SEPARATED_INT:
+    if (!IsSeparator(At(line, i)))
+      return -1;
+    while (IsSeparator(At(line, i)))
+      i++;
+    if ((length = MatchAt(line, i, LEX_INT_LITERAL)) < 0)
+      return -1;
+    return (int)(i + length - pos);
+
+  case LEX_INT_OFFSET:
+    if ((length = MatchAt(line, i, LEX_SEPARATED_INT)) < 0 || At(line, i + length) != '(')
+      return -1;
+    return length + 1;
+
+  case LEX_ARITHMETIC:
+    if (At(line, i) != ')' || (At(line, i + 1) != '+' && At(line, i + 1) != '-'))
+      return -1;
+    return 2;
+
+  case LEX_MIPS_DIRECTIVE:
+    if ((length = MatchLiterals(line, i, mipsLiterals)) < 0 || At(line, i + length) != '(')
+      return -1;
+    i += length + 1;
+    if ((length = MatchAt(line, i, LEX_SYMBOL)) < 0 || At(line, i + length) != ')')
+      return -1;
+    return (int)(i + length + 1 - pos);
+
+  case LEX_ARG:
+    if ((length = MatchAt(line, i, LEX_MIPS_DIRECTIVE)) >= 0 ||
+        (length = MatchAt(line, i, LEX_INT_OFFSET)) >= 0 ||
+        (length = MatchAt(line, i, LEX_SYMBOL)) >= 0 ||
+        (length = MatchAt(line, i, LEX_INT_LITERAL)) >= 0)
+      return length;
+    return MatchAt(line, i, LEX_ARITHMETIC);
+
+  case LEX_REGISTER:
+    if (line.compare(i, 4, "\tREG") != 0)
+      return -1;
+    i += 4;
+    if (At(line, i) != ' ' && At(line, i) != '\t')
+      return -1;
+    while (At(line, i) == ' ' || At(line, i) == '\t')
+      i++;
+    if ((length = MatchAt(line, i, LEX_SYMBOL)) < 0)
+      return -1;
+    return (int)(i + length - pos);
+
+  case LEX_LABEL:
+    if ((length = MatchAt(line, i, LEX_SYMBOL)) < 0 || At(line, i + length) != ':')
+      return -1;
+    return length + 1;
+
+  case LEX_STRING: {
+    // ".+" is greedy and '.' matches anything, so the string runs to the last quote
+    if (At(line, i) != '\"')
+      return -1;
+    size_t close = line.rfind('\"');
+    if (close < i + 2)
+      return -1;
+    return (int)(close + 1 - pos);
+  }
+
+  case LEX_COMMENT:
+    return At(line, i) == '#' ? (int)(line.length() - pos) : -1;
+  case LEX_NON_SPACE:
+    return IsSpace(At(line, i)) ? -1 : 1;
+  case LEX_NON_NUMERIC:
+    return IsSpace(At(line, i)) || IsDigit(At(line, i)) ? -1 : 1;
+
+  case LEX_DATA:         return MatchLiterals(line, i, dataLiterals);
+  case LEX_IGNORED:      return MatchLiterals(line, i, ignoredLiterals);
+  case LEX_SECTION:      return MatchLiterals(line, i, sectionLiterals);
+  case LEX_HI:           return MatchLiterals(line, i, hiLiteral);
+  case LEX_LO:           return MatchLiterals(line, i, loLiteral);
+  case LEX_GP_REL:       return MatchLiterals(line, i, gpRelLiteral);
+  case LEX_SRC_INFO:     return MatchLiterals(line, i, srcInfoLiteral);
+  case LEX_FILE:         return MatchLiterals(line, i, fileLiteral);
+  case LEX_ASSIGN:       return MatchLiterals(line, i, assignLiteral);
+  case LEX_TEXT:         return MatchLiterals(line, i, textLiteral);
+  case LEX_DEBUG_INFO:   return MatchLiterals(line, i, debugInfoLiteral);
+  case LEX_DEBUG_ABBREV: return MatchLiterals(line, i, debugAbbrevLiteral);
+  case LEX_CTORS:        return MatchLiterals(line, i, ctorsLiteral);
+  }
+  return -1;
+}
+
+// The expression each pattern stands in for
+static std::string Expression(LexPattern pattern)
+{
+  switch (pattern) {
+  case LEX_ARG:            return expArg;
+  case LEX_ARITHMETIC:     return expArithmetic;
+  case LEX_ASSIGN:         return expAssign;
+  case LEX_COMMENT:        return expComment;
+  case LEX_CTORS:          return "\\.ctors";
+  case LEX_DATA:           return expData;
+  case LEX_DEBUG_ABBREV:   return "\\.debug_abbrev";
+  case LEX_DEBUG_INFO:     return "\\.debug_info";
+  case LEX_FILE:           return expFile;
+  case LEX_GP_REL:         return expGpRel;
+  case LEX_HI:             return expHi;
+  case LEX_IGNORED:        return expIgnored;
+  case LEX_INT_LITERAL:    return expIntLiteral;
+  case LEX_INT_OFFSET:     return expIntOffset;
+  case LEX_LABEL:          return expLabel;
+  case LEX_LO:             return expLo;
+  case LEX_MIPS_DIRECTIVE: return expMipsDirective;
+  case LEX_NON_NUMERIC:    return "[\\S\\D]";
+  case LEX_NON_SPACE:      return "\\S";
+  case LEX_REGISTER:       return expRegister;
+  case LEX_SECTION:        return expSection;
+  case LEX_SEPARATED_INT:  return expSeparator + "+" + expIntLiteral;
+  case LEX_SRC_INFO:       return expSrcInfo;
+  case LEX_STRING:         return expString;
+  case LEX_SYMBOL:         return expSymbol;
+  case LEX_TEXT:           return "\\.text";
+  }
+  return "";
+}
+
+void AsmLexer::CheckRegex(const std::string& line, LexPattern pattern, size_t from,
+                          bool found, const LexMatch& m)
+{
+  std::string expression = Expression(pattern);
+  boost::smatch regex_match;
+  // Continuing along a line the way boost::sregex_iterator does
+  bool regex_found = boost::regex_search(line.begin() + from, line.end(), regex_match,
+                                         boost::regex(expression),
+                                         from > 0 ? boost::match_prev_avail : boost::match_default);
+  if (regex_found == found &&
+      (!found || (from + regex_match.position() == m.position && (size_t)regex_match.length() == m.text.length())))
+    return;
+
+  printf("ERROR: assembler lexer disagrees with regex %s from column %d of line:\n%s\n",
+         expression.c_str(), (int)from, line.c_str());
+  printf("lexer: %s, regex: %s\n",
+         found ? ("\"" + m.text + "\"").c_str() : "no match",
+         regex_found ? ("\"" + regex_match.str() + "\"").c_str() : "no match");
+  exit(1);
+}
@@ -0,0 +1,73 @@
+#ifndef _SIMHWRT_ASM_LEXER_H_
+#define _SIMHWRT_ASM_LEXER_H_
+
+// Hand-written matchers for the assembler. Assembler.cc used to compile a boost::regex
+// for every pattern it tried on every line, and again for every instruction argument,
+// which is where nearly all of the time assembling a large kernel went. AsmLexer::Search
+// finds exactly the text the corresponding expression in Assembler.h finds: the leftmost
+// match, with alternatives taken in the order the expression lists them and the same
+// greedy extents. The Assembler's Handle* functions keep their structure and only call
+// Search where they called regex_search, so the Instructions, symbols and data segment
+// they produce are unchanged.
+//
+// With "--check-assembler" every Search also runs the regex it replaces and the
+// simulator stops at the first disagreement, which is how to check the lexer against a
+// kernel that uses more of the llvm_trax dialect than the samples do.
+
+#include <string>
+
+enum LexPattern {
+  LEX_ARG,            // expArg: one instruction/directive argument
+  LEX_ARITHMETIC,     // expArithmetic: ")+" or ")-"
+  LEX_ASSIGN,         // expAssign
+  LEX_COMMENT,        // expComment
+  LEX_CTORS,          // ".ctors" in a .section line
+  LEX_DATA,           // expData: data and ignored directives
+  LEX_DEBUG_ABBREV,   // ".debug_abbrev" in a .section line
+  LEX_DEBUG_INFO,     // ".debug_info" in a .section line
+  LEX_FILE,           // expFile
+  LEX_GP_REL,         // expGpRel
+  LEX_HI,             // expHi
+  LEX_IGNORED,        // expIgnored
+  LEX_INT_LITERAL,    // expIntLiteral
+  LEX_INT_OFFSET,     // expIntOffset: the "-8(" of "-8($sp)"
+  LEX_LABEL,          // expLabel
+  LEX_LO,             // expLo
+  LEX_MIPS_DIRECTIVE, // expMipsDirective: %hi(sym), %lo(sym), %gp_rel(sym)
+  LEX_NON_NUMERIC,    // "[\S\D]", which boost reads as neither whitespace nor a digit
+  LEX_NON_SPACE,      // "\S"
+  LEX_REGISTER,       // expRegister
+  LEX_SECTION,        // expSection
+  LEX_SEPARATED_INT,  // expSeparator + "+" + expIntLiteral
+  LEX_SRC_INFO,       // expSrcInfo
+  LEX_STRING,         // expString
+  LEX_SYMBOL,         // expSymbol
+  LEX_TEXT            // ".text"
+};
+
+// Where a pattern was found. str() mirrors boost::smatch so the Handle* code reads the same
+struct LexMatch
+{
+  size_t position;
+  std::string text;
+  const std::string& str() const { return text; }
+};
+
+class AsmLexer
+{
+public:
+  // Finds the leftmost match of 'pattern' in 'line' starting at 'from'
+  static bool Search(const std::string& line, LexPattern pattern, LexMatch& m, size_t from = 0);
+
+  // Set by --check-assembler
+  static bool check_regex;
+
+private:
+  // Length of the match of 'pattern' starting exactly at 'pos', or -1
+  static int MatchAt(const std::string& line, size_t pos, LexPattern pattern);
+  static int MatchLiterals(const std::string& line, size_t pos, const char* const* literals);
+  static void CheckRegex(const std::string& line, LexPattern pattern, size_t from,
+                         bool found, const LexMatch& m);
+};
+
+#endif // _SIMHWRT_ASM_LEXER_H_
@@ -1,6 +1,6 @@
 #include "Assembler.h"
-//#include <regex>
-#include <boost/regex.hpp>
+#include "ProgramCache.h"
+#include "AsmLexer.h"
 #include <iostream>
 #include <stdio.h>
 #include <fstream>
@@ -12,6 +12,7 @@ int Assembler::num_regs = 1;
 
 //-------------------------------------------------------------------------
 // regex matchers for various assembly items
+// (AsmLexer matches these by hand, --check-assembler compares it to them)
 //-------------------------------------------------------------------------
 
 // Whitespace
@@ -86,6 +87,10 @@ int ascii_table_size;
 
 SourceInfo currentSourceInfo;
 char current_section;
+int labels_typed;
+SymbolIndex regIndex;
+SymbolIndex labelIndex;
+SymbolIndex elfIndex;
 
 int Assembler::LoadAssem(char *filename,
                          std::vector<Instruction*>& instructions,
@@ -96,7 +101,9 @@ int Assembler::LoadAssem(char *filename,
 			 std::vector<std::string>& sourceNames,
 			 std::vector< std::vector< std::string> >& sourceLines,
                          bool print_symbols, bool needs_debug_symbols,
-			 DwarfReader* dwarfReader)
+			 DwarfReader* dwarfReader,
+			 std::vector<symbol*>* text_labels,
+			 const char* cache_dir)
 {
   printf("Loading assembly file %s\n", filename);
 
@@ -106,8 +113,42 @@ int Assembler::LoadAssem(char *filename,
     printf("ERROR: cannot open assembly file %s\n", filename);
     return -1;
   }
+
+  if(cache_dir)
+    {
+      std::vector<symbol*> labels;
+      std::vector<symbol*> elf_vars;
+      std::vector<symbol*> data_table;
+      int end_data;
+      ProgramCacheStream cache(cache_dir, filename, false);
+      jump_table = NULL;
+      if(CacheProgram(cache, instructions, regs, labels, elf_vars, data_table, jump_table,
+		      ascii_literals, sourceNames, sourceLines, end_data))
+	{
+	  printf("Loaded assembled program from %s\n", cache.filename.c_str());
+	  return FinishLoad(regs, labels, elf_vars, data_table, jump_table, end_data,
+			    print_symbols, needs_debug_symbols, dwarfReader, text_labels);
+	}
+      // a partly read cache leaves nothing behind
+      for(size_t i = 0; i < instructions.size(); i++)
+	delete instructions[i];
+      instructions.clear();
+      FreeSymbols(regs);
+      FreeSymbols(labels);
+      FreeSymbols(elf_vars);
+      FreeSymbols(data_table);
+      free(jump_table);
+      jump_table = NULL;
+      ascii_literals.clear();
+      sourceNames.clear();
+      sourceLines.clear();
+    }
   current_section = SECTION_OTHER;
   num_instructions = 0;
+  labels_typed = 0;
+  regIndex = SymbolIndex();
+  labelIndex = SymbolIndex();
+  elfIndex = SymbolIndex();
   jtable_size = 0;
   jtable_ptr = 0;
   debug_start = 0;
@@ -222,7 +263,29 @@ int Assembler::LoadAssem(char *filename,
 
   AddTRaXInitialize(instructions, labels, regs, jump_table, end_data);
 
+  if(cache_dir)
+    {
+      ProgramCacheStream cache(cache_dir, filename, true);
+      if(cache.ok)
+	CacheProgram(cache, instructions, regs, labels, elf_vars, data_table, jump_table,
+		     ascii_literals, sourceNames, sourceLines, end_data);
+    }
+
+  return FinishLoad(regs, labels, elf_vars, data_table, jump_table, end_data,
+		    print_symbols, needs_debug_symbols, dwarfReader, text_labels);
+}
 
+// Symbol output and debug info, for a freshly assembled or a cached program
+int Assembler::FinishLoad(std::vector<symbol*>& regs,
+			  std::vector<symbol*>& labels,
+			  std::vector<symbol*>& elf_vars,
+			  std::vector<symbol*>& data_table,
+			  char* jump_table,
+			  int end_data,
+			  bool print_symbols, bool needs_debug_symbols,
+			  DwarfReader* dwarfReader,
+			  std::vector<symbol*>* text_labels)
+{
   if(print_symbols)
     {
       if(!needs_debug_symbols)
@@ -232,6 +295,13 @@ int Assembler::LoadAssem(char *filename,
     }
   
 
+  if(text_labels)
+    {
+      for(size_t i = 0; i < labels.size(); i++)
+	if(labels[i]->isText)
+	  text_labels->push_back(labels[i]);
+    }
+
   if(needs_debug_symbols)
     {
       dwarfReader->BuildSourceTree(labels, elf_vars, data_table, jump_table, jtable_size, debug_start, debug_end, abbrev_start);
@@ -240,6 +310,66 @@ int Assembler::LoadAssem(char *filename,
   return end_data;
 }
 
+// Writes the assembler's output to the cache, or reads it back. Returns false if the
+// cache could not be read (or written) in full
+bool Assembler::CacheProgram(ProgramCacheStream& cache,
+			     std::vector<Instruction*>& instructions,
+			     std::vector<symbol*>& regs,
+			     std::vector<symbol*>& labels,
+			     std::vector<symbol*>& elf_vars,
+			     std::vector<symbol*>& data_table,
+			     char*& jump_table,
+			     std::vector<std::string>& ascii_literals,
+			     std::vector<std::string>& sourceNames,
+			     std::vector< std::vector< std::string> >& sourceLines,
+			     int& end_data)
+{
+  cache.Value(num_instructions);
+  cache.Value(num_regs);
+  cache.Value(jtable_size);
+  cache.Value(debug_start);
+  cache.Value(debug_end);
+  cache.Value(abbrev_start);
+  cache.Value(end_data);
+  if(!cache.ok || jtable_size < 0 || jtable_size > (1 << 30))
+    return false;
+
+  if(!cache.writing)
+    jump_table = (char*)malloc(jtable_size);
+  cache.Bytes(jump_table, jtable_size);
+
+  uint32_t count = (uint32_t)instructions.size();
+  cache.Value(count);
+  for(uint32_t i = 0; i < count && cache.ok; i++)
+    {
+      Instruction* ins = cache.writing ? instructions[i] : new Instruction(Instruction::NOP, 0, 0, 0, 0);
+      cache.Value(ins->op);
+      cache.Bytes(ins->args, sizeof(ins->args));
+      cache.Value(ins->pc_address);
+      cache.Bytes(ins->depends, sizeof(ins->depends));
+      cache.Value(ins->srcInfo);
+      cache.String(ins->asmLine);
+      cache.Value(ins->lineNum);
+      if(!cache.writing)
+	instructions.push_back(ins);
+      if(ins->op < 0 || ins->op >= Instruction::NUM_OPS)
+	return false;
+    }
+
+  cache.Symbols(regs);
+  cache.Symbols(labels);
+  cache.Symbols(elf_vars);
+  cache.Symbols(data_table);
+  cache.Strings(ascii_literals);
+  cache.Strings(sourceNames);
+  // The sources' lines are read again instead of cached, they can change without the .s
+  if(cache.ok && !cache.writing)
+    for(size_t i = 0; i < sourceNames.size(); i++)
+      AddFileLines(sourceNames[i], sourceLines);
+
+  return cache.ok;
+}
+
 // Parses a single line of assembly
 int Assembler::HandleLine(std::string line,
                           int pass,
@@ -255,13 +385,13 @@ int Assembler::HandleLine(std::string line,
 			  std::vector< std::vector< std::string> >& sourceLines)
 {
 
-  boost::smatch m;
+  LexMatch m;
 
   // First remove any comments 
-  if(boost::regex_search(line, m, boost::regex(expComment)))
+  if(AsmLexer::Search(line, LEX_COMMENT, m))
     {
       
-      if(boost::regex_search(line, m, boost::regex(expString)))
+      if(AsmLexer::Search(line, LEX_STRING, m))
 	{
 	  int openQuote = line.find("\"");
 	  int closeQuote = openQuote + 1;
@@ -282,13 +412,13 @@ int Assembler::HandleLine(std::string line,
 
   // Don't match anything inside strings at top level
   std::string origLine = line;
-  if(boost::regex_search(line, m, boost::regex(expString)))
+  if(AsmLexer::Search(line, LEX_STRING, m))
     {
       line = (line.substr(0, line.find("\"") - 1) + line.substr(line.rfind("\"") + 1));
     }
 
   // Ignore blank lines
-  if(!boost::regex_search(line, m, boost::regex("\\S")))
+  if(!AsmLexer::Search(line, LEX_NON_SPACE, m))
     return 1;
   
   // Constructors section
@@ -298,38 +428,38 @@ int Assembler::HandleLine(std::string line,
   // }  
 
   // Any section
-  if(boost::regex_search(line, m, boost::regex(expSection)))
+  if(AsmLexer::Search(line, LEX_SECTION, m))
     {
       return HandleSection(origLine, pass, labels, regs, elf_vars);
     }  
   
   // Register declaration
-  if(boost::regex_search(line, m, boost::regex(expRegister)))
+  if(AsmLexer::Search(line, LEX_REGISTER, m))
     {
       return HandleRegister(origLine, pass, labels, regs, elf_vars);
     }
   // Label declaration
-  if(boost::regex_search(line, m, boost::regex(expLabel)))
+  if(AsmLexer::Search(line, LEX_LABEL, m))
     {
       return HandleLabel(origLine, pass, labels, regs, elf_vars);
     }
   // Data section item
-  if(boost::regex_search(line, m, boost::regex(expData)))
+  if(AsmLexer::Search(line, LEX_DATA, m))
     {
       return HandleData(origLine, pass, labels, regs, elf_vars, data_table, jump_table);
     }
   // Debug line info
-  if(boost::regex_search(line, m, boost::regex(expSrcInfo)))
+  if(AsmLexer::Search(line, LEX_SRC_INFO, m))
     {
       return HandleSourceInfo(origLine, pass, labels, regs, elf_vars);
     }
   // Debug source file declaration
-  if(boost::regex_search(line, m, boost::regex(expFile)))
+  if(AsmLexer::Search(line, LEX_FILE, m))
     {
       return HandleFileName(origLine, pass, sourceNames, sourceLines);
     }
   // ELF assignment
-  if(boost::regex_search(line, m, boost::regex(expAssign)))
+  if(AsmLexer::Search(line, LEX_ASSIGN, m))
     {
       return HandleAssignment(origLine, pass, labels, regs, elf_vars);
     }
@@ -348,17 +478,17 @@ int Assembler::HandleRegister(std::string line, int pass, std::vector<symbol*>&
   // Since "REG" is contained in expSymbol, must strip it out
   std::string stripped = line.substr(line.find("REG") + 3);
 
-  boost::smatch m;  
-  if(!boost::regex_search(stripped, m, boost::regex(expSymbol)))
+  LexMatch m;  
+  if(!AsmLexer::Search(stripped, LEX_SYMBOL, m))
     {
       printf("ERROR: invalid register declaration\n");
       return 0;
     }
  
   // check for duplicates
-  if(HasSymbol(m.str(), labels) >= 0 || 
-     HasSymbol(m.str(), regs) >= 0 || 
-     HasSymbol(m.str(), elf_vars) >= 0)
+  if(FindSymbol(m.str(), labels, labelIndex) >= 0 || 
+     FindSymbol(m.str(), regs, regIndex) >= 0 || 
+     FindSymbol(m.str(), elf_vars, elfIndex) >= 0)
     {
       printf("ERROR: symbol %s previously declared\n", m.str().c_str());
       return 0;
@@ -391,17 +521,17 @@ int Assembler::HandleLabel(std::string line, int pass, std::vector<symbol*>& lab
 
 
   // First get the name of the label
-  boost::smatch m;  
-  if(!boost::regex_search(line, m, boost::regex(expSymbol)))
+  LexMatch m;  
+  if(!AsmLexer::Search(line, LEX_SYMBOL, m))
     {
       printf("ERROR: invalid label declaration\n");
       return 0;
     }
   
   // check for duplicates
-  if(HasSymbol(m.str(), labels) >= 0 || 
-     HasSymbol(m.str(), regs) >= 0 || 
-     HasSymbol(m.str(), elf_vars) >= 0)
+  if(FindSymbol(m.str(), labels, labelIndex) >= 0 || 
+     FindSymbol(m.str(), regs, regIndex) >= 0 || 
+     FindSymbol(m.str(), elf_vars, elfIndex) >= 0)
     {
       printf("ERROR: Symbol %s previously declared\n", m.str().c_str());
       return 0;
@@ -454,8 +584,8 @@ int Assembler::HandleData(std::string line, int pass, std::vector<symbol*>& labe
 			  char*& jump_table)
 {
 
-  boost::smatch m;
-  boost::regex_search(line, m, boost::regex(expData));
+  LexMatch m;
+  AsmLexer::Search(line, LEX_DATA, m);
   
   // 1st pass: update the label associated with this declaration if necessary
   if(pass == 1) 
@@ -484,7 +614,7 @@ int Assembler::HandleData(std::string line, int pass, std::vector<symbol*>& labe
 	 m.str().compare(".ascii") == 0)
 	{
 	  bool terminated = (m.str().compare(".asciz") == 0);
-	  if(!boost::regex_search(line, m, boost::regex(expString)))
+	  if(!AsmLexer::Search(line, LEX_STRING, m))
 	    {
 	      printf("ERROR: Found .asci data item without a valid string\n");
 	      return 0;
@@ -503,14 +633,14 @@ int Assembler::HandleData(std::string line, int pass, std::vector<symbol*>& labe
 	{
 	  std::string stripped = line.substr(line.find(m.str()) + m.str().length());
 	  int args[4];
-	  boost::smatch exp;
+	  LexMatch exp;
 	  // 2 pass assembler can only handle immediate integers for declaring .space
-	  if(!boost::regex_search(stripped, exp, boost::regex(expSeparator + "+" + expIntLiteral)))
+	  if(!AsmLexer::Search(stripped, LEX_SEPARATED_INT, exp))
 	    {
 	      printf("ERROR: Unknown size for .space allocation\n");
 	      return 0;
 	    }
-	  if(!GetArgs(stripped, args, labels, regs, elf_vars, expArg) ||
+	  if(!GetArgs(stripped, args, labels, regs, elf_vars) ||
 	     args[1] != 0 || // can only have one argument for data entries
 	     args[2] != 0 ||
 	     args[3] != 0)
@@ -546,7 +676,7 @@ int Assembler::HandleData(std::string line, int pass, std::vector<symbol*>& labe
 	{
 	  bool terminated = (m.str().compare(".asciz") == 0);
 	  
-	  boost::regex_search(stripped, m, boost::regex(expString));
+	  AsmLexer::Search(stripped, LEX_STRING, m);
 	  // Remove quotes
 	  std::string noQuotes = EscapedToAscii(m.str().substr(1, m.str().length() - 2));
 	  
@@ -561,12 +691,12 @@ int Assembler::HandleData(std::string line, int pass, std::vector<symbol*>& labe
       else // non-string
 	{
 	  int args[4];
-	  boost::smatch ign;
-	  if(boost::regex_search(m.str(), ign, boost::regex(expIgnored)))
+	  LexMatch ign;
+	  if(AsmLexer::Search(m.str(), LEX_IGNORED, ign))
 	    args[0] = 0;
 	  else
 	    {
-	      if(!GetArgs(stripped, args, labels, regs, elf_vars, expArg) ||
+	      if(!GetArgs(stripped, args, labels, regs, elf_vars) ||
 		 args[1] != 0 || // can only have one argument for data entries
 		 args[2] != 0 ||
 		 args[3] != 0)
@@ -580,7 +710,7 @@ int Assembler::HandleData(std::string line, int pass, std::vector<symbol*>& labe
 	    {
 	      int args[4];
 	      // Error handling is done on 1st pass
-	      GetArgs(stripped, args, labels, regs, elf_vars, expArg);
+	      GetArgs(stripped, args, labels, regs, elf_vars);
 	      for(int i=0; i < args[0]; i++)
 		jump_table[jtable_ptr++] = (char)(0);
 	    }
@@ -626,11 +756,13 @@ int Assembler::HandleInstruction(std::string line, int pass, int lineNum, std::v
       if(labels.size() > 0)
 	labels[labels.size()-1]->isText = true;
       // Update previous labels if nothing underneath them
-      for(int i = (int)labels.size() - 2; i >= 0; i--) 
+      // (labels before labels_typed already are, and a label's type never changes back)
+      for(int i = (int)labels.size() - 2; i >= labels_typed; i--) 
 	{
 	  if(!labels[i]->isJumpTable && !labels[i]->isAscii && !labels[i]->isText)
 	    labels[i]->isText = true;
 	}
+      labels_typed = (int)labels.size();
       
       num_instructions++;
       return 1;
@@ -638,8 +770,8 @@ int Assembler::HandleInstruction(std::string line, int pass, int lineNum, std::v
   
   // 2nd pass
   // Get the op code
-  boost::smatch m;
-  if(!boost::regex_search(line, m, boost::regex(expSymbol)))
+  LexMatch m;
+  if(!AsmLexer::Search(line, LEX_SYMBOL, m))
     {
       printf("ERROR: Malformed assembly line\n");
       return 0;
@@ -652,7 +784,7 @@ int Assembler::HandleInstruction(std::string line, int pass, int lineNum, std::v
 	  // Get args, first remove the op from the string
 	  std::string stripped = line.substr(line.find(m.str()) + m.str().length());
 	  int args[4];
-	  if(!GetArgs(stripped, args, labels, regs, elf_vars, expArg))
+	  if(!GetArgs(stripped, args, labels, regs, elf_vars))
 	    {
 	      printf("ERROR: Invalid arguments to op: %s\n", Instruction::Opnames[i].c_str());
 	      return 0;
@@ -687,14 +819,26 @@ symbol* Assembler::MakeSymbol(std::string name)
 }
 
 
+// Deletes symbols and their malloc'ed names, leaving syms empty
+void Assembler::FreeSymbols(std::vector<symbol*>& syms)
+{
+  for(size_t i = 0; i < syms.size(); i++)
+    {
+      for(size_t j = 0; j < syms[i]->names.size(); j++)
+	free(syms[i]->names[j]);
+      delete syms[i];
+    }
+  syms.clear();
+}
+
+
 // Parses/computes assembly arguments and places them in args
 // Arguments can be either to an instruction, or an ELF variable
 int Assembler::GetArgs(std::string line,
                        int* args,
                        std::vector<symbol*>& labels,
                        std::vector<symbol*>& regs,
-                       std::vector<symbol*>& elf_vars,
-		       std::string argMatcher)
+                       std::vector<symbol*>& elf_vars)
 {
 
   for(int i=0; i < 4; i++)
@@ -702,36 +846,34 @@ int Assembler::GetArgs(std::string line,
 
   int argNum = 0;
   int arg;
-  boost::regex args_regex(argMatcher);
-  boost::sregex_iterator it = boost::sregex_iterator(line.begin(), line.end(), args_regex);
-  boost::sregex_iterator end = boost::sregex_iterator();
+  LexMatch m;
+  size_t pos = 0;
 
-  while(it != end)
+  while(AsmLexer::Search(line, LEX_ARG, m, pos))
     {
-      // Consume operators and collapse result in to one argument
+      pos = m.position + m.str().length();
 
-      // Using another regex search here to check if expArithmetic is matched seems to corrupt the result
-      // Check if expArithmetic is matched manually
-      if((it->str().compare(")+") == 0) || (it->str().compare(")-") == 0))
+      // Consume operators and collapse result in to one argument
+      if((m.str().compare(")+") == 0) || (m.str().compare(")-") == 0))
 	{
-	  std::string cpy(it->str());
-	  it++;
+	  std::string cpy(m.str());
 	  argNum--;
-	  if(!HandleArg(it->str(), labels, regs, elf_vars, arg))
+	  if(!AsmLexer::Search(line, LEX_ARG, m, pos) ||
+	     !HandleArg(m.str(), labels, regs, elf_vars, arg))
 	    return 0;
+	  pos = m.position + m.str().length();
 	  if((cpy.compare(")+") == 0))
 	    args[argNum] += arg;
 	  else if(cpy.compare(")-") == 0)
 	    args[argNum] -= arg;
 	}
       // Otherwise, it's a standalone argument
-      else if(HandleArg(it->str(), labels, regs, elf_vars, arg))
+      else if(HandleArg(m.str(), labels, regs, elf_vars, arg))
 	{
 	  args[argNum] = arg;
 	}
       else
 	return 0;
-      it++;
       argNum++;
     }
 
@@ -748,23 +890,23 @@ int Assembler::HandleArg(std::string arg,
 			 int &retVal)
 {
   
-  boost::smatch m;  
+  LexMatch m;  
   // Mips directives
-  if(boost::regex_search(arg, m, boost::regex(expMipsDirective)))
+  if(AsmLexer::Search(arg, LEX_MIPS_DIRECTIVE, m))
     {
       return HandleMipsDirective(arg, labels, regs, elf_vars, retVal);
     }
 
   // Symbols (must contain a non-digit)
-  if(boost::regex_search(arg, m, boost::regex(expSymbol)))
+  if(AsmLexer::Search(arg, LEX_SYMBOL, m))
     {
       int symbolIndex;
       symbol* symb = NULL;
-      if((symbolIndex = HasSymbol(m.str(), regs)) >= 0)
+      if((symbolIndex = FindSymbol(m.str(), regs, regIndex)) >= 0)
 	symb = regs[symbolIndex];
-      if((symbolIndex = HasSymbol(m.str(), labels)) >= 0)
+      if((symbolIndex = FindSymbol(m.str(), labels, labelIndex)) >= 0)
 	symb = labels[symbolIndex];
-      if((symbolIndex = HasSymbol(m.str(), elf_vars)) >= 0)
+      if((symbolIndex = FindSymbol(m.str(), elf_vars, elfIndex)) >= 0)
 	{
 	  symb = elf_vars[symbolIndex];
 	}
@@ -780,7 +922,7 @@ int Assembler::HandleArg(std::string arg,
     }
 
   // Integer literals
-  if(boost::regex_search(arg, m, boost::regex(expIntLiteral)))
+  if(AsmLexer::Search(arg, LEX_INT_LITERAL, m))
     {
       retVal = atoi(m.str().c_str());
       return 1;
@@ -798,10 +940,10 @@ int Assembler::HandleMipsDirective(std::string arg,
 				   std::vector<symbol*>& elf_vars,
 				   int &retVal)
 {
-  boost::smatch dirType;
-  if(!boost::regex_search(arg, dirType, boost::regex(expHi)))
-    if(!boost::regex_search(arg, dirType, boost::regex(expLo)))
-      if(!boost::regex_search(arg, dirType, boost::regex(expGpRel)))
+  LexMatch dirType;
+  if(!AsmLexer::Search(arg, LEX_HI, dirType))
+    if(!AsmLexer::Search(arg, LEX_LO, dirType))
+      if(!AsmLexer::Search(arg, LEX_GP_REL, dirType))
 	{
 	  printf("ERROR: Unknown MIPS directive\n");
 	  return 0;
@@ -811,15 +953,15 @@ int Assembler::HandleMipsDirective(std::string arg,
   std::string stripped = arg.substr(arg.find(dirType.str()) + dirType.str().length());
 
   // Get the argument name
-  boost::smatch m;
-  if(!boost::regex_search(stripped, m, boost::regex(expArg)))
+  LexMatch m;
+  if(!AsmLexer::Search(stripped, LEX_ARG, m))
     {
       printf("ERROR: Invalid argument to mips directive\n");
       return 0;
     }    
 
   // Can't have registers in mips directives
-  if(HasSymbol(m.str(), regs) >= 0)
+  if(FindSymbol(m.str(), regs, regIndex) >= 0)
     {
       printf("ERROR: Found register argument in MIPS directive\n");
       return 0;
@@ -827,7 +969,7 @@ int Assembler::HandleMipsDirective(std::string arg,
 
   // Get the argument value
   int args[4];
-  if(!GetArgs(m.str(), args, labels, regs, elf_vars, expArg) ||
+  if(!GetArgs(m.str(), args, labels, regs, elf_vars) ||
      args[1] != 0 || // can only have one argument for directives
      args[2] != 0 ||
      args[3] != 0)
@@ -836,7 +978,7 @@ int Assembler::HandleMipsDirective(std::string arg,
       return 0;
     }
   
-  int labelNum = HasSymbol(m.str(), labels);
+  int labelNum = FindSymbol(m.str(), labels, labelIndex);
   if(labelNum >= 0)
     {
       // Compiler should never try to take the upper/lower half of a PC address
@@ -871,19 +1013,19 @@ int Assembler::HandleSourceInfo(std::string line, int pass,
     return 1;
   
   // Strip out ".loc"
-  boost::smatch m;  
-  boost::regex_search(line, m, boost::regex(expSrcInfo));
+  LexMatch m;  
+  AsmLexer::Search(line, LEX_SRC_INFO, m);
   std::string stripped = line.substr(line.find(m.str()) + m.str().length());
 
   // Strip out non-digits (such as "prologue_end")
-  if(boost::regex_search(stripped, m, boost::regex("[\\S\\D]")))
+  if(AsmLexer::Search(stripped, LEX_NON_NUMERIC, m))
     {
       stripped = stripped.substr(0, stripped.find(m.str()));
     }
     
 
   int args[4];
-  if(!GetArgs(stripped, args, labels, regs, elf_vars, expArg))
+  if(!GetArgs(stripped, args, labels, regs, elf_vars))
     {
       printf("ERROR: Invalid source line info (compiled with -g)\n");
       return 0;
@@ -906,16 +1048,16 @@ int Assembler::HandleFileName(std::string line, int pass, std::vector<std::strin
     return 1;
 
   // Strip out the ".file"
-  boost::smatch m;  
-  boost::regex_search(line, m, boost::regex(expFile));
+  LexMatch m;  
+  AsmLexer::Search(line, LEX_FILE, m);
   std::string stripped = line.substr(line.find(m.str()) + m.str().length());
   
   // Strip out file number (implied by order of appearance)
-  if(boost::regex_search(stripped, m, boost::regex(expIntOffset)))
+  if(AsmLexer::Search(stripped, LEX_INT_OFFSET, m))
     stripped = stripped.substr(stripped.find(m.str()) + m.str().length());
 
   // Get the file name
-  if(!boost::regex_search(stripped, m, boost::regex(expString)))
+  if(!AsmLexer::Search(stripped, LEX_STRING, m))
     {
       printf("ERROR: Invalid file name declaration (compiled with -g)\n");
       return 0;
@@ -939,13 +1081,13 @@ int Assembler::HandleAssignment(std::string line, int pass,
   // 1st pass: make an entry for it
   if(pass == 1)
     {
-      boost::smatch m;  
-      boost::regex_search(line, m, boost::regex(expSymbol));
+      LexMatch m;  
+      AsmLexer::Search(line, LEX_SYMBOL, m);
 
       // check for duplicates
-      if(HasSymbol(m.str(), labels) >= 0 || 
-	 HasSymbol(m.str(), regs) >= 0 || 
-	 HasSymbol(m.str(), elf_vars) >= 0)
+      if(FindSymbol(m.str(), labels, labelIndex) >= 0 || 
+	 FindSymbol(m.str(), regs, regIndex) >= 0 || 
+	 FindSymbol(m.str(), elf_vars, elfIndex) >= 0)
 	{
 	  printf("ERROR: Symbol %s previously declared\n", m.str().c_str());
 	  return 0;
@@ -964,11 +1106,11 @@ int Assembler::HandleAssignment(std::string line, int pass,
   if(pass == -1)
     {
       // Strip out the symbol name
-      boost::smatch m;  
-      boost::regex_search(line, m, boost::regex(expSymbol));
+      LexMatch m;  
+      AsmLexer::Search(line, LEX_SYMBOL, m);
       std::string stripped = line.substr(line.find(m.str()) + m.str().length());
       
-      int varID = HasSymbol(m.str(), elf_vars);
+      int varID = FindSymbol(m.str(), elf_vars, elfIndex);
       if(varID < 0)
 	{
 	  printf("ERROR: 2nd pass couldn't find ELF assignment symbol: %s\n", m.str().c_str());
@@ -978,7 +1120,7 @@ int Assembler::HandleAssignment(std::string line, int pass,
       // Get the argument value
       int args[4];
       // expAssignArg includes '+'/'-' in the argument matcher, GetArgs will handle them
-      if(!GetArgs(stripped, args, labels, regs, elf_vars, expArg) ||
+      if(!GetArgs(stripped, args, labels, regs, elf_vars) ||
 	 args[1] != 0 || // can only have one argument for assignments (the assigned value)
 	 args[2] != 0 ||
 	 args[3] != 0)
@@ -1019,17 +1161,17 @@ int Assembler::HandleSection(std::string line, int pass, std::vector<symbol*>& l
   if(current_section == SECTION_DEBUG)
     debug_end = jtable_size;
 
-  boost::smatch m;
+  LexMatch m;
 
   // text section
-  if(boost::regex_search(line, m, boost::regex(std::string( "\\.text" ))))
+  if(AsmLexer::Search(line, LEX_TEXT, m))
     {
       current_section = SECTION_OTHER;
       return 1;
     }
 
   // Start of debug section
-  if(boost::regex_search(line, m, boost::regex(std::string( "\\.debug_info" ))))
+  if(AsmLexer::Search(line, LEX_DEBUG_INFO, m))
     {
       current_section = SECTION_DEBUG;
       debug_start = jtable_size;
@@ -1037,7 +1179,7 @@ int Assembler::HandleSection(std::string line, int pass, std::vector<symbol*>& l
     }
 
   // Start of debug abbreviations
-  if(boost::regex_search(line, m, boost::regex(std::string( "\\.debug_abbrev" ))))
+  if(AsmLexer::Search(line, LEX_DEBUG_ABBREV, m))
     {
       current_section = SECTION_DATA;
       abbrev_start = jtable_size;
@@ -1048,7 +1190,7 @@ int Assembler::HandleSection(std::string line, int pass, std::vector<symbol*>& l
   current_section = SECTION_OTHER;
 
   // Constructors section
-  if(boost::regex_search(line, m, boost::regex(std::string( "\\.ctors" ))))
+  if(AsmLexer::Search(line, LEX_CTORS, m))
     {
       return HandleConstructors(line, pass, labels, regs, elf_vars);
     }
@@ -1135,6 +1277,22 @@ int Assembler::HasSymbol(std::string name, const std::vector<symbol*>& syms)
 }
 
 
+// Same result as HasSymbol, for the vectors the assembler builds. Those only grow, so the
+// index picks up whatever was added since the last lookup
+int Assembler::FindSymbol(const std::string& name, const std::vector<symbol*>& syms, SymbolIndex& index)
+{
+  if(index.indexed > syms.size())
+    index = SymbolIndex();
+  for(; index.indexed < syms.size(); index.indexed++)
+    for(size_t j = 0; j < syms[index.indexed]->names.size(); j++)
+      // insert() keeps the first symbol with a name, as HasSymbol's scan finds it first
+      index.names.insert(std::make_pair(std::string(syms[index.indexed]->names[j]), (int)index.indexed));
+
+  std::map<std::string, int>::const_iterator it = index.names.find(name);
+  return it == index.names.end() ? -1 : it->second;
+}
+
+
 // Adds instructions that the compiler doesn't generate.
 // Namely, branches to global constructors followed by a brach to main
 void Assembler::AddTRaXInitialize(std::vector<Instruction*>& instructions,
@@ -1149,7 +1307,7 @@ void Assembler::AddTRaXInitialize(std::vector<Instruction*>& instructions,
   SourceInfo tmpSrcInfo;
 
   // Create branches to global constructors
-  int ctorsLabelID = HasSymbol(".ctors", labels);
+  int ctorsLabelID = FindSymbol(".ctors", labels, labelIndex);
   if(ctorsLabelID >= 0)
     {
       int startCtors = labels[ctorsLabelID]->address;
@@ -1187,7 +1345,7 @@ void Assembler::AddTRaXInitialize(std::vector<Instruction*>& instructions,
     }
 
   // Return to the preamble created by the linker
-  int startID = HasSymbol(".start", labels);
+  int startID = FindSymbol(".start", labels, labelIndex);
   if(startID < 0)
     {
       printf("ERROR: Assembler found no .start label\n");
@@ -1,5 +1,7 @@
 #ifndef __SIMHWRT_ASSEMBLER_H_
 #define __SIMHWRT_ASSEMBLER_H_
+#include <map>
+#include <string>
 #include <vector>
 #include <stdio.h>
 #include <string.h>
@@ -8,6 +10,7 @@
 #include "DwarfReader.h"
 
 class DwarfReader;
+class ProgramCacheStream;
 
 // A label or register name
 struct symbol
@@ -25,6 +28,19 @@ symbol() :
 };
 
 
+// Name to position in a symbol vector. Argument lookups used to scan every label with
+// HasSymbol, which made assembling quadratic in the number of labels
+struct SymbolIndex
+{
+  std::map<std::string, int> names;
+  size_t indexed; // symbols of the vector added so far
+
+SymbolIndex() :
+  indexed(0)
+  {}
+};
+
+
 class Assembler
 {
  public:
@@ -33,11 +49,26 @@ class Assembler
 		       std::vector<symbol*>& regs, int num_system_regs, char*& jump_table, 
 		       std::vector<std::string>& ascii_literals, std::vector<std::string>& sourceNames, 
 		       std::vector< std::vector< std::string > >& sourceLines,
-		       bool print_symbols, bool needs_debug_symbols, DwarfReader* dwarfReader);
+		       bool print_symbols, bool needs_debug_symbols, DwarfReader* dwarfReader,
+		       std::vector<symbol*>* text_labels = NULL, const char* cache_dir = NULL);
 
   static int HasSymbol(std::string, const std::vector<symbol*>& syms);  
   
  private:
+  static int FindSymbol(const std::string& name, const std::vector<symbol*>& syms, SymbolIndex& index);
+
+  static int FinishLoad(std::vector<symbol*>& regs, std::vector<symbol*>& labels,
+			std::vector<symbol*>& elf_vars, std::vector<symbol*>& data_table,
+			char* jump_table, int end_data, bool print_symbols, bool needs_debug_symbols,
+			DwarfReader* dwarfReader, std::vector<symbol*>* text_labels);
+
+  static bool CacheProgram(ProgramCacheStream& cache, std::vector<Instruction*>& instructions,
+			   std::vector<symbol*>& regs, std::vector<symbol*>& labels,
+			   std::vector<symbol*>& elf_vars, std::vector<symbol*>& data_table,
+			   char*& jump_table, std::vector<std::string>& ascii_literals,
+			   std::vector<std::string>& sourceNames,
+			   std::vector< std::vector< std::string > >& sourceLines, int& end_data);
+
   static int HandleLine(std::string line, int pass, int lineNum, std::vector<Instruction*>& instructions, 
 			std::vector<symbol*>& labels, std::vector<symbol*>& regs, 
 			std::vector<symbol*>& elf_vars, std::vector<symbol*>& data_table, 
@@ -91,10 +122,10 @@ class Assembler
 			   std::vector<symbol*>& regs, std::vector<symbol*>& elf_vars);
     
   static symbol* MakeSymbol(std::string name);
+  static void FreeSymbols(std::vector<symbol*>& syms);
 
   static int GetArgs(std::string line, int* args, std::vector<symbol*>& labels, 
-		     std::vector<symbol*>& regs, std::vector<symbol*>& elf_vars, 
-		     std::string argMatcher);
+		     std::vector<symbol*>& regs, std::vector<symbol*>& elf_vars);
 
 
   static void AddTRaXInitialize(std::vector<Instruction*>& instructions,
@@ -122,8 +122,10 @@ BVH::~BVH()
 }
 
 BVH::BVH(std::vector<Triangle*>* _triangles, int _subtree_size, bool duplicate, bool tris_store_edges, 
-	 bool pack_split_axis, bool _pack_stream_boundaries, bool _store_parent_pointers) {
+	 bool pack_split_axis, bool _pack_stream_boundaries, bool _store_parent_pointers,
+	 int _layout_line_size) {
   subtree_size = _subtree_size;
+  layout_line_size = _layout_line_size;
 
   // TODO: Add a separate command line option for this. For now, just use the same size as the node treelets
   triangle_subtree_size = _subtree_size;
@@ -168,6 +170,18 @@ BVH::BVH(std::vector<Triangle*>* _triangles, int _subtree_size, bool duplicate,
       assignTriangleSubtrees();
       printf("assigned %d total subtrees\n", num_subtrees);
     }
+
+  // Pack sibling pairs in to cache lines by SAH probability (only for the plain 8-word node format)
+  if(layout_line_size > 0)
+    {
+      if(subtree_size > 0)
+	{
+	  printf("Cache line layout is not supported with treelets (--subtree-size), skipping\n");
+	  layout_line_size = 0;
+	}
+      else
+	layoutCacheLines(layout_line_size);
+    }
 }
 
 
@@ -183,7 +197,7 @@ void BVH::LoadIntoMemory(int &memory_position,
 
   // align the BVH to cache line boundaries (root node starts mid-line, so that children are cache line-aligned)
   // want root node to be 8-word aligned and first child to be 32-word aligned
-  memory_position = memory_position + (8 - (memory_position % 8));
+  memory_position = alignForLayout(memory_position);
 
   // load the first copy
   start_nodes = memory_position;
@@ -198,7 +212,7 @@ void BVH::LoadIntoMemory(int &memory_position,
   // load the second copy (if necessary, for animations)
   if(duplicate_BVH)
     {
-      memory_position = memory_position + (8 - (memory_position % 8)); // cache alignment
+      memory_position = alignForLayout(memory_position); // cache alignment
       start_secondary_nodes = memory_position;
       LoadNodes(memory_position, max_memory, memory, start_secondary_nodes);
       start_secondary_tris = memory_position;
@@ -544,6 +558,143 @@ void BVH::reorderNodes()
 
 }
 
+// Chooses the start of the node array. Without a cache line layout, nodes are 8-word aligned.
+// With one, the root is placed at the end of a line so that every sibling pair starts on a line boundary.
+int BVH::alignForLayout(int memory_position)
+{
+  if(layout_line_size <= 0)
+    return memory_position + (8 - (memory_position % 8));
+
+  const int line_words = 1 << layout_line_size;
+  const int node_words = 8;
+  int aligned = memory_position + (line_words - (memory_position % line_words)); 
+  aligned -= node_words;
+  if(aligned < memory_position)
+    aligned += line_words;
+  return aligned;
+}
+
+// Expected number of distinct cache lines a ray that hits the root touches while fetching nodes.
+// Uses the SAH assumption that a ray visiting a node visits its children with probability 
+// proportional to their surface area. A sibling pair is fetched whenever its parent is visited,
+// and costs a line whenever it doesn't share a line with the parent (or straddles two lines).
+// Assumes the layout used by alignForLayout (root at the end of a line).
+float BVH::expectedLinesTouched(int lineSize)
+{
+  const int line_words = 1 << lineSize;
+  const int node_words = 8;
+  const int offset = line_words - node_words;
+  float root_area = nodes[0].area();
+  if(root_area <= 0.f)
+    root_area = 1.f;
+
+  float lines = 1.f; // the root's line
+  for(int i = 0; i < num_nodes; i++)
+    {
+      if(nodes[i].isLeaf())
+	continue;
+      int parent_line = (offset + i * node_words) / line_words;
+      int left_line = (offset + nodes[i].start_child * node_words) / line_words;
+      int right_line = (offset + (nodes[i].start_child + 1) * node_words) / line_words;
+      float probability = nodes[i].area() / root_area;
+      if(left_line != parent_line)
+	lines += probability;
+      if(right_line != left_line)
+	lines += probability;
+    }
+  return lines;
+}
+
+// Rearranges nodes so that hot parts of the tree share cache lines.
+// Sibling pairs are the unit of placement (children are always fetched together).
+// Each line is filled greedily: start with the most probable unplaced pair, then keep adding
+// the most probable child pair of anything already in the line until it is full.
+// Pairs that don't fit go back to the global queue and seed later lines.
+void BVH::layoutCacheLines(int lineSize)
+{
+  const int line_words = 1 << lineSize;
+  const int node_words = 8;
+  if(line_words % (2 * node_words) != 0)
+    {
+      printf("Cache line layout requires lines to hold whole sibling pairs (%d-word lines, %d-word nodes), skipping\n",
+	     line_words, node_words);
+      layout_line_size = 0;
+      return;
+    }
+  const int pairs_per_line = line_words / (2 * node_words);
+  float before = expectedLinesTouched(lineSize);
+
+  float root_area = nodes[0].area();
+  if(root_area <= 0.f)
+    root_area = 1.f;
+
+  // (probability of fetching the pair, ID of its left child)
+  typedef std::pair<float, int> PairEntry;
+  std::priority_queue<PairEntry> global_q;
+  std::vector<int> order;
+  order.reserve(num_nodes);
+  order.push_back(0);
+  if(!nodes[0].isLeaf())
+    global_q.push(PairEntry(1.f, nodes[0].start_child));
+
+  while(!global_q.empty())
+    {
+      std::priority_queue<PairEntry> line_q;
+      int free_pairs = pairs_per_line;
+      while(free_pairs > 0 && (!line_q.empty() || !global_q.empty()))
+	{
+	  if(line_q.empty())
+	    {
+	      line_q.push(global_q.top());
+	      global_q.pop();
+	    }
+	  int left = line_q.top().second;
+	  line_q.pop();
+	  order.push_back(left);
+	  order.push_back(left + 1);
+	  free_pairs--;
+	  for(int c = left; c <= left + 1; c++)
+	    if(!nodes[c].isLeaf())
+	      line_q.push(PairEntry(nodes[c].area() / root_area, nodes[c].start_child));
+	}
+      // Whatever didn't fit in this line competes for the next ones
+      while(!line_q.empty())
+	{
+	  global_q.push(line_q.top());
+	  line_q.pop();
+	}
+    }
+
+  if((int)order.size() != num_nodes)
+    {
+      printf("Error: cache line layout placed %d of %d nodes, skipping\n", (int)order.size(), num_nodes);
+      layout_line_size = 0;
+      return;
+    }
+
+  std::vector<int> new_ids(num_nodes);
+  for(int i = 0; i < num_nodes; i++)
+    new_ids[order[i]] = i;
+
+  // Keep the full capacity so that rebuild() can still build in to this array
+  BVHNode* reordered = new BVHNode[2 * num_tris];
+  for(int i = 0; i < num_nodes; i++)
+    {
+      reordered[i] = nodes[order[i]];
+      if(!reordered[i].isLeaf())
+	reordered[i].start_child = new_ids[reordered[i].start_child];
+      if(reordered[i].parent >= 0)
+	reordered[i].parent = new_ids[reordered[i].parent];
+    }
+
+  delete[] nodes;
+  nodes = reordered;
+
+  float after = expectedLinesTouched(lineSize);
+  printf("BVH cache line layout: %d-word lines, %d sibling pairs per line\n", line_words, pairs_per_line);
+  printf("BVH expected cache lines touched per traversal: %f (before layout %f)\n", after, before);
+}
+
 
 float BoxArea(const float box_min[3], const float box_max[3]) {
   float dx = box_max[0] - box_min[0];
@@ -828,7 +979,9 @@ int partitionObjectMedian(int tri_begin, int tri_end, int bestAxis) {
 
 }
 
-void BVH::rebuild(FourByte *memory)
+// Replaces the host-side triangles with the ones currently in the simulator's memory,
+// in memory (inorder) order. Each keeps its original object ID so tri_orders stays valid.
+void BVH::reloadTriangles(FourByte *memory)
 {
   // delete and remove the old triangles
   for(size_t i = 0; i < triangles->size(); i++)
@@ -841,8 +994,39 @@ void BVH::rebuild(FourByte *memory)
   for(int i = 0; i < num_tris; i++)
     {
       Triangle t = loadTriangle(start_tris + (i*11), memory);
+      t.object_id = tri_orders[i];
+      t.shader_id = memory[start_tris + (i*11) + 10].ivalue;
+      for(int j = 0; j < 3; j++)
+	{
+	  t.t0[j] = memory[start_tex_coords + (i*9) + j + 0].fvalue;
+	  t.t1[j] = memory[start_tex_coords + (i*9) + j + 3].fvalue;
+	  t.t2[j] = memory[start_tex_coords + (i*9) + j + 6].fvalue;
+	  t.n0[j] = memory[start_vertex_normals + (i*9) + j + 0].fvalue;
+	  t.n1[j] = memory[start_vertex_normals + (i*9) + j + 3].fvalue;
+	  t.n2[j] = memory[start_vertex_normals + (i*9) + j + 6].fvalue;
+	}
       triangles->push_back(new Triangle(t));
     }
+}
+
+// Recomputes the node bounds for the triangles currently in memory, keeping the tree topology.
+// Much cheaper than rebuild(), but the tree quality degrades as the geometry deforms.
+void BVH::refit(FourByte *memory)
+{
+  reloadTriangles(memory);
+  // triangles were reloaded in inorder, so leaf ranges still index them directly
+  inorder_tris = *triangles;
+  updateBounds(0);
+  oldComputeNodeCost(0);
+
+  int memory_position = start_nodes;
+  LoadNodes(memory_position, INT_MAX, memory, start_nodes);
+}
+
+void BVH::rebuild(FourByte *memory)
+{
+  reloadTriangles(memory);
+  tri_orders.clear();
   
   int nextFree = 1;
   num_nodes = 0;
@@ -850,6 +1034,8 @@ void BVH::rebuild(FourByte *memory)
   updateBounds(0);
   computeSubtreeSize(0);
   oldComputeNodeCost(0);
+  if(layout_line_size > 0)
+    layoutCacheLines(layout_line_size);
 
   int memory_position = start_nodes;
   LoadNodes(memory_position, INT_MAX, memory, start_nodes);
@@ -17,7 +17,8 @@ class BVH : public simtrax::Primitive {
 public:
   ~BVH();
   BVH(std::vector<simtrax::Triangle*>* triangles, int _subtree_size, bool duplicate, 
-      bool tris_store_edges, bool pack_split_axis, bool _pack_stream_boundaries, bool _store_parent_pointers);
+      bool tris_store_edges, bool pack_split_axis, bool _pack_stream_boundaries, bool _store_parent_pointers,
+      int _layout_line_size = 0);
 
   void LoadIntoMemory(int &memory_position,
                       int max_memory,
@@ -51,6 +52,8 @@ public:
   void build(int nodeID, int tri_begin, int tri_end,
              int& nextFree, int depth);
   void rebuild(FourByte *memory);
+  void refit(FourByte *memory);
+  void reloadTriangles(FourByte *memory);
   void updateBounds(int ID);
   int computeSubtreeSize(int node_id);
   int assignSubtrees(int subtreeSize);
@@ -58,6 +61,9 @@ public:
   void assignTriangleSubtrees();
   void assignTriangleSubtreesRecursive(int nodeID, int& remainingSpace);
   void reorderNodes();
+  void layoutCacheLines(int lineSize);
+  float expectedLinesTouched(int lineSize);
+  int alignForLayout(int memory_position);
  
 #if 0
   void rotateNode(int id);
@@ -84,6 +90,7 @@ public:
   int subtree_size;
   int triangle_subtree_size;
   int num_nodes;
+  int layout_line_size;
   float initial_cost;
   bool duplicate_BVH;
   BVHNode* nodes;
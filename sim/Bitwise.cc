@@ -371,6 +371,11 @@ bool Bitwise::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
   return true;
 }
 
+void Bitwise::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void Bitwise::ClockRise()
 {
@@ -372,6 +372,11 @@ bool BranchUnit::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadSt
   return true;
 }
 
+void BranchUnit::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void BranchUnit::ClockRise()
 {
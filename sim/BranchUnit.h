@@ -13,6 +13,7 @@ class BranchUnit : public FunctionalUnit {
   // From FunctionalUnit
   virtual bool SupportsOp(Instruction::Opcode op) const;
   virtual bool AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread);
+  virtual void ResetIssueLimit();
 
   // From HardwareModule
   virtual void ClockRise();
@@ -0,0 +1,452 @@
+#include "Checkpoint.h"
+#include "GlobalRegisterFile.h"
+#include "Instruction.h"
+#include "IssueUnit.h"
+#include "L1Cache.h"
+#include "L2Cache.h"
+#include "LocalStore.h"
+#include "MainMemory.h"
+#include "SimpleRegisterFile.h"
+#include "Synchronize.h"
+#include "ThreadProcessor.h"
+#include "ThreadState.h"
+#include "TraxCore.h"
+#include "WriteRequest.h"
+#include "usimm.h"
+#include <stdlib.h>
+#include <string.h>
+
+CheckpointStream::CheckpointStream(const char* _filename, bool _writing)
+{
+  filename = _filename;
+  writing = _writing;
+  instructions = NULL;
+
+  file = fopen(filename, writing ? "wb" : "rb");
+  if(!file)
+    {
+      printf("Error: could not open checkpoint file %s for %s\n", filename,
+	     writing ? "writing" : "reading");
+      exit(1);
+    }
+
+  char magic[8];
+  int version = CHECKPOINT_VERSION;
+  memcpy(magic, CHECKPOINT_MAGIC, 8);
+  Array(magic, 8);
+  Value(version);
+  if(memcmp(magic, CHECKPOINT_MAGIC, 8) != 0)
+    {
+      printf("Error: %s is not a simtrax checkpoint\n", filename);
+      exit(1);
+    }
+  if(version != CHECKPOINT_VERSION)
+    {
+      printf("Error: checkpoint %s is version %d, expected version %d\n", filename, version, CHECKPOINT_VERSION);
+      exit(1);
+    }
+}
+
+CheckpointStream::~CheckpointStream()
+{
+  fclose(file);
+}
+
+void CheckpointStream::Bytes(void* data, size_t size)
+{
+  if(size == 0)
+    return;
+  if(writing)
+    {
+      if(fwrite(data, 1, size, file) != size)
+	{
+	  printf("Error: failed writing checkpoint %s\n", filename);
+	  exit(1);
+	}
+    }
+  else if(fread(data, 1, size, file) != size)
+    {
+      printf("Error: checkpoint %s is truncated\n", filename);
+      exit(1);
+    }
+}
+
+void CheckpointStream::SparseWords(FourByte* data, size_t num_words)
+{
+  for(size_t start = 0; start < num_words; start += CHECKPOINT_PAGE_WORDS)
+    {
+      size_t page_words = num_words - start;
+      if(page_words > CHECKPOINT_PAGE_WORDS)
+	page_words = CHECKPOINT_PAGE_WORDS;
+
+      // Decided by the contents, host page residency says nothing about swapped out
+      // or file-backed pages. Reading an untouched anonymous page maps the shared zero
+      // page rather than committing memory
+      char stored = 0;
+      for(size_t i = 0; i < page_words && !stored; i++)
+	if(data[start + i].uvalue != 0)
+	  stored = 1;
+
+      // when reading, 'stored' says whether the page currently holds anything
+      bool was_nonzero = stored;
+      Value(stored);
+      if(stored)
+	Array(data + start, page_words);
+      else if(!writing && was_nonzero)
+	memset(data + start, 0, page_words * sizeof(FourByte));
+    }
+}
+
+void CheckpointStream::Check(long long int value, const char* what)
+{
+  long long int stored = value;
+  Value(stored);
+  if(stored != value)
+    {
+      printf("Error: checkpoint %s was taken with %s = %lld, current configuration has %lld\n",
+	     filename, what, stored, value);
+      exit(1);
+    }
+}
+
+void CheckpointStream::Instr(Instruction*& instr)
+{
+  if(instr_ids.empty())
+    for(size_t i = 0; i < instructions->size(); i++)
+      instr_ids[(*instructions)[i]] = (int)i;
+
+  int id = -1;
+  if(writing && instr != NULL)
+    {
+      std::map<Instruction*, int>::iterator found = instr_ids.find(instr);
+      if(found == instr_ids.end())
+	{
+	  printf("Error: can not checkpoint reference to unknown instruction\n");
+	  exit(1);
+	}
+      id = found->second;
+    }
+  Value(id);
+  if(!writing)
+    instr = id < 0 ? NULL : (*instructions)[id];
+}
+
+void CheckpointStream::Thread(ThreadState*& thread)
+{
+  if(thread_ids.empty())
+    for(size_t i = 0; i < threads.size(); i++)
+      thread_ids[threads[i]] = (int)i;
+
+  int id = -1;
+  if(writing && thread != NULL)
+    id = thread_ids[thread];
+  Value(id);
+  if(!writing)
+    thread = id < 0 ? NULL : threads[id];
+}
+
+void CheckpointStream::L1(L1Cache*& cache)
+{
+  int id = -1;
+  for(size_t i = 0; writing && i < L1s.size(); i++)
+    if(L1s[i] == cache)
+      id = (int)i;
+  Value(id);
+  if(!writing)
+    cache = id < 0 ? NULL : L1s[id];
+}
+
+void CheckpointStream::L2(L2Cache*& cache)
+{
+  int id = -1;
+  for(size_t i = 0; writing && i < L2s.size(); i++)
+    if(L2s[i] == cache)
+      id = (int)i;
+  Value(id);
+  if(!writing)
+    cache = id < 0 ? NULL : L2s[id];
+}
+
+static void CheckpointWriteQueue(CheckpointStream& cp, WriteQueue& queue)
+{
+  cp.Value(queue.head);
+  cp.Value(queue.tail);
+
+  // Only the live part of the ring buffer matters
+  int num = queue.size();
+  for(int i = 0; i < num; i++)
+    {
+      WriteRequest& request = queue.requests[(queue.tail + i) % WRITE_QUEUE_SIZE];
+      cp.Value(request.ready_cycle);
+      cp.Value(request.op);
+      cp.Instr(request.instr);
+      cp.Value(request.which_reg);
+      cp.Value(request.isMSA);
+      cp.Value(request.udata);
+      cp.Array(request.udataMSA, 3);
+    }
+}
+
+static void CheckpointThread(CheckpointStream& cp, ThreadState* thread)
+{
+  int num_regs = thread->registers->num_registers;
+
+  cp.Value(thread->end_sleep_cycle);
+  cp.Value(thread->instructions_issued);
+  cp.Value(thread->program_counter);
+  cp.Value(thread->next_program_counter);
+  cp.Value(thread->instruction_id);
+  cp.Array(thread->register_ready, num_regs);
+  cp.Array(thread->writes_in_flight, num_regs);
+  cp.Value(thread->carry_register);
+  cp.Value(thread->compare_register);
+  cp.Instr(thread->fetched_instruction);
+  cp.Instr(thread->issued_this_cycle);
+  cp.Value(thread->instructions_in_flight);
+  cp.Value(thread->sleep_cycles);
+  cp.Value(thread->last_issue);
+  cp.Value(thread->halted);
+
+  // 4 words per register for MSA
+  cp.Value(thread->registers->current_cycle);
+  cp.Array(thread->registers->idata, num_regs * 4);
+
+  CheckpointWriteQueue(cp, thread->write_requests);
+}
+
+static void CheckpointCacheUpdates(CheckpointStream& cp, std::vector<CacheUpdate>& updates)
+{
+  cp.Vector(updates, CacheUpdate(0, 0, 0));
+}
+
+static void CheckpointL1(CheckpointStream& cp, L1Cache* L1)
+{
+  int num_lines = L1->cache_size >> L1->line_size;
+  cp.Check(L1->cache_size, "L1 size");
+  cp.Check(L1->line_size, "L1 line size");
+  cp.Check(L1->num_banks, "L1 banks");
+
+  cp.Array(L1->tags, num_lines);
+  cp.Array(L1->valid, num_lines);
+#if TRACK_LINE_STATS
+  cp.Array(L1->total_reads, num_lines);
+  cp.Array(L1->total_validates, num_lines);
+  cp.Array(L1->line_accesses, num_lines);
+#endif
+  cp.Array(L1->issued_this_cycle, L1->num_banks);
+  cp.Array(L1->read_address, L1->num_banks);
+  cp.Value(L1->processed_this_cycle);
+  CheckpointCacheUpdates(cp, L1->update_list);
+
+  int num_transfers = (int)L1->bus_traffic.size();
+  cp.Value(num_transfers);
+  if(!cp.writing)
+    L1->bus_traffic.assign(num_transfers, BusTransfer(0, 0, 0));
+  for(int i = 0; i < num_transfers; i++)
+    {
+      BusTransfer& transfer = L1->bus_traffic[i];
+      cp.Value(transfer.index);
+      cp.Value(transfer.tag);
+      cp.Value(transfer.update_cycle);
+      int num_recipients = (int)transfer.recipients.size();
+      cp.Value(num_recipients);
+      if(!cp.writing)
+	transfer.recipients.assign(num_recipients, RegisterWrite(0, 0, NULL));
+      for(int j = 0; j < num_recipients; j++)
+	{
+	  cp.Value(transfer.recipients[j].address);
+	  cp.Value(transfer.recipients[j].which_reg);
+	  cp.Thread(transfer.recipients[j].thread);
+	}
+    }
+
+  cp.Value(L1->current_cycle);
+  cp.Value(L1->hits);
+  cp.Value(L1->stores);
+  cp.Value(L1->accesses);
+  cp.Value(L1->misses);
+  cp.Value(L1->nearby_hits);
+  cp.Value(L1->bank_conflicts);
+  cp.Value(L1->same_word_conflicts);
+  cp.Value(L1->bus_transfers);
+  cp.Value(L1->bus_hits);
+}
+
+static void CheckpointL2(CheckpointStream& cp, L2Cache* L2)
+{
+  int num_lines = L2->cache_size >> L2->line_size;
+  cp.Check(L2->cache_size, "L2 size");
+  cp.Check(L2->line_size, "L2 line size");
+  cp.Check(L2->num_banks, "L2 banks");
+
+  cp.Array(L2->tags, num_lines);
+  cp.Array(L2->valid, num_lines);
+  cp.Array(L2->last_issued, L2->num_banks);
+  cp.Value(L2->outstanding_data);
+  cp.Value(L2->processed_this_cycle);
+  cp.Value(L2->issued_this_cycle);
+  CheckpointCacheUpdates(cp, L2->update_list);
+
+  cp.Value(L2->current_cycle);
+  cp.Value(L2->bandwidth_stalls);
+  cp.Value(L2->memory_faults);
+  cp.Value(L2->hits);
+  cp.Value(L2->stores);
+  cp.Value(L2->accesses);
+  cp.Value(L2->misses);
+  cp.Value(L2->bank_conflicts);
+}
+
+static void CheckpointIssueUnit(CheckpointStream& cp, IssueUnit* issuer, int num_instructions)
+{
+  int num_procs = (int)issuer->thread_procs.size();
+
+  cp.Value(issuer->printed_single_kernel);
+  cp.Array(issuer->kernel_instruction_count, Instruction::NUM_OPS);
+  cp.Array(issuer->kernel_stall_cycles, Instruction::NUM_OPS);
+  cp.Array(issuer->kernel_fu_dependencies, Instruction::NUM_OPS);
+  for(int i = 0; i < MAX_NUM_KERNELS; i++)
+    {
+      cp.Array(issuer->kernel_cycles[i], num_procs);
+      cp.Array(issuer->kernel_calls[i], num_procs);
+      cp.Array(issuer->kernel_profiling[i], num_procs);
+    }
+
+  cp.Value(issuer->current_cycle);
+  cp.Value(issuer->not_ready);
+  cp.Value(issuer->not_fetched);
+  cp.Value(issuer->halted_count);
+  cp.Value(issuer->instructions_issued);
+  cp.Value(issuer->instructions_stalled);
+  cp.Value(issuer->instructions_misc);
+  cp.Value(issuer->instruction_id);
+  cp.Value(issuer->program_counter);
+  cp.Value(issuer->num_halted);
+  cp.Value(issuer->halted);
+  cp.Value(issuer->halt_cycle);
+  cp.Value(issuer->current_vec_ops);
+  cp.Value(issuer->lastOp);
+  cp.Vector(issuer->vector_writes, 0);
+  cp.Array(issuer->total_vector_ops, 14);
+  cp.Value(issuer->last_pc);
+  cp.Array(issuer->thread_issue_count, num_procs + 1);
+  cp.Value(issuer->start_proc);
+  cp.Array(issuer->atominc_bins, num_procs);
+  cp.Array(issuer->instruction_bins, Instruction::NUM_OPS);
+  cp.Array(issuer->unit_contention, Instruction::NUM_OPS);
+  cp.Array(issuer->data_depend_bins, Instruction::NUM_OPS);
+  cp.Value(issuer->fu_dependence);
+  cp.Value(issuer->data_dependence);
+  cp.Value(issuer->issue_stats);
+  cp.Value(issuer->read_queue);
+
+  cp.Array(issuer->simd_last_issued, num_procs / issuer->simd_width);
+  cp.Array(issuer->simd_state, num_procs);
+  cp.Value(issuer->simd_stalls);
+  cp.Value(issuer->simd_issue);
+  cp.Value(issuer->simd_bonus_fetches);
+
+  cp.Array(issuer->profile_instruction_count, num_instructions + 1);
+  cp.Array(issuer->profile_instruction_cycle_count, num_instructions + 1);
+
+  for(int i = 0; i < issuer->num_icaches; i++)
+    cp.Array(issuer->bank_fetched[i], issuer->icache_banks);
+  cp.Value(issuer->iCache_conflicts);
+  cp.Value(issuer->total_bank_cycles);
+  cp.Value(issuer->bank_cycles_used);
+  cp.Array(issuer->schedule_data, num_procs);
+  cp.Value(issuer->current_proc_id);
+}
+
+static void CheckpointCore(CheckpointStream& cp, TraxCore* core)
+{
+  cp.Check(core->num_thread_procs, "threads per TM");
+  cp.Check(core->threads_per_proc, "threads per thread processor");
+  cp.Check(core->num_regs, "registers");
+
+  cp.Value(core->cycle_num);
+  cp.Vector(core->utilizations, 0.);
+
+  CheckpointL1(cp, core->L1);
+  CheckpointIssueUnit(cp, core->issuer, (int)core->instructions->size());
+
+  for(size_t i = 0; i < core->thread_procs.size(); i++)
+    {
+      ThreadProcessor* tp = core->thread_procs[i];
+      cp.Value(tp->active_thread);
+      cp.Value(tp->halted);
+      cp.Value(tp->num_halted);
+      for(size_t j = 0; j < tp->thread_states.size(); j++)
+	CheckpointThread(cp, tp->thread_states[j]);
+    }
+
+  // The remaining units only hold per-cycle issue counts that are cleared on ClockRise,
+  // other than the local store contents and the barrier state.
+  for(size_t i = 0; i < core->functional_units.size(); i++)
+    {
+      LocalStore* ls = dynamic_cast<LocalStore*>(core->functional_units[i]);
+      if(ls)
+	for(int j = 0; j < ls->width; j++)
+	  cp.SparseWords(ls->storage[j], LOCAL_SIZE / 4);
+
+      Synchronize* sync = dynamic_cast<Synchronize*>(core->functional_units[i]);
+      if(sync)
+	{
+	  cp.Array(sync->locked, sync->num_threads);
+	  cp.Array(sync->at_lock, sync->num_threads);
+	}
+    }
+}
+
+void CheckpointSimulator(CheckpointStream& cp, std::vector<TraxCore*>& cores,
+			 L2Cache** L2s, int num_L2s, GlobalRegisterFile* globals,
+			 MainMemory* memory, bool usimm_enabled)
+{
+  // Tables for translating pointers to ids
+  cp.instructions = cores[0]->instructions;
+  cp.threads.clear();
+  cp.L1s.clear();
+  cp.L2s.clear();
+  for(size_t i = 0; i < cores.size(); i++)
+    {
+      cp.L1s.push_back(cores[i]->L1);
+      for(size_t j = 0; j < cores[i]->thread_procs.size(); j++)
+	for(size_t k = 0; k < cores[i]->thread_procs[j]->thread_states.size(); k++)
+	  cp.threads.push_back(cores[i]->thread_procs[j]->thread_states[k]);
+    }
+  for(int i = 0; i < num_L2s; i++)
+    cp.L2s.push_back(L2s[i]);
+
+  cp.Check((long long int)cores.size(), "TMs");
+  cp.Check(num_L2s, "L2s");
+  cp.Check((long long int)cp.instructions->size(), "program instructions");
+  cp.Check(memory->num_blocks, "memory words");
+  cp.Check(globals->num_registers, "global registers");
+  cp.Check(usimm_enabled, "usimm enabled");
+
+  // Dynamic ids and per-instruction profile counters
+  for(size_t i = 0; i < cp.instructions->size(); i++)
+    {
+      Instruction* ins = (*cp.instructions)[i];
+      cp.Value(ins->id);
+      cp.Value(ins->executions);
+      cp.Value(ins->data_stalls);
+      cp.Value(ins->cycles);
+    }
+
+  cp.SparseWords(memory->data, memory->num_blocks);
+  cp.Value(memory->issued_atominc);
+  cp.Value(memory->store_count);
+
+  cp.Array(globals->idata, globals->num_registers);
+  cp.Value(globals->last_report_cycle);
+
+  for(int i = 0; i < num_L2s; i++)
+    CheckpointL2(cp, L2s[i]);
+
+  for(size_t i = 0; i < cores.size(); i++)
+    CheckpointCore(cp, cores[i]);
+
+  if(usimm_enabled)
+    usimmCheckpoint(cp);
+}
@@ -0,0 +1,76 @@
+#ifndef _SIMHWRT_CHECKPOINT_H_
+#define _SIMHWRT_CHECKPOINT_H_
+
+// Checkpoint/restore of the complete simulator state at a cycle boundary.
+// A CheckpointStream is symmetric: the same sequence of calls either writes
+// state to the file or reads it back in to place, so every component has a
+// single routine describing its layout.
+
+#include "FourByte.h"
+#include <stdio.h>
+#include <vector>
+#include <map>
+
+#define CHECKPOINT_MAGIC "TRAXCKPT"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_PAGE_WORDS 1024
+
+class Instruction;
+class ThreadState;
+class TraxCore;
+class L1Cache;
+class L2Cache;
+class GlobalRegisterFile;
+class MainMemory;
+
+class CheckpointStream {
+public:
+  CheckpointStream(const char* filename, bool _writing);
+  ~CheckpointStream();
+
+  void Bytes(void* data, size_t size);
+  template <class T> void Value(T& value) { Bytes(&value, sizeof(T)); }
+  template <class T> void Array(T* values, size_t count) { Bytes(values, sizeof(T) * count); }
+
+  // Vectors of plain-old-data, sized on read using a copy of 'fill'
+  template <class T> void Vector(std::vector<T>& values, const T& fill)
+  {
+    int count = (int)values.size();
+    Value(count);
+    if(!writing)
+      values.assign(count, fill);
+    if(count > 0)
+      Array(&values[0], count);
+  }
+
+  // Stores only the pages of 'data' that contain a non-zero word. Pages left out are
+  // zeroed on restore, so it doesn't matter what the restoring run started with
+  void SparseWords(FourByte* data, size_t num_words);
+
+  // Writes a structural parameter, or verifies it matches the checkpointed value
+  void Check(long long int value, const char* what);
+
+  // Pointers are stored as indices in to the simulator's tables
+  void Instr(Instruction*& instr);
+  void Thread(ThreadState*& thread);
+  void L1(L1Cache*& cache);
+  void L2(L2Cache*& cache);
+
+  bool writing;
+  FILE* file;
+  const char* filename;
+
+  std::vector<Instruction*>* instructions;
+  std::vector<ThreadState*> threads;
+  std::vector<L1Cache*> L1s;
+  std::vector<L2Cache*> L2s;
+  std::map<Instruction*, int> instr_ids;
+  std::map<ThreadState*, int> thread_ids;
+};
+
+// Saves (or restores, depending on the stream) everything that changes while simulating.
+void CheckpointSimulator(CheckpointStream& cp, std::vector<TraxCore*>& cores,
+			 L2Cache** L2s, int num_L2s, GlobalRegisterFile* globals,
+			 MainMemory* memory, bool usimm_enabled);
+
+#endif // _SIMHWRT_CHECKPOINT_H_
@@ -105,6 +105,11 @@ bool ConversionUnit::AcceptInstruction(Instruction& ins, IssueUnit* issuer, Thre
   return true;
 }
 
+void ConversionUnit::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void ConversionUnit::ClockRise()
 {
@@ -1,4 +1,5 @@
 #include "DebugUnit.h"
+#include "DeterministicExecution.h"
 #include "SimpleRegisterFile.h"
 #include "IssueUnit.h"
 #include "ThreadState.h"
@@ -26,6 +27,8 @@ bool DebugUnit::SupportsOp(Instruction::Opcode op) const
 
 bool DebugUnit::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread)
 {
+  // keep output in TM order
+  DeterministicGate(thread->core_id);
   if (ins.args[0]==0)
     printf("\n");
   else {
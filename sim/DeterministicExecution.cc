@@ -0,0 +1,73 @@
+#include "DeterministicExecution.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "IssueUnit.h"
+#include <limits.h>
+#include <pthread.h>
+
+bool deterministic_execution = false;
+
+// Cycles are counted here rather than read from the TMs, since the gate is reached from
+// inside units that only know their thread state
+static long long int current_cycle;
+static std::vector<long long int> done_cycle;   // last cycle each thread finished clocking
+static std::vector<long long int> passed_cycle; // last cycle each thread went through the gate
+static std::vector<int> core_thread;
+static bool all_halted;
+static pthread_mutex_t gate_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gate_cond = PTHREAD_COND_INITIALIZER;
+
+void DeterministicSetup(int num_threads, const std::vector<int>& thread_of_core)
+{
+  current_cycle = 0;
+  all_halted = false;
+  done_cycle.assign(num_threads, -1);
+  passed_cycle.assign(num_threads, -1);
+  core_thread = thread_of_core;
+}
+
+void DeterministicWait(int core_id)
+{
+  int thread_num = core_thread[core_id];
+  // only written by this thread, so no lock needed for the common case
+  if (passed_cycle[thread_num] == current_cycle)
+    return;
+
+  pthread_mutex_lock(&gate_mutex);
+  for (int i = 0; i < thread_num; i++) {
+    while (done_cycle[i] < current_cycle)
+      pthread_cond_wait(&gate_cond, &gate_mutex);
+  }
+  pthread_mutex_unlock(&gate_mutex);
+  passed_cycle[thread_num] = current_cycle;
+}
+
+void DeterministicThreadDone(int thread_num)
+{
+  pthread_mutex_lock(&gate_mutex);
+  done_cycle[thread_num] = current_cycle;
+  pthread_cond_broadcast(&gate_cond);
+  pthread_mutex_unlock(&gate_mutex);
+}
+
+void DeterministicThreadExit(int thread_num)
+{
+  pthread_mutex_lock(&gate_mutex);
+  done_cycle[thread_num] = LLONG_MAX;
+  pthread_cond_broadcast(&gate_cond);
+  pthread_mutex_unlock(&gate_mutex);
+}
+
+void DeterministicNextCycle(const std::vector<TraxCore*>& cores)
+{
+  all_halted = true;
+  for (size_t i = 0; i < cores.size(); i++)
+    if (!cores[i]->issuer->halted)
+      all_halted = false;
+  current_cycle++;
+}
+
+bool DeterministicAllHalted()
+{
+  return all_halted;
+}
@@ -0,0 +1,42 @@
+#ifndef _SIMHWRT_DETERMINISTIC_EXECUTION_H_
+#define _SIMHWRT_DETERMINISTIC_EXECUTION_H_
+
+// Deterministic parallel simulation ("--deterministic"). Each simulation thread clocks its
+// TMs in TM order, and the first time a TM touches state shared with other TMs in a cycle
+// (the L2s, DRAM queues, main memory, global registers, debug output) its thread waits
+// until every thread owning lower-numbered TMs has finished that cycle. Shared state is
+// then seen and changed in exactly the order a single thread clocking TMs 0..N would use,
+// so results do not depend on --simulation-threads or host timing. Work before a thread's
+// first shared access in a cycle still overlaps with the other threads.
+
+#include <vector>
+
+class TraxCore;
+
+extern bool deterministic_execution;
+
+// Called before the simulation threads start. thread_of_core maps each TM to its thread.
+void DeterministicSetup(int num_threads, const std::vector<int>& thread_of_core);
+
+// Blocks until the TMs before core_id (on other threads) are done with this cycle
+void DeterministicWait(int core_id);
+
+// A thread has clocked all its TMs for this cycle, or has stopped simulating
+void DeterministicThreadDone(int thread_num);
+void DeterministicThreadExit(int thread_num);
+
+// Called by the last thread in the barrier, every thread is waiting
+void DeterministicNextCycle(const std::vector<TraxCore*>& cores);
+
+// Whether every TM had halted at the last barrier. Threads only stop once all TMs have,
+// so halted TMs keep counting cycles and no thread leaves in the middle of a cycle.
+bool DeterministicAllHalted();
+
+// Cheap check for the hot paths
+inline void DeterministicGate(int core_id)
+{
+  if (deterministic_execution)
+    DeterministicWait(core_id);
+}
+
+#endif // _SIMHWRT_DETERMINISTIC_EXECUTION_H_
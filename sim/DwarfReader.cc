@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <algorithm>
 #include <map>
 #include <queue>
@@ -18,53 +19,134 @@ Location evalDwarfExpression( const char* jump_table, int& addr, int numBytes);
 int decodeSLEB128(const char* jump_table, int& addr, int maxRead);
 unsigned int decodeULEB128(const char* jump_table, int& addr, int maxRead);
 
-void advanceDtablePtr(const std::vector<symbol*> data_table, int& dtable_ptr, int numBytes);
+void advanceDtablePtr(const std::vector<symbol*>& data_table, int& dtable_ptr, int numBytes);
 
 DwarfReader::DwarfReader()
 {
   rootRuntime = NULL;
+  jumpTable = NULL;
+  debugStart = debugEnd = 0;
+  pcIndexDirty = false;
 }
 
 
 // Using debug symbols, create a tree representation of the source info with program counter ranges
-bool DwarfReader::BuildSourceTree(const std::vector<symbol*> labels, std::vector<symbol*> elf_vars,
-			       const std::vector<symbol*> data_table, const char* jump_table, 
+// Only the compile units' own entries are read here. The entries below a compile unit are read
+// the first time one of its PCs is profiled or debugged (TouchPC), so the debug info of headers
+// the kernel barely uses is never parsed
+bool DwarfReader::BuildSourceTree(const std::vector<symbol*>& labels, const std::vector<symbol*>& elf_vars,
+				  const std::vector<symbol*>& data_table, const char* jump_table, 
 				  int jtable_size, int debug_start, int debug_end, int abbrev_start)
 {
-  int unit_ptr = debug_start;
+  // Entries are read on demand from here on. The assembler keeps the symbols and data segment
+  dataTable = data_table;
+  jumpTable = jump_table;
+  debugStart = debug_start;
+  debugEnd = debug_end;
 
   // Find the addresses of each DWARF abbreviation unit
   FindAbbrevCodes(jump_table, abbrev_start, jtable_size);
   
-  // Read each compilation unit until done
-
+  // Index each compilation unit until done
+  int unit_ptr = debug_start;
   while(unit_ptr < debug_end)
     {
       // Read fixed header data
       int unit_length;
-      int start_unit = unit_ptr;
+      CompileUnitIndex index;
+      index.start = unit_ptr;
       ReadUnitHeader(unit_length, jump_table, unit_ptr);
 
-      // Read the rest of the unit data
-      rootSource.children.push_back(ReadCompilationUnit(labels, elf_vars, data_table, 
-							jump_table, jtable_size, unit_ptr, 
-							debug_start, debug_end, abbrev_start,
-							start_unit, 0));
+      // Read the unit's own entry
+      index.unit = ReadCompilationUnit(unit_ptr, index.start, 0, &index.has_children);
+      index.unit->parent = &rootSource;
+      index.children_addr = unit_ptr;
+      index.top_unit_pc = 0;
+      if(index.unit->tag == DW_TAG_compile_unit && index.unit->ranges.size() == 1)
+	index.top_unit_pc = index.unit->ranges[0].first;
+      index.read = false;
+      index.resolved = false;
+      index.first_unit = index.last_unit = 0;
+      index.end = index.has_children ? index.start + 4 + unit_length : unit_ptr;
+
+      rootSource.children.push_back(index.unit);
+      unit_list.push_back(index.unit);
+      unitsByAddress.insert(std::pair<int, CompilationUnit*>(index.unit->addr, index.unit));
+      compileUnits.push_back(index);
+
+      // The header says where the next unit starts. If that isn't a debug entry, read the
+      // children to find out
+      if(index.end <= index.children_addr || index.end > debug_end ||
+	 (index.end < debug_end && FindDataEntry(index.end) < 0))
+	ReadUnitChildren(compileUnits.size() - 1);
+      unit_ptr = compileUnits.back().end;
     }
 
-  // Set up parents
-  rootSource.SetParents();
+  // A unit's PC ranges decide when it is read, so read any without usable ones now,
+  // along with any that had to be read above
+  for(size_t i = 0; i < compileUnits.size(); i++)
+    {
+      bool usable = compileUnits[i].unit->ranges.size() > 0;
+      for(size_t j = 0; j < compileUnits[i].unit->ranges.size(); j++)
+	if(compileUnits[i].unit->ranges[j].second <= compileUnits[i].unit->ranges[j].first)
+	  usable = false;
+      if(!usable || compileUnits[i].read)
+	Materialize(i);
+    }
 
-  // Combine all units and their children in to one list
-  for(size_t i = 0; i < rootSource.children.size(); i++)
-    AddUnitList(rootSource.children[i]);
+  // Find "main", starting with the units containing its label
+  for(size_t i = 0; i < labels.size() && rootRuntime == NULL; i++)
+    for(size_t j = 0; j < labels[i]->names.size(); j++)
+      if(labels[i]->isText && strcmp(labels[i]->names[j], "main") == 0)
+	{
+	  TouchPC(labels[i]->address);
+	  break;
+	}
+  if(rootRuntime == NULL)
+    MaterializeAll();
 
-  // Update names of reference units (DW_AT_specification, DW_AT_abstract_origin, DW_AT_type)
-  // Meanwhile, find "main"
+  if(rootRuntime == NULL)
+    {
+      printf("ERROR: (--profile): Found no \"main\" routine. Did you compile your TRaX project with -g?\n");
+      exit(1);
+    }
+  
+  BuildPCIndex();
+  PrintMemoryUse();
+
+  return true;
+ 
+ }
+
+
+// Reads the entries below a compile unit, and adds them to the unit list and map
+void DwarfReader::ReadUnitChildren(size_t cu)
+{
+  if(compileUnits[cu].read)
+    return;
+  compileUnits[cu].read = true;
+
+  CompilationUnit* unit = compileUnits[cu].unit;
+  if(compileUnits[cu].has_children)
+    {
+      int addr = compileUnits[cu].children_addr;
+      ReadChildren(unit, addr, compileUnits[cu].start, compileUnits[cu].top_unit_pc);
+      compileUnits[cu].end = addr;
+    }
+
+  // Set up parents
+  unit->SetParents();
+
+  // Combine the unit's children in to the unit list
+  compileUnits[cu].first_unit = unit_list.size();
+  for(size_t i = 0; i < unit->children.size(); i++)
+    AddUnitList(unit->children[i]);
+  compileUnits[cu].last_unit = unit_list.size();
 
   // Build the map
-  for(size_t i = 0; i < unit_list.size(); i++){
-    if(unit_list[i]->name.compare(std::string("main")) == 0){
+  // Meanwhile, find "main"
+  for(size_t i = compileUnits[cu].first_unit; i < compileUnits[cu].last_unit; i++){
+    if(rootRuntime == NULL && unit_list[i]->name.compare(std::string("main")) == 0){
       if(unit_list[i]->ranges.size() > 0){
 	rootRuntime = new RuntimeNode();
 	rootRuntime->source_node = (unit_list[i]);
@@ -72,39 +154,130 @@ bool DwarfReader::BuildSourceTree(const std::vector<symbol*> labels, std::vector
     }
     unitsByAddress.insert(std::pair<int, CompilationUnit*>(unit_list[i]->addr, unit_list[i]));
   }	
+}
+
 
-  // Now fix up the units with references so they take the name and ranges of the referenced unit.
-  for(size_t i = 0; i < unit_list.size(); ++i){
+// Reads a compile unit's children and fixes up their references
+void DwarfReader::Materialize(size_t cu)
+{
+  ReadUnitChildren(cu);
+  if(compileUnits[cu].resolved)
+    return;
+  // Set first, a reference cycle between two compile units reads each of them once
+  compileUnits[cu].resolved = true;
+
+  // Now fix up the units with references so they take the name of the referenced unit (DW_AT_specification,
+  // DW_AT_abstract_origin), and their type units (DW_AT_type). These may be in other compile units
+  for(size_t i = compileUnits[cu].first_unit; i < compileUnits[cu].last_unit; ++i){
     CompilationUnit* tmp = unit_list[i];
-    bool merging = false;
     while(tmp->pointsTo >= 0){
-      tmp = unitsByAddress.find(tmp->pointsTo)->second;
-      merging = true;
+      tmp = FindUnit(tmp->pointsTo);
+      if(tmp == NULL)
+	{
+	  printf("ERROR (--profile): Invalid profile data (did you compile your TRaX project with -g?)\n");
+	  exit(1);
+	}
     }
 
     unit_list[i]->name = tmp->name;
     
     // Check if the unit has a type reference
     if(unit_list[i]->typeRef >= 0)
-      {
-	tmp = unitsByAddress.find(unit_list[i]->typeRef)->second;
-	unit_list[i]->typeUnit = tmp;
-      }
+      unit_list[i]->typeUnit = FindUnit(unit_list[i]->typeRef);
   }  
 
-  if(rootRuntime == NULL)
+  // Rebuilt once by whoever asked for the read, a chain of FindUnit reads would
+  // otherwise rebuild it for every unit in the chain
+  pcIndexDirty = true;
+}
+
+
+void DwarfReader::MaterializeAll()
+{
+  for(size_t i = 0; i < compileUnits.size(); i++)
+    Materialize(i);
+}
+
+
+// Looks up the entry at a .debug_info address, reading the compile unit it is in if needed
+CompilationUnit* DwarfReader::FindUnit(int addr)
+{
+  std::map<int, CompilationUnit*>::iterator it = unitsByAddress.find(addr);
+  if(it != unitsByAddress.end())
+    return it->second;
+
+  // Compile units are indexed in address order
+  size_t lo = 0, hi = compileUnits.size();
+  while(lo < hi)
     {
-      printf("ERROR: (--profile): Found no \"main\" routine. Did you compile your TRaX project with -g?\n");
-      exit(1);
+      size_t mid = (lo + hi) / 2;
+      if(compileUnits[mid].start <= addr)
+	lo = mid + 1;
+      else
+	hi = mid;
     }
-  
-  // For debugging. May be useful
-  // Writes a graphviz file representing the source tree
-  WriteDot("sourcetree.dot");
+  if(lo == 0 || addr >= compileUnits[lo - 1].end || compileUnits[lo - 1].read)
+    return NULL;
 
-  return true;
- 
- }
+  Materialize(lo - 1);
+  it = unitsByAddress.find(addr);
+  return it != unitsByAddress.end() ? it->second : NULL;
+}
+
+
+// Reads whatever contains pc that hasn't been read yet, and finds which unit a call to it lands in
+void DwarfReader::TouchPC(int pc)
+{
+  if(pc < 0)
+    return;
+  if(pc >= (int)pcTouched.size())
+    {
+      pcTouched.resize(pc + 1, 0);
+      pcFunctionCall.resize(pc + 1, NULL);
+    }
+  if(pcTouched[pc])
+    return;
+  pcTouched[pc] = 1;
+
+  for(size_t i = 0; i < compileUnits.size(); i++)
+    if(!compileUnits[i].resolved && compileUnits[i].unit->ContainsPC(pc))
+      Materialize(i);
+  if(pcIndexDirty)
+    BuildPCIndex();
+
+  Instruction ins(Instruction::NOP, 0, 0, 0, 0);
+  ins.pc_address = pc;
+  for(size_t i = 0; i < rootSource.children.size(); i++)
+    {
+      pcFunctionCall[pc] = rootSource.children[i]->FindFunctionCall(&ins);
+      if(pcFunctionCall[pc] != NULL)
+	break;
+    }
+}
+
+
+// Reports how much of the debug info has been read, and roughly the memory it takes
+void DwarfReader::PrintMemoryUse()
+{
+  int units_read = 0;
+  for(size_t i = 0; i < compileUnits.size(); i++)
+    if(compileUnits[i].read)
+      units_read++;
+
+  size_t bytes = 0;
+  for(size_t i = 0; i < unit_list.size(); i++)
+    bytes += sizeof(CompilationUnit) + unit_list[i]->name.capacity() +
+      unit_list[i]->children.capacity() * sizeof(CompilationUnit*) +
+      unit_list[i]->ranges.capacity() * sizeof(std::pair<int, int>);
+  // A map node holds its value, three pointers and a color
+  bytes += unitsByAddress.size() * (sizeof(std::pair<const int, CompilationUnit*>) + 4 * sizeof(void*));
+  bytes += (scopeStarts.capacity() + scopeFirst.capacity()) * sizeof(int) +
+    (scopeUnits.capacity() + pcFunctionCall.capacity()) * sizeof(CompilationUnit*) +
+    pcTouched.capacity() + abbrevIndex.capacity() * sizeof(int);
+
+  printf("Debug info: read %d of %d compile units, %d entries (%.1f KB)\n",
+	 units_read, (int)compileUnits.size(), (int)unit_list.size(), bytes / 1024.0);
+}
 
 
 // For profiler only. Debugger will break if this is executed.
@@ -143,14 +316,14 @@ void DwarfReader::MergeInto(CompilationUnit* from, CompilationUnit* into)
 // DWARF compilation units are considered a debugging entry here
 // jump_table is the program's raw data segment
 // data_table is the "symbol" representation of the data segment (gives info about each entry)
-CompilationUnit* DwarfReader::ReadCompilationUnit(const std::vector<symbol*> labels, std::vector<symbol*> elf_vars, 
-						  const std::vector<symbol*> data_table, const char* jump_table, 
-						  int jtable_size, int& current_addr, 
-						  int debug_start, int debug_end, int abbrev_start, int top_unit_start,
-						  int top_unit_pc)
+CompilationUnit* DwarfReader::ReadCompilationUnit(int& current_addr, int top_unit_start, int top_unit_pc,
+						  bool* pending_children)
 {
   
-  if(current_addr < debug_start || current_addr >= debug_end)
+  if(pending_children)
+    *pending_children = false;
+
+  if(current_addr < debugStart || current_addr >= debugEnd)
     {
       printf("ERROR (--profile): Invalid profile data. Did you compile your TRaX project with -g?\n");
       exit(1);
@@ -162,7 +335,7 @@ CompilationUnit* DwarfReader::ReadCompilationUnit(const std::vector<symbol*> lab
   retval->top_level_addr = top_unit_start;
 
   // The unit's abbreviation code is always the first byte
-  int abbrev_code = readByte(jump_table, current_addr);
+  int abbrev_code = readByte(jumpTable, current_addr);
   retval->abbrev = abbrev_code;
 
   // End of children marker
@@ -171,12 +344,7 @@ CompilationUnit* DwarfReader::ReadCompilationUnit(const std::vector<symbol*> lab
     
   // Find this unit's address in the vector of symbol objects created by the assembler.
   // This gives us more info about the jump_table (like the size of each entry)
-  int dtable_ptr = -1;
-  for(size_t i=0; i < data_table.size(); i++)
-    if(current_addr == data_table[i]->address){
-      dtable_ptr = i;
-      break;
-    }
+  int dtable_ptr = FindDataEntry(current_addr);
 
   // Make sure we found it
   if(dtable_ptr < 0)
@@ -187,12 +355,8 @@ CompilationUnit* DwarfReader::ReadCompilationUnit(const std::vector<symbol*> lab
 
   // Find the DWARF abbreviation table entry
   int abbrev_addr = -1;
-  for(size_t i=0; i < abbrevCodes.size(); i++)
-    if(abbrevCodes[i].code == abbrev_code)
-      {
-	abbrev_addr = abbrevCodes[i].addr;
-	break;
-      }
+  if(abbrevIndex[abbrev_code] >= 0)
+    abbrev_addr = abbrevCodes[abbrevIndex[abbrev_code]].addr;
 
   // Make sure we found it
   if(abbrev_addr < 0)
@@ -202,30 +366,30 @@ CompilationUnit* DwarfReader::ReadCompilationUnit(const std::vector<symbol*> lab
     }
 
   // Consume the abbrev code itself
-  readByte(jump_table, abbrev_addr);
+  readByte(jumpTable, abbrev_addr);
   // Tag is always next
-  retval->tag = readByte(jump_table, abbrev_addr);
+  retval->tag = readByte(jumpTable, abbrev_addr);
   // Children flag is next
-  bool has_children = readByte(jump_table, abbrev_addr);
+  bool has_children = readByte(jumpTable, abbrev_addr);
 
   // Read attribute/type pairs one at a time
   while(true)
     {
       // Read attribute code
-      unsigned int attribute = readByte(jump_table, abbrev_addr);
+      unsigned int attribute = readByte(jumpTable, abbrev_addr);
       if(attribute == DW_AT_MIPS_linkage_name || attribute == DW_AT_APPLE_optimized)
 	{
 	  // These attributes are larger than others
 	  // Throw away the extra byte associated with these
-	  readByte(jump_table, abbrev_addr); 
+	  readByte(jumpTable, abbrev_addr); 
 	}
       // Read type code
-      unsigned int type = readByte(jump_table, abbrev_addr);
+      unsigned int type = readByte(jumpTable, abbrev_addr);
       if(attribute == 0 && type == 0) // EOM marker
 	break;
 
       // Read and parse the attribute data
-      if(!ReadAttribute(retval, attribute, type, debug_start, jump_table, current_addr, data_table, dtable_ptr, top_unit_pc))
+      if(!ReadAttribute(retval, attribute, type, debugStart, jumpTable, current_addr, dataTable, dtable_ptr, top_unit_pc))
 	exit(1);
 
     }
@@ -243,34 +407,40 @@ CompilationUnit* DwarfReader::ReadCompilationUnit(const std::vector<symbol*> lab
   // Recursively read this unit's children
   if(has_children)
     {
-      while(true)
-	{
-	  CompilationUnit* child = ReadCompilationUnit(labels, elf_vars, data_table, 
-						       jump_table, jtable_size, current_addr, 
-						       debug_start, debug_end, abbrev_start, top_unit_start,
-						       top_unit_pc);
-	  // Propogate a class unit's name down to its children
-	  if(retval->tag == DW_TAG_class_type && retval->name.size() > 0)
-	    if(child->name.size() > 0)
-	      child->name = retval->name + "::" + child->name;
-	  
-	  // End of children
-	  if(child->abbrev == 0)
-	    break;
-
-	  retval->children.push_back(child);
-	  
-	}
+      if(pending_children)
+	*pending_children = true;
+      else
+	ReadChildren(retval, current_addr, top_unit_start, top_unit_pc);
     }
 
   return retval;  
 }
 
 
+// Reads entries in to parent's children up to the end of children marker
+void DwarfReader::ReadChildren(CompilationUnit* parent, int& current_addr, int top_unit_start, int top_unit_pc)
+{
+  while(true)
+    {
+      CompilationUnit* child = ReadCompilationUnit(current_addr, top_unit_start, top_unit_pc);
+      // Propogate a class unit's name down to its children
+      if(parent->tag == DW_TAG_class_type && parent->name.size() > 0)
+	if(child->name.size() > 0)
+	  child->name = parent->name + "::" + child->name;
+	  
+      // End of children
+      if(child->abbrev == 0)
+	break;
+
+      parent->children.push_back(child);
+    }
+}
+
+
 // Reads and parses a DWARF attribute and saves any relevant data that our profiler cares about
 bool DwarfReader::ReadAttribute(CompilationUnit* retval, unsigned int attribute, unsigned int type, 
 				int debug_start, const char* jump_table, int& current_addr, 
-				const std::vector<symbol*> data_table, int& dtable_ptr,
+				const std::vector<symbol*>& data_table, int& dtable_ptr,
 				int top_unit_pc)
 {
   int value;
@@ -317,13 +487,7 @@ bool DwarfReader::ReadAttribute(CompilationUnit* retval, unsigned int attribute,
       break;
 
     case DW_AT_ranges: // a non-contiguous range of PCs
-      rangePtr = readWord(jump_table, current_addr);
-      for(size_t i = 0; i < data_table.size(); i++) // find the symbol for the start of the ranges
-	if(data_table[i]->address == rangePtr)
-	  {
-	    rangePtr = i; // repurpose as an index in to the symbol vector now.
-	    break;
-	  }
+      rangePtr = FindDataEntry(readWord(jump_table, current_addr)); // find the symbol for the start of the ranges
       if(rangePtr == -1)
 	{
 	  printf("ERROR (--profile): Can't find debug ranges symbol\n");
@@ -550,6 +714,7 @@ void DwarfReader::FindAbbrevCodes(const char* jump_table, int abbrev_start, int
 {
   int addr = abbrev_start;
   AbbreviationCode ac;
+  abbrevIndex.assign(256, -1);
   while(addr < jtable_size - 2) // this loop reads 2 at a time, must stop early to be safe
     {
       ac.addr = addr;
@@ -558,6 +723,8 @@ void DwarfReader::FindAbbrevCodes(const char* jump_table, int abbrev_start, int
       if(ac.code == 0) // EOM marker
 	return;
       
+      if(abbrevIndex[ac.code] < 0)
+	abbrevIndex[ac.code] = abbrevCodes.size();
       abbrevCodes.push_back(ac);
       
       // consume the tag and has_children (so they don't count as zeros for EOM detection)
@@ -615,6 +782,93 @@ CompilationUnit* CompilationUnit::FindFunctionCall(Instruction* ins)
 }
 
 
+// Index of the data_table entry at addr. The assembler lays the data segment out in order
+int DwarfReader::FindDataEntry(int addr)
+{
+  size_t lo = 0, hi = dataTable.size();
+  while(lo < hi)
+    {
+      size_t mid = (lo + hi) / 2;
+      if(dataTable[mid]->address < addr)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  if(lo < dataTable.size() && dataTable[lo]->address == addr)
+    return lo;
+  return -1;
+}
+
+
+// Records which units contain each PC, as intervals between the points where that changes
+void DwarfReader::BuildPCIndex()
+{
+  pcIndexDirty = false;
+  scopeStarts.clear();
+  for(size_t i = 0; i < unit_list.size(); i++)
+    for(size_t j = 0; j < unit_list[i]->ranges.size(); j++)
+      {
+	int start = unit_list[i]->ranges[j].first < 0 ? 0 : unit_list[i]->ranges[j].first;
+	if(unit_list[i]->ranges[j].second > start)
+	  {
+	    scopeStarts.push_back(start);
+	    scopeStarts.push_back(unit_list[i]->ranges[j].second);
+	  }
+      }
+  std::sort(scopeStarts.begin(), scopeStarts.end());
+  scopeStarts.erase(std::unique(scopeStarts.begin(), scopeStarts.end()), scopeStarts.end());
+
+  std::vector<std::vector<CompilationUnit*> > intervals(scopeStarts.empty() ? 0 : scopeStarts.size() - 1);
+  for(size_t i = 0; i < unit_list.size(); i++)
+    for(size_t j = 0; j < unit_list[i]->ranges.size(); j++)
+      {
+	int start = unit_list[i]->ranges[j].first < 0 ? 0 : unit_list[i]->ranges[j].first;
+	if(unit_list[i]->ranges[j].second <= start)
+	  continue;
+	size_t first = std::lower_bound(scopeStarts.begin(), scopeStarts.end(), start) - scopeStarts.begin();
+	size_t last = std::lower_bound(scopeStarts.begin(), scopeStarts.end(), unit_list[i]->ranges[j].second) - scopeStarts.begin();
+	for(size_t k = first; k < last; k++)
+	  {
+	    // Overlapping ranges within one unit would list it twice
+	    if(intervals[k].empty() || intervals[k].back() != unit_list[i])
+	      intervals[k].push_back(unit_list[i]);
+	  }
+      }
+
+  scopeFirst.clear();
+  scopeUnits.clear();
+  for(size_t k = 0; k < intervals.size(); k++)
+    {
+      scopeFirst.push_back(scopeUnits.size());
+      scopeUnits.insert(scopeUnits.end(), intervals[k].begin(), intervals[k].end());
+    }
+  scopeFirst.push_back(scopeUnits.size());
+}
+
+
+// The interval containing pc, or -1 if no unit does
+int DwarfReader::PCInterval(int pc)
+{
+  int i = (int)(std::upper_bound(scopeStarts.begin(), scopeStarts.end(), pc) - scopeStarts.begin()) - 1;
+  if(i < 0 || i >= (int)scopeFirst.size() - 1)
+    return -1;
+  return i;
+}
+
+
+// Same as cu->ContainsPC(pc), using the index
+bool DwarfReader::UnitContainsPC(CompilationUnit* cu, int pc)
+{
+  int interval = PCInterval(pc);
+  if(interval < 0)
+    return false;
+  for(int i = scopeFirst[interval]; i < scopeFirst[interval + 1]; i++)
+    if(scopeUnits[i] == cu)
+      return true;
+  return false;
+}
+
+
 // Writes a graphviz file representing the debug source tree
 void DwarfReader::WriteDot(const char* filename)
 {
@@ -815,7 +1069,7 @@ unsigned int decodeULEB128(const char* jump_table, int& addr, int maxRead)
 }
 
 
-void advanceDtablePtr(const std::vector<symbol*> data_table, int& dtable_ptr, int numBytes)
+void advanceDtablePtr(const std::vector<symbol*>& data_table, int& dtable_ptr, int numBytes)
 {
   // Advance the dtable_ptr until it's passed the right number of entries corresponding to the expression size
   int bytesPassed = 0;
@@ -838,7 +1092,10 @@ RuntimeNode* DwarfReader::UpdateRuntime(Instruction* ins, RuntimeNode* current_r
 
   // TODO: This needs to replace tracking individual instruction stalls in IssueUnit. Do everything here.
   if(ins)
-    ins->cycles++;
+    {
+      ins->cycles++;
+      TouchPC(ins->pc_address);
+    }
   
   if(current_runtime == NULL)
     {
@@ -863,12 +1120,8 @@ RuntimeNode* DwarfReader::UpdateRuntime(Instruction* ins, RuntimeNode* current_r
       
       // Find the function call
       CompilationUnit* cu = NULL;
-      for(size_t i = 0; i < rootSource.children.size(); i++)
-	{
-	  cu = rootSource.children[i]->FindFunctionCall(ins);
-	  if(cu != NULL)
-	    break;
-	}
+      if(ins->pc_address >= 0 && ins->pc_address < (int)pcFunctionCall.size())
+	cu = pcFunctionCall[ins->pc_address];
       
       // Found no unit containing the instruction (this can happen in the preamble for example)
       // Just put it in to "main"
@@ -904,17 +1157,23 @@ RuntimeNode* DwarfReader::UpdateRuntime(Instruction* ins, RuntimeNode* current_r
 // Creates new RuntimeNodes if needed to match the most relevant CompilationUnit
 RuntimeNode* DwarfReader::MostRelevantDescendant(Instruction* ins, RuntimeNode* current)
 {
+  int pc = ins->pc_address;
+  int interval = PCInterval(pc);
+  if(interval < 0)
+    return current;
+
   for(size_t i = 0; i < current->children.size(); i++)
-    if(current->children[i]->ContainsPC(ins->pc_address))
+    if(UnitContainsPC(current->children[i]->source_node, pc))
       return MostRelevantDescendant(ins, current->children[i]);
 
   // If no existing runtime node, find the source tree node that contains the PC, and make a new runtime node
-  for(size_t i = 0; i < current->source_node->children.size(); i++)
+  // The first of current's source children in the PC's list is also the first in the tree
+  for(int i = scopeFirst[interval]; i < scopeFirst[interval + 1]; i++)
     {
-      if(current->source_node->children[i]->ContainsPC(ins->pc_address))
+      if(scopeUnits[i]->parent == current->source_node)
 	{
 	  RuntimeNode* rn = new RuntimeNode();
-	  rn->source_node = current->source_node->children[i];
+	  rn->source_node = scopeUnits[i];
 	  rn->parent = current;
 	  current->children.push_back(rn);
 	  return MostRelevantDescendant(ins, rn);
@@ -930,7 +1189,7 @@ RuntimeNode* DwarfReader::MostRelevantAncestor(Instruction* ins, RuntimeNode* cu
     return NULL;
   
   // DW_TAG_compile_units aren't functions, don't want them acting as contributors to the profile
-  if(current->ContainsPC(ins->pc_address) && (current->source_node->tag != DW_TAG_compile_unit))
+  if(UnitContainsPC(current->source_node, ins->pc_address) && (current->source_node->tag != DW_TAG_compile_unit))
     return current;
   
   if(current->parent == NULL)
@@ -140,26 +140,44 @@ class RuntimeNode
 };
 
 
+// A DWARF compile unit in the index BuildSourceTree makes. Its own entry (name, PC ranges)
+// is read up front, the entries below it only once the Profiler or Debugger reaches one of
+// its PCs, or something already read refers in to it
+struct CompileUnitIndex
+{
+  CompilationUnit* unit;
+  int start;         // address of the unit header
+  int end;           // address of the next unit's header
+  int children_addr; // address of the unit's first child entry
+  int top_unit_pc;
+  bool has_children;
+  bool read;         // children have been read
+  bool resolved;     // and their references fixed up
+  size_t first_unit; // the unit's entries in unit_list, once read
+  size_t last_unit;
+};
+
+
 class DwarfReader
 {
  public:
   DwarfReader();
   
-  bool BuildSourceTree(const std::vector<symbol*> labels, std::vector<symbol*> elf_vars, 
-		       const std::vector<symbol*> data_table, const char* jump_table, 
+  bool BuildSourceTree(const std::vector<symbol*>& labels, const std::vector<symbol*>& elf_vars, 
+		       const std::vector<symbol*>& data_table, const char* jump_table, 
 		       int jtable_size, int debug_start, int debug_end, int abbrev_start);
 
-  CompilationUnit* ReadCompilationUnit(const std::vector<symbol*> labels, std::vector<symbol*> elf_vars, 
-				      const std::vector<symbol*> data_table, const char* jump_table, 
-				      int jtable_size, int& current_addr, 
-				      int debug_start, int debug_end, int abbrev_start, int top_unit_start,
-				      int top_unit_pc);
+  // Reads one entry and, unless pending_children is given, everything below it. With
+  // pending_children the children are left for ReadChildren, starting at current_addr
+  CompilationUnit* ReadCompilationUnit(int& current_addr, int top_unit_start, int top_unit_pc,
+				       bool* pending_children = NULL);
+  void ReadChildren(CompilationUnit* parent, int& current_addr, int top_unit_start, int top_unit_pc);
 
   void MergeInto(CompilationUnit* from, CompilationUnit* into);
 
   bool ReadAttribute(CompilationUnit* retval, unsigned int attribute, unsigned int type, 
 		     int debug_start, const char* jump_table, int& current_addr, 
-		     const std::vector<symbol*> data_table, int& dtable_ptr,
+		     const std::vector<symbol*>& data_table, int& dtable_ptr,
 		     int top_unit_pc);
 
   void ReadUnitHeader(int& unit_length, const char* jump_table, int& current_addr);
@@ -168,18 +186,59 @@ class DwarfReader
 
   void AddUnitList(CompilationUnit* cu);
 
+  // Index of the data_table entry at addr, or -1
+  int FindDataEntry(int addr);
+
+  // Lazy reading of compile units
+  void ReadUnitChildren(size_t cu);
+  void Materialize(size_t cu);
+  void MaterializeAll();
+  // Makes sure everything containing pc has been read, and pcFunctionCall[pc] is set
+  void TouchPC(int pc);
+  // The entry at a .debug_info address, reading its compile unit if needed. NULL if none
+  CompilationUnit* FindUnit(int addr);
+  void PrintMemoryUse();
+
   void WriteDot(const char* filename);
   void WriteDotRecursive(FILE* output, CompilationUnit* node);
 
   RuntimeNode* UpdateRuntime(Instruction* ins, RuntimeNode* current_runtime, char stall_type = 0);
-  static RuntimeNode* MostRelevantAncestor(Instruction* ins, RuntimeNode* current);
-  static RuntimeNode* MostRelevantDescendant(Instruction* ins, RuntimeNode* current);
+  RuntimeNode* MostRelevantAncestor(Instruction* ins, RuntimeNode* current);
+  RuntimeNode* MostRelevantDescendant(Instruction* ins, RuntimeNode* current);
+
+  // PC lookup tables, rebuilt after more of the source tree is read (TouchPC, BuildSourceTree)
+  // so that UpdateRuntime doesn't have to search the tree's ranges on every issue
+  void BuildPCIndex();
+  int PCInterval(int pc);
+  bool UnitContainsPC(CompilationUnit* cu, int pc);
 
   CompilationUnit rootSource;
   RuntimeNode* rootRuntime;
   std::vector<AbbreviationCode>abbrevCodes;
+  // abbrevCodes index of each code, or -1
+  std::vector<int> abbrevIndex;
   std::vector<CompilationUnit*> unit_list;
   std::map<int, CompilationUnit*> unitsByAddress;
+  std::vector<CompileUnitIndex> compileUnits;
+
+  // What entries are read from (the assembler keeps these for the whole run)
+  std::vector<symbol*> dataTable;
+  const char* jumpTable;
+  int debugStart;
+  int debugEnd;
+
+  // PC -> units whose ranges contain it, as a sorted array of intervals: interval i
+  // starts at scopeStarts[i] and ends where i+1 starts, and its units (in unit_list order,
+  // so siblings keep their order in the source tree) are
+  // scopeUnits[scopeFirst[i] .. scopeFirst[i+1])
+  std::vector<int> scopeStarts;
+  std::vector<int> scopeFirst;
+  std::vector<CompilationUnit*> scopeUnits;
+  // Set when a compile unit is read, until the tables above are rebuilt
+  bool pcIndexDirty;
+  // For each PC, the result of FindFunctionCall on the top level units, filled in by TouchPC
+  std::vector<CompilationUnit*> pcFunctionCall;
+  std::vector<char> pcTouched;
 };
 
 
@@ -116,6 +116,11 @@ bool FPAddSub::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadStat
   return true;
 }
 
+void FPAddSub::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void FPAddSub::ClockRise()
 {
@@ -273,6 +273,11 @@ bool FPCompare::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadSta
   return true;
 }
 
+void FPCompare::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void FPCompare::ClockRise()
 {
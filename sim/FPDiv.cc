@@ -216,6 +216,11 @@ bool FPDiv::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState*
   return true;
 }
 
+void FPDiv::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void FPDiv::ClockRise()
 {
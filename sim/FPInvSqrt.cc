@@ -65,6 +65,11 @@ bool FPInvSqrt::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadSta
   return true;
 }
 
+void FPInvSqrt::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void FPInvSqrt::ClockRise()
 {
@@ -73,6 +73,11 @@ bool FPMinMax::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadStat
   return true;
 }
 
+void FPMinMax::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void FPMinMax::ClockRise()
 {
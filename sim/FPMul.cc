@@ -122,6 +122,11 @@ bool FPMul::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState*
   return true;
 }
 
+void FPMul::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void FPMul::ClockRise()
 {
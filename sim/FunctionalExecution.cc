@@ -0,0 +1,184 @@
+#include "FunctionalExecution.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "IssueUnit.h"
+#include "L1Cache.h"
+#include "L2Cache.h"
+#include "ThreadState.h"
+#include "SimpleRegisterFile.h"
+#include "FunctionalUnit.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Loads, stores and atomic adds that the L1 would normally handle. They operate
+// directly on memory, so they never wait on the L2 or usimm.
+static void MemoryOp(Instruction& ins, IssueUnit* issuer, ThreadState* thread, MainMemory* memory,
+		     L1Cache* warm_L1)
+{
+  reg_value arg0, arg1, result;
+  Instruction::Opcode failop;
+  int base_reg = ins.op == Instruction::STORE || ins.op == Instruction::ATOMIC_FPADD ? 0 : 1;
+  thread->ReadRegister(ins.args[base_reg], issuer->current_cycle, arg0, failop);
+  int address = arg0.idata + ins.args[2];
+  if (address < 0 || address >= memory->num_blocks) {
+    printf("ERROR: MEMORY FAULT.  REQUEST FOR %s OF ADDRESS %d (not in [0, %d])\n",
+	   Instruction::Opnames[ins.op].c_str(), address, memory->num_blocks);
+    exit(1);
+  }
+
+  switch (ins.op) {
+  case Instruction::LOAD:
+    if (warm_L1) {
+      warm_L1->L2->Warm(address);
+      warm_L1->Warm(address);
+    }
+    result.udata = memory->data[address].uvalue;
+    thread->QueueWrite(ins.args[0], result, issuer->current_cycle, ins.op, &ins);
+    break;
+  case Instruction::LOADL1:
+    // there is no cache, everything counts as a hit
+    result.idata = 1;
+    thread->QueueWrite(ins.args[0], result, issuer->current_cycle, ins.op, &ins);
+    break;
+  case Instruction::STORE:
+    thread->ReadRegister(ins.args[1], issuer->current_cycle, arg1, failop);
+    memory->data[address].uvalue = arg1.udata;
+    memory->store_count++;
+    break;
+  default: // ATOMIC_FPADD
+    thread->ReadRegister(ins.args[1], issuer->current_cycle, arg1, failop);
+    memory->data[address].fvalue += arg1.fdata;
+    break;
+  }
+}
+
+// Executes one instruction. Returns false if it could not execute yet (a barrier),
+// in which case it stays fetched and is retried on the thread's next turn.
+static bool Execute(Instruction& ins, IssueUnit* issuer, ThreadState* thread,
+		    FunctionalUnit** op_units, MainMemory* memory, L1Cache* warm_L1)
+{
+  switch (ins.op) {
+  case Instruction::NOP:
+  case Instruction::nop:
+  case Instruction::SYNC:
+  case Instruction::SLEEP:
+  case Instruction::PROF:
+  case Instruction::SETTRIPIPE:
+  case Instruction::SETBOXPIPE:
+    // timing and profiling only
+    return true;
+  case Instruction::HALT:
+    thread->halted = true;
+    return true;
+  case Instruction::LOAD:
+  case Instruction::LOADL1:
+  case Instruction::STORE:
+  case Instruction::ATOMIC_FPADD:
+    MemoryOp(ins, issuer, thread, memory, warm_L1);
+    return true;
+  default:
+    break;
+  }
+
+  FunctionalUnit* unit = op_units[ins.op];
+  if (unit == NULL)
+    unit = thread->registers;
+  if (!unit->AcceptInstruction(ins, issuer, thread)) {
+    // Only the unit's per-cycle issue width is in the way, lift it and try again
+    unit->ResetIssueLimit();
+    if (!unit->AcceptInstruction(ins, issuer, thread))
+      return false;
+  }
+  if (ins.op == Instruction::ATOMIC_INC)
+    issuer->atominc_bins[issuer->current_proc_id]++;
+  return true;
+}
+
+long long int FunctionalExecution(std::vector<TraxCore*>& cores, MainMemory* memory,
+				  long long int max_instructions, bool warm_caches)
+{
+  if (max_instructions < 0)
+    printf("Cores 0 through %d running (functional execution mode)\n", (int)cores.size() - 1);
+
+  // Which of the core's units executes each op (NULL for register file ops)
+  std::vector<FunctionalUnit**> op_units(cores.size());
+  for (size_t c = 0; c < cores.size(); c++) {
+    IssueUnit* issuer = cores[c]->issuer;
+    op_units[c] = new FunctionalUnit*[Instruction::NUM_OPS];
+    for (int op = 0; op < Instruction::NUM_OPS; op++) {
+      op_units[c][op] = NULL;
+      for (size_t i = 0; i < issuer->units.size(); i++) {
+	if (issuer->units[i]->SupportsOp((Instruction::Opcode)op)) {
+	  op_units[c][op] = issuer->units[i];
+	  break;
+	}
+      }
+    }
+  }
+
+  long long int executed = 0;
+  bool all_halted = false;
+  while (!all_halted && (max_instructions < 0 || executed < max_instructions)) {
+    all_halted = true;
+    bool progress = false;
+    for (size_t c = 0; c < cores.size(); c++) {
+      IssueUnit* issuer = cores[c]->issuer;
+      if (issuer->halted)
+	continue;
+      bool core_halted = true;
+      for (size_t p = 0; p < cores[c]->thread_procs.size(); p++) {
+	ThreadProcessor* tp = cores[c]->thread_procs[p];
+	issuer->current_proc_id = (int)p;
+	for (int t = 0; t < tp->num_threads; t++) {
+	  ThreadState* thread = tp->thread_states[t];
+	  for (int n = 0; n < FUNCTIONAL_QUANTUM && !thread->halted; n++) {
+	    if (max_instructions >= 0 && executed >= max_instructions)
+	      break;
+	    // fetch the same way IssueUnit does, so branch delay slots behave the same
+	    if (thread->fetched_instruction == NULL) {
+	      if (thread->program_counter < 0) {
+		printf("Error: invalid program counter: %lld\n", thread->program_counter);
+		exit(1);
+	      }
+	      thread->fetched_instruction = thread->instructions[thread->program_counter];
+	      thread->program_counter = thread->next_program_counter;
+	      thread->next_program_counter++;
+	      thread->fetched_instruction->id = thread->instruction_id++;
+	    }
+	    Instruction* ins = thread->fetched_instruction;
+	    if (!Execute(*ins, issuer, thread, op_units[c], memory,
+			 warm_caches ? cores[c]->L1 : NULL))
+	      break;
+	    // no write latencies, results are visible to the very next instruction
+	    thread->ApplyWrites(LLONG_MAX);
+	    // the queue is empty again, rewind it so the same few entries stay in cache
+	    thread->write_requests.head = thread->write_requests.tail = 0;
+	    // a HALT stays fetched, that is how the issue unit waits for the other threads
+	    if (!thread->halted)
+	      thread->fetched_instruction = NULL;
+	    thread->instructions_issued++;
+	    issuer->instruction_bins[ins->op]++;
+	    executed++;
+	    progress = true;
+	  }
+	  if (!thread->halted)
+	    core_halted = false;
+	}
+      }
+      if (core_halted)
+	issuer->HaltSystem();
+      else
+	all_halted = false;
+    }
+    if (!all_halted && !progress) {
+      printf("Error: functional execution deadlocked, no thread can make progress\n");
+      exit(1);
+    }
+  }
+
+  for (size_t c = 0; c < cores.size(); c++)
+    delete [] op_units[c];
+
+  return executed;
+}
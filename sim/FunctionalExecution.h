@@ -0,0 +1,24 @@
+#ifndef _SIMHWRT_FUNCTIONAL_EXECUTION_H_
+#define _SIMHWRT_FUNCTIONAL_EXECUTION_H_
+
+// Functional-only execution ("--functional"). Runs the program on every thread with
+// no timing model: each instruction's result is written back as soon as it executes,
+// and loads/stores go straight to memory without the caches or DRAM model.
+// Opcode semantics come from the same functional units the cycle-accurate path uses.
+
+#include <vector>
+
+// instructions a thread runs before the next thread gets a turn
+#define FUNCTIONAL_QUANTUM 1000
+
+class TraxCore;
+class MainMemory;
+
+// Runs until every thread halts, or until about max_instructions have executed (-1 for no limit).
+// Returns the number of instructions executed. With warm_caches, loads install their lines in
+// the L1 and L2 so a following cycle-accurate run starts with realistic cache contents.
+// Threads are left so the cycle-accurate path can pick up where this stopped.
+long long int FunctionalExecution(std::vector<TraxCore*>& cores, MainMemory* memory,
+				  long long int max_instructions = -1, bool warm_caches = false);
+
+#endif // _SIMHWRT_FUNCTIONAL_EXECUTION_H_
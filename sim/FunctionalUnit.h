@@ -29,6 +29,10 @@ class FunctionalUnit : public HardwareModule {
   // If you can handle this instruction now, return true else false
   // You can assume that SupportsOps(ins.op) == true
   virtual bool AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread) { return false; };
+  // Lifts the unit's per-cycle issue limit without clocking it. The engines with no timing
+  // model (--functional, the sampler's fast-forward) call this when the unit turns an
+  // instruction away, and then retry it
+  virtual void ResetIssueLimit() {}
 };
 
 
@@ -1,4 +1,5 @@
 #include "GlobalRegisterFile.h"
+#include "DeterministicExecution.h"
 //#include "SimpleRegisterFile.h"
 #include "IssueUnit.h"
 #include "ThreadState.h"
@@ -24,7 +25,11 @@ GlobalRegisterFile::GlobalRegisterFile(int num_regs, unsigned int sys_threads, u
   //current_cycle = 0;
   latency = 1;
   issued_this_cycle = 0;
+  last_issuer = NULL;
+  last_issue_cycle = -1;
   last_report_cycle = 0;
+  area = 0;
+  energy = 0;
 }
 
 GlobalRegisterFile::~GlobalRegisterFile()
@@ -38,6 +43,8 @@ void GlobalRegisterFile::Reset()
     udata[i] = 0;
 
   issued_this_cycle = 0;
+  last_issuer = NULL;
+  last_issue_cycle = -1;
   last_report_cycle = 0;
 }
 
@@ -102,6 +109,12 @@ bool GlobalRegisterFile::AcceptInstruction(Instruction& ins, IssueUnit* issuer,
 #else
   static time_t start_time;
 #endif
+  DeterministicGate(thread->core_id);
+  if (issuer != last_issuer || issuer->current_cycle != last_issue_cycle) {
+    issued_this_cycle = 0;
+    last_issuer = issuer;
+    last_issue_cycle = issuer->current_cycle;
+  }
   if (issued_this_cycle >= 1) return false;
   int write_reg = ins.args[0];
   long long int write_cycle = issuer->current_cycle + latency;
@@ -293,13 +306,17 @@ bool GlobalRegisterFile::AcceptInstruction(Instruction& ins, IssueUnit* issuer,
   return true;
 }
 
+void GlobalRegisterFile::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void GlobalRegisterFile::ClockRise() {}
 
 void GlobalRegisterFile::ClockFall()
 {
-  // needs fixing
-  issued_this_cycle = 0;
+  // issued_this_cycle is reset by the next issuer (see AcceptInstruction), or by ResetIssueLimit
 }
 
 void GlobalRegisterFile::print()
@@ -26,6 +26,7 @@ class GlobalRegisterFile : public FunctionalUnit {
 
   virtual bool SupportsOp(Instruction::Opcode op) const;
   virtual bool AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread);
+  virtual void ResetIssueLimit();
 
   // From HardwareModule
   virtual void ClockRise();
@@ -38,7 +39,10 @@ class GlobalRegisterFile : public FunctionalUnit {
     unsigned int* udata;
     float* fdata;
   };
+  // one issue per TM per cycle, tracked by issuer so other TMs' clocks don't reset it
   int issued_this_cycle;
+  IssueUnit* last_issuer;
+  long long int last_issue_cycle;
   unsigned int total_system_threads;
   unsigned int last_report_cycle;
   unsigned int report_period;
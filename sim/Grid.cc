@@ -1,11 +1,12 @@
 #include "Grid.h"
 
 #include <cstdlib>
+#include <pthread.h>
 
 using namespace simtrax;
 double epsilon = 0.0001;
 
-Grid::Grid(std::vector<Triangle*>* _triangles,  bool tris_store_edges, int dim)
+Grid::Grid(std::vector<Triangle*>* _triangles,  bool tris_store_edges, int dim, int _num_threads)
 {
   triangles_store_points = !tris_store_edges;
   triangles = _triangles;
@@ -16,18 +17,31 @@ Grid::Grid(std::vector<Triangle*>* _triangles,  bool tris_store_edges, int dim)
     // TODO: auto-calculate the dimensions (method in thiago's thesis)
   }
   dimensions = dim;
-  cells = new std::vector<int>[dimensions*dimensions*dimensions];
-  // cells = (std::vector<Triangle*>*)malloc(sizeof(std::vector<Triangle*>)*dimensions*dimensions*dimensions);
-  if(!cells)
+  num_cells = dimensions*dimensions*dimensions;
+  num_threads = _num_threads;
+  // need at least 1, and no more than 1 per triangle
+  if(num_threads > (int)triangles->size())
+    num_threads = (int)triangles->size();
+  if(num_threads < 1)
+    num_threads = 1;
+  cell_offsets = new int[num_cells + 1];
+  cell_tris = NULL;
+  if(!cell_offsets)
     {
       printf("Grid: Error - malloc failed\n");
       exit(1);
     }
-  printf("preprocessing grid...\n");
+  printf("preprocessing grid (%d threads)...\n", num_threads);
   Preprocess();
   printf("done\n");
 }
 
+Grid::~Grid()
+{
+  delete [] cell_offsets;
+  delete [] cell_tris;
+}
+
 void Grid::LoadIntoMemory(int &memory_position,
 			  int max_memory,
 			  FourByte* memory)
@@ -59,27 +73,31 @@ void Grid::LoadIntoMemory(int &memory_position,
   // load grid cells (triangle count and pointers to triangles)
   int grid_base_address = memory_position;
   memory_position += dimensions*dimensions*dimensions*2;
-  for(i=0; i<dimensions*dimensions*dimensions; i++)
+  int start_pointers = memory_position;
+  for(i=0; i<num_cells; i++)
     {
-      memory[grid_base_address].ivalue = cells[i].size();
-      memory[grid_base_address+1].ivalue = memory_position;
-
-      // load triangle pointers for this grid cell
-      for(j=0; j<cells[i].size(); j++)
-	{
-	  memory[memory_position].ivalue = start_triangles + (cells[i].at(j) * 11);
-	  memory_position++;
-	}
+      memory[grid_base_address].ivalue = cell_offsets[i+1] - cell_offsets[i];
+      memory[grid_base_address+1].ivalue = start_pointers + cell_offsets[i];
       grid_base_address+=2;
     }
+
+  // load triangle pointers for all grid cells, already in cell order
+  for(i=0; i<cell_offsets[num_cells]; i++)
+    {
+      memory[memory_position].ivalue = start_triangles + (cell_tris[i] * 11);
+      memory_position++;
+    }
 }
 
 void Grid::Preprocess()
 {
-  if(triangles->size()==0)
-    return;
-  double minx, miny, minz, maxx, maxy, maxz, xrange, yrange, zrange;
   int i;
+  if(triangles->size()==0)
+    {
+      for(i=0; i<=num_cells; i++)
+	cell_offsets[i] = 0;
+      return;
+    }
 
   // compute bounding volume for entire grid
   bounds = GetTriangleBoundingBox(*triangles->at(0), triangles_store_points);
@@ -92,56 +110,143 @@ void Grid::Preprocess()
   diagonal = bounds.box_max-bounds.box_min;
   cellSize = diagonal/(double)dimensions;
 
-  minx = bounds.box_min.x();
-  miny = bounds.box_min.y();
-  minz = bounds.box_min.z();
-  maxx = bounds.box_max.x();
-  maxy = bounds.box_max.y();
-  maxz = bounds.box_max.z();
-  xrange = maxx-minx;
-  yrange = maxy-miny;
-  zrange = maxz-minz;
+  // Two pass build: each thread counts the cells overlapped by its block of triangles,
+  // a prefix sum turns the counts in to CSR offsets, then each thread scatters its triangle IDs.
+  // Each thread gets its own range within every cell, so cells list triangles in ascending order
+  // and the result is identical for any number of threads.
+  tri_ranges = new int[triangles->size() * 6];
+  thread_counts = new int[num_threads * num_cells];
+  for(i=0; i<num_threads * num_cells; i++)
+    thread_counts[i] = 0;
 
-  
-  
+  RunBuildPass(false);
 
-  for(i=0; i<(int)(triangles->size()); i++)
+  int total = 0;
+  for(i=0; i<num_cells; i++)
+    {
+      cell_offsets[i] = total;
+      for(int t=0; t<num_threads; t++)
+	{
+	  int count = thread_counts[t * num_cells + i];
+	  thread_counts[t * num_cells + i] = total;
+	  total += count;
+	}
+    }
+  cell_offsets[num_cells] = total;
+  cell_tris = new int[total > 0 ? total : 1];
+
+  RunBuildPass(true);
+
+  delete [] thread_counts;
+  delete [] tri_ranges;
+}
+
+// Splits the triangles in to one contiguous block per thread and runs a build pass on each
+void Grid::RunBuildPass(bool scatter)
+{
+  int num_tris = (int)triangles->size();
+  GridBuildArgs *args = new GridBuildArgs[num_threads];
+  pthread_t *threadids = new pthread_t[num_threads];
+  for(int t=0; t<num_threads; t++)
+    {
+      args[t].grid = this;
+      args[t].thread_num = t;
+      args[t].tri_begin = (int)((long long int)num_tris * t / num_threads);
+      args[t].tri_end = (int)((long long int)num_tris * (t+1) / num_threads);
+      args[t].scatter = scatter;
+    }
+
+  if(num_threads == 1)
+    BuildThread(&args[0]);
+  else
+    {
+      for(int t=0; t<num_threads; t++)
+	pthread_create(&threadids[t], NULL, BuildThread, (void *)&args[t]);
+      for(int t=0; t<num_threads; t++)
+	pthread_join(threadids[t], NULL);
+    }
+
+  delete [] threadids;
+  delete [] args;
+}
+
+void* Grid::BuildThread(void* args)
+{
+  GridBuildArgs* build_args = static_cast<GridBuildArgs*>(args);
+  if(build_args->scatter)
+    build_args->grid->ScatterCells(build_args->thread_num, build_args->tri_begin, build_args->tri_end);
+  else
+    build_args->grid->CountCells(build_args->thread_num, build_args->tri_begin, build_args->tri_end);
+  return 0;
+}
+
+void Grid::CountCells(int thread_num, int tri_begin, int tri_end)
+{
+  int *counts = thread_counts + thread_num * num_cells;
+  for(int i=tri_begin; i<tri_end; i++)
+    {
+      ComputeTriangleRange(i);
+      int *r = tri_ranges + i*6;
+      for(int j=r[0]; j<=r[1]; j++)
+	for(int k=r[2]; k<=r[3]; k++)
+	  for(int l=r[4]; l<=r[5]; l++)
+	    counts[cellindex(j, k, l)]++;
+    }
+}
+
+void Grid::ScatterCells(int thread_num, int tri_begin, int tri_end)
+{
+  // after the prefix sum, these are this thread's next free slot in each cell
+  int *positions = thread_counts + thread_num * num_cells;
+  for(int i=tri_begin; i<tri_end; i++)
     {
-	  Box b = GetTriangleBoundingBox(*triangles->at(i), triangles_store_points);
-      int Lx, Hx, Ly, Hy, Lz, Hz;
-      Lx = (int)floor((((b.box_min.x()-minx)/xrange))*double(dimensions));
-      Ly = (int)floor((((b.box_min.y()-miny)/yrange))*double(dimensions));
-      Lz = (int)floor((((b.box_min.z()-minz)/zrange))*double(dimensions));
-
-      Hx = (int)floor((((b.box_max.x()-minx)/xrange))*double(dimensions));
-      Hy = (int)floor((((b.box_max.y()-miny)/yrange))*double(dimensions));
-      Hz = (int)floor((((b.box_max.z()-minz)/zrange))*double(dimensions));
-      
-      if(Lx==dimensions)
-	Lx--;
-      if(Ly==dimensions)
-	Ly--;
-      if(Lz==dimensions)
-	Lz--;
-      if(Hx==dimensions)
-	Hx--;
-      if(Hy==dimensions)
-	Hy--;
-      if(Hz==dimensions)
-	Hz--;
-
-      int j, k, l;
-      for(j=Lx; j<=Hx; j++)
-	for(k=Ly; k<=Hy; k++)
-	  for(l=Lz; l<=Hz; l++)
-	    {
-	      fflush(stdout);
-	      AddTriangleToCell(i, j, k, l);
-	      fflush(stdout);
-	    }
+      int *r = tri_ranges + i*6;
+      for(int j=r[0]; j<=r[1]; j++)
+	for(int k=r[2]; k<=r[3]; k++)
+	  for(int l=r[4]; l<=r[5]; l++)
+	    cell_tris[positions[cellindex(j, k, l)]++] = i;
     }
 }
 
+// Finds the range of cells overlapped by a triangle's bounding box
+void Grid::ComputeTriangleRange(int tri)
+{
+  double minx = bounds.box_min.x();
+  double miny = bounds.box_min.y();
+  double minz = bounds.box_min.z();
+  double xrange = bounds.box_max.x()-minx;
+  double yrange = bounds.box_max.y()-miny;
+  double zrange = bounds.box_max.z()-minz;
+
+  Box b = GetTriangleBoundingBox(*triangles->at(tri), triangles_store_points);
+  int Lx, Hx, Ly, Hy, Lz, Hz;
+  Lx = (int)floor((((b.box_min.x()-minx)/xrange))*double(dimensions));
+  Ly = (int)floor((((b.box_min.y()-miny)/yrange))*double(dimensions));
+  Lz = (int)floor((((b.box_min.z()-minz)/zrange))*double(dimensions));
+
+  Hx = (int)floor((((b.box_max.x()-minx)/xrange))*double(dimensions));
+  Hy = (int)floor((((b.box_max.y()-miny)/yrange))*double(dimensions));
+  Hz = (int)floor((((b.box_max.z()-minz)/zrange))*double(dimensions));
+
+  if(Lx==dimensions)
+    Lx--;
+  if(Ly==dimensions)
+    Ly--;
+  if(Lz==dimensions)
+    Lz--;
+  if(Hx==dimensions)
+    Hx--;
+  if(Hy==dimensions)
+    Hy--;
+  if(Hz==dimensions)
+    Hz--;
+
+  int *r = tri_ranges + tri*6;
+  r[0] = Lx; r[1] = Hx;
+  r[2] = Ly; r[3] = Hy;
+  r[4] = Lz; r[5] = Hz;
+}
+
 void Grid::ExtendBoundsByTriangle(const Triangle& tri, const bool &tri_store_pts) 
 {
 	if( tri_store_pts ) {
@@ -216,8 +321,3 @@ Box Grid::GetTriangleBoundingBox(const Triangle& tri, const bool &tri_store_pts)
   retval.box_max.setZ(max(max(p0z, tri.p1.z()), p2z) + epsilon);
   return retval;
 }
-
-void Grid::AddTriangleToCell(int addr, int x, int y, int z)
-{
-  cells[cellindex(x, y, z)].push_back(addr);
-}
@@ -16,9 +16,28 @@ struct Box
   Vector3 box_max;
 };
 
+class Grid;
+
+// Argument struct for one grid build thread
+struct GridBuildArgs {
+  Grid* grid;
+  int thread_num;
+  int tri_begin;
+  int tri_end;
+  bool scatter; // false: count pass, true: scatter pass
+};
+
 class Grid : public simtrax::Primitive {
   int dimensions;
-  std::vector<int> *cells;
+  int num_cells;
+  int num_threads;
+  // Cells are stored CSR style: cell i holds triangle IDs cell_tris[cell_offsets[i]] to cell_tris[cell_offsets[i+1]-1]
+  int *cell_offsets;
+  int *cell_tris;
+  // Per-thread cell counts during the build (num_threads * num_cells), turned in to each thread's scatter position
+  int *thread_counts;
+  // Cell range [Lx Hx Ly Hy Lz Hz] overlapped by each triangle's bounding box
+  int *tri_ranges;
   std::vector<simtrax::Triangle*>* triangles;
   Box bounds;
   Vector3 diagonal;
@@ -29,7 +48,11 @@ class Grid : public simtrax::Primitive {
   // tri_store_pts = false -> triangles storing edge vectors (center pt + vectors to other 2)
   void ExtendBoundsByTriangle(const simtrax::Triangle& tri, const bool &tri_store_pts=true);
   Box GetTriangleBoundingBox(const simtrax::Triangle& tri, const bool &tri_store_pts=true);
-  void AddTriangleToCell(int addr, int x, int y, int z);
+  void ComputeTriangleRange(int tri);
+  void CountCells(int thread_num, int tri_begin, int tri_end);
+  void ScatterCells(int thread_num, int tri_begin, int tri_end);
+  void RunBuildPass(bool scatter);
+  static void* BuildThread(void* args);
 
   int cellindex(int x, int y, int z)
   {
@@ -39,7 +62,9 @@ class Grid : public simtrax::Primitive {
 
 
  public:
-  Grid(std::vector<simtrax::Triangle*>* _triangles, bool tris_store_edges=false, int dim=0); // if no dim passed, auto calculate
+  Grid(std::vector<simtrax::Triangle*>* _triangles, bool tris_store_edges=false, int dim=0, // if no dim passed, auto calculate
+       int _num_threads=1);
+  ~Grid();
   void LoadIntoMemory(int &memory_position, int max_memory, FourByte* memory);
 
   
@@ -0,0 +1,104 @@
+#include "HostProfiler.h"
+#include "Sampler.h"
+#include <stdio.h>
+
+static const char* phase_names[NUM_HOST_PHASES] = {
+  "TM clocking",
+  "Barrier wait",
+  "L2 clocking",
+  "DRAM (usimm)",
+  "Stats tracking",
+};
+
+static const char* step_names[NUM_HOST_STEPS] = {
+  "Setup",
+  "Simulation",
+  "Image output",
+  "Profile output",
+};
+
+HostProfiler::HostProfiler(int num_threads, double _report_period) :
+  times(num_threads), report_period(_report_period)
+{
+  for (int i = 0; i < num_threads; i++) {
+    for (int p = 0; p < NUM_HOST_PHASES; p++)
+      times[i].seconds[p] = 0.;
+    times[i].num_cores = 0;
+  }
+  for (int s = 0; s < NUM_HOST_STEPS; s++)
+    step_seconds[s] = 0.;
+  last_report = boost::chrono::steady_clock::now();
+  last_report_cycle = 0;
+  last_report_instructions = 0;
+}
+
+void HostProfiler::BeginStep(HostStep step)
+{
+  step_start[step] = boost::chrono::steady_clock::now();
+}
+
+void HostProfiler::EndStep(HostStep step)
+{
+  step_seconds[step] += boost::chrono::duration<double>(boost::chrono::steady_clock::now() - step_start[step]).count();
+}
+
+void HostProfiler::Progress(long long int cycle, std::vector<TraxCore*>& cores)
+{
+  if (report_period <= 0.)
+    return;
+  boost::chrono::steady_clock::time_point now = boost::chrono::steady_clock::now();
+  double elapsed = boost::chrono::duration<double>(now - last_report).count();
+  if (elapsed < report_period)
+    return;
+
+  long long int instructions = CountInstructions(cores);
+  printf("Host: cycle %lld, %.0f cycles/s, %.0f instructions/s\n", cycle,
+	 (cycle - last_report_cycle) / elapsed, (instructions - last_report_instructions) / elapsed);
+  fflush(stdout);
+  last_report = now;
+  last_report_cycle = cycle;
+  last_report_instructions = instructions;
+}
+
+void HostProfiler::PrintSummary(long long int cycles, long long int instructions)
+{
+  double simulation = step_seconds[HOST_SIMULATION];
+  printf("Host performance:\n");
+  printf("   Simulated cycles/s: \t\t %.0f\n", simulation > 0. ? cycles / simulation : 0.);
+  printf("   Simulated instructions/s: \t %.0f\n", simulation > 0. ? instructions / simulation : 0.);
+  for (int s = 0; s < NUM_HOST_STEPS; s++)
+    printf("   %-16s\t\t %.3f s\n", step_names[s], step_seconds[s]);
+
+  // Phases summed over threads, as a share of all simulation-thread time
+  double total = 0.;
+  double phase_totals[NUM_HOST_PHASES];
+  for (int p = 0; p < NUM_HOST_PHASES; p++) {
+    phase_totals[p] = 0.;
+    for (size_t i = 0; i < times.size(); i++)
+      phase_totals[p] += times[i].seconds[p];
+    total += phase_totals[p];
+  }
+  if (total <= 0.) {
+    printf("\n");
+    return;
+  }
+  printf("   Simulation thread time by phase:\n");
+  for (int p = 0; p < NUM_HOST_PHASES; p++)
+    printf("      %-16s\t %.3f s\t(%.2f%%)\n", phase_names[p], phase_totals[p], 100. * phase_totals[p] / total);
+
+  // Load balance: a thread that spends less time clocking TMs waits for the others
+  if (times.size() > 1) {
+    double max_clock = 0., sum_clock = 0.;
+    printf("   Simulation thread load:\n");
+    for (size_t i = 0; i < times.size(); i++) {
+      double clock = times[i].seconds[HOST_TM_CLOCK];
+      printf("      Thread %d (%d TMs): \t %.3f s clocking, %.3f s waiting\n", (int)i, times[i].num_cores,
+	     clock, times[i].seconds[HOST_BARRIER]);
+      sum_clock += clock;
+      if (clock > max_clock)
+	max_clock = clock;
+    }
+    printf("   Load imbalance (max/mean): \t %.3f\n", sum_clock > 0. ? max_clock * times.size() / sum_clock : 0.);
+  }
+  printf("\n");
+}
@@ -0,0 +1,75 @@
+#ifndef _SIMHWRT_HOST_PROFILER_H_
+#define _SIMHWRT_HOST_PROFILER_H_
+
+// Host-side performance of the simulator itself ("--host-profile"). Reports simulated
+// cycles and instructions per host second while running and at the end, and splits each
+// simulation thread's time into the phases of a cycle. Meant for spotting simulator
+// regressions and choosing --simulation-threads, not for anything about the TRaX design.
+
+#include <boost/chrono.hpp>
+#include <vector>
+
+class TraxCore;
+
+enum HostPhase {
+  HOST_TM_CLOCK = 0, // clocking this thread's TMs (includes --profile bookkeeping)
+  HOST_BARRIER,      // waiting for the other simulation threads
+  HOST_L2_CLOCK,
+  HOST_DRAM,
+  HOST_STATS,        // utilization tracking and --interval-stats
+  NUM_HOST_PHASES
+};
+
+// Main-thread work outside the cycle loop
+enum HostStep {
+  HOST_SETUP = 0,
+  HOST_SIMULATION,
+  HOST_IMAGE_OUTPUT,
+  HOST_PROFILE_OUTPUT,
+  NUM_HOST_STEPS
+};
+
+// One per simulation thread, padded so threads don't share cache lines
+struct HostThreadTimes {
+  boost::chrono::steady_clock::time_point mark;
+  double seconds[NUM_HOST_PHASES];
+  int num_cores;
+  char padding[64];
+};
+
+class HostProfiler {
+public:
+  HostProfiler(int num_threads, double report_period);
+
+  // Starts timing on a simulation thread
+  void Start(int thread) {
+    times[thread].mark = boost::chrono::steady_clock::now();
+  }
+  // Charges the time since the last Start or Lap on this thread to 'phase'
+  void Lap(int thread, HostPhase phase) {
+    boost::chrono::steady_clock::time_point now = boost::chrono::steady_clock::now();
+    times[thread].seconds[phase] += boost::chrono::duration<double>(now - times[thread].mark).count();
+    times[thread].mark = now;
+  }
+
+  void BeginStep(HostStep step);
+  void EndStep(HostStep step);
+
+  // Called by a single thread while the others are stopped. Prints a progress line
+  // whenever report_period seconds have passed since the last one.
+  void Progress(long long int cycle, std::vector<TraxCore*>& cores);
+
+  void PrintSummary(long long int cycles, long long int instructions);
+
+  std::vector<HostThreadTimes> times;
+  double report_period;
+
+  double step_seconds[NUM_HOST_STEPS];
+  boost::chrono::steady_clock::time_point step_start[NUM_HOST_STEPS];
+
+  boost::chrono::steady_clock::time_point last_report;
+  long long int last_report_cycle;
+  long long int last_report_instructions;
+};
+
+#endif // _SIMHWRT_HOST_PROFILER_H_
@@ -0,0 +1,109 @@
+#include "IncrementalOutput.h"
+#include "lodepng.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+IncrementalOutput::IncrementalOutput(int _image_width, int _image_height)
+{
+  image_width = _image_width;
+  image_height = _image_height;
+  done = false;
+  images_written = 0;
+  images_dropped = 0;
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&cond, NULL);
+  if (pthread_create(&thread, NULL, Run, this) != 0) {
+    perror("Unable to start incremental output thread");
+    exit(1);
+  }
+}
+
+IncrementalOutput::~IncrementalOutput()
+{
+  pthread_mutex_lock(&mutex);
+  done = true;
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&mutex);
+  pthread_join(thread, NULL);
+
+  printf("Wrote %d incremental output images", images_written);
+  if (images_dropped > 0)
+    printf(", dropped %d while the encoder was behind", images_dropped);
+  printf(".\n");
+  pthread_mutex_destroy(&mutex);
+  pthread_cond_destroy(&cond);
+}
+
+void IncrementalOutput::Snapshot(int index, const FourByte* framebuffer)
+{
+  pthread_mutex_lock(&mutex);
+  if (queue.size() >= INCREMENTAL_OUTPUT_QUEUE) {
+    images_dropped++;
+    pthread_mutex_unlock(&mutex);
+    return;
+  }
+  pthread_mutex_unlock(&mutex);
+
+  // Callers are serialized by memory_mutex, so the queue can only have shrunk since the check
+  FramebufferSnapshot snapshot;
+  snapshot.index = index;
+  snapshot.pixels = new FourByte[3 * image_width * image_height];
+  memcpy(snapshot.pixels, framebuffer, sizeof(FourByte) * 3 * image_width * image_height);
+
+  pthread_mutex_lock(&mutex);
+  queue.push_back(snapshot);
+  pthread_cond_signal(&cond);
+  pthread_mutex_unlock(&mutex);
+}
+
+void* IncrementalOutput::Run(void* arg)
+{
+  IncrementalOutput* output = static_cast<IncrementalOutput*>(arg);
+  int width = output->image_width;
+  int height = output->image_height;
+  unsigned char* imgRGBA = new unsigned char[4 * width * height];
+
+  pthread_mutex_lock(&output->mutex);
+  while (true) {
+    while (output->queue.empty() && !output->done)
+      pthread_cond_wait(&output->cond, &output->mutex);
+    if (output->queue.empty())
+      break;
+    FramebufferSnapshot snapshot = output->queue.front();
+    pthread_mutex_unlock(&output->mutex);
+
+    // Same conversion as the final image (WriteFrameImage), bottom row first
+    unsigned char* curImgPixel = imgRGBA;
+    for (int j = height - 1; j >= 0; j--) {
+      for (int i = 0; i < width; i++, curImgPixel += 4) {
+        const FourByte* rgb = snapshot.pixels + 3 * (j * width + i);
+        curImgPixel[0] = (char)(int)(rgb[0].fvalue * 255);
+        curImgPixel[1] = (char)(int)(rgb[1].fvalue * 255);
+        curImgPixel[2] = (char)(int)(rgb[2].fvalue * 255);
+        curImgPixel[3] = 255;
+      }
+    }
+    delete[] snapshot.pixels;
+
+    char filename[64];
+    sprintf(filename, "out%d.png", snapshot.index);
+    unsigned char* png;
+    size_t pngsize;
+    unsigned error = lodepng_encode32(&png, &pngsize, imgRGBA, width, height);
+    if (!error)
+      lodepng_save_file(png, pngsize, filename);
+    else
+      printf("Error %u: %s\n", error, lodepng_error_text(error));
+    free(png);
+
+    // The snapshot stays queued until it is written, so it counts against the bound
+    pthread_mutex_lock(&output->mutex);
+    output->queue.pop_front();
+    if (!error)
+      output->images_written++;
+  }
+  pthread_mutex_unlock(&output->mutex);
+  delete[] imgRGBA;
+  return NULL;
+}
@@ -0,0 +1,43 @@
+#ifndef _SIMHWRT_INCREMENTAL_OUTPUT_H_
+#define _SIMHWRT_INCREMENTAL_OUTPUT_H_
+
+// Progress images for "--incremental-output". MainMemory copies the framebuffer out of
+// simulated memory every stores_between_output stores, and a background thread encodes
+// the copies to outN.png with lodepng. The simulation thread only pays for the copy: if
+// INCREMENTAL_OUTPUT_QUEUE images are already waiting to be encoded the new one is
+// dropped rather than making the simulation wait.
+
+#include "FourByte.h"
+#include <pthread.h>
+#include <deque>
+
+#define INCREMENTAL_OUTPUT_QUEUE 4
+
+struct FramebufferSnapshot {
+  int index; // the N in outN.png
+  FourByte* pixels;
+};
+
+class IncrementalOutput {
+public:
+  IncrementalOutput(int image_width, int image_height);
+  // Encodes whatever is still queued
+  ~IncrementalOutput();
+
+  // Copies 3 * width * height words starting at 'framebuffer'. The caller holds
+  // memory_mutex, so no store lands half way through the copy
+  void Snapshot(int index, const FourByte* framebuffer);
+
+  static void* Run(void* writer);
+
+  int image_width, image_height;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  std::deque<FramebufferSnapshot> queue;
+  bool done;
+  int images_written;
+  int images_dropped;
+};
+
+#endif // _SIMHWRT_INCREMENTAL_OUTPUT_H_
@@ -18,7 +18,13 @@ Instruction::Instruction(Opcode code,
   depends[0] = depends[1] = -1;
   executions = 0;
   data_stalls = 0;
+  contention_stalls = 0;
   cycles = 0;
+  for (int i = 0; i < NUM_MEM_SOURCES; i++)
+    mem_sources[i] = 0;
+  mem_latency = 0;
+  l1_conflicts = 0;
+  l2_stalls = 0;
 
   srcInfo.lineNum = -1;
   srcInfo.colNum = -1;
@@ -46,7 +52,13 @@ Instruction::Instruction(Opcode code,
   depends[0] = depends[1] = -1;
   executions = 0;
   data_stalls = 0;
+  contention_stalls = 0;
   cycles = 0;
+  for (int i = 0; i < NUM_MEM_SOURCES; i++)
+    mem_sources[i] = 0;
+  mem_latency = 0;
+  l1_conflicts = 0;
+  l2_stalls = 0;
 
   srcInfo = _srcInfo;
   asmLine = _asmLine;
@@ -65,7 +77,13 @@ Instruction::Instruction(const Instruction& ins)
   depends[1] = ins.depends[1];
   executions = ins.executions;
   data_stalls = ins.data_stalls;
+  contention_stalls = ins.contention_stalls;
   cycles = ins.cycles;
+  for (int i = 0; i < NUM_MEM_SOURCES; i++)
+    mem_sources[i] = ins.mem_sources[i];
+  mem_latency = ins.mem_latency;
+  l1_conflicts = ins.l1_conflicts;
+  l2_stalls = ins.l2_stalls;
 
   srcInfo = ins.srcInfo;
   asmLine = ins.asmLine;
@@ -26,6 +26,18 @@
 #define BEGIN_COUNT_CYCLES 0
 #define END_COUNT_CYCLES 1
 
+// Where a load's data came from, for the per-PC memory profile
+enum MemorySource
+{
+  MEM_SOURCE_NONE,     // not a profiled load
+  MEM_SOURCE_L1,       // L1 hit
+  MEM_SOURCE_NEARBY,   // another TM's L1 (--cache-snoop)
+  MEM_SOURCE_BUS,      // joined a line already on its way to the L1
+  MEM_SOURCE_L2,       // L2 hit
+  MEM_SOURCE_DRAM,     // L2 miss, including misses on a line already requested from DRAM
+  NUM_MEM_SOURCES
+};
+
 // Debug info about which source the instruction came from
 struct SourceInfo
 {
@@ -382,7 +394,15 @@ class Instruction {
   // Keep track of performance data
   long long int executions;
   long long int data_stalls;
+  long long int contention_stalls;
   long long int cycles;
+  // Loads by where their data came from, and their summed issue to write-back cycles
+  long long int mem_sources[NUM_MEM_SOURCES];
+  long long int mem_latency;
+  // Memory accesses turned away by an L1 bank conflict, or by the L2/DRAM (bank conflict,
+  // bandwidth or full read queue), to be retried
+  long long int l1_conflicts;
+  long long int l2_stalls;
   SourceInfo srcInfo;
   std::string asmLine;
   int lineNum;
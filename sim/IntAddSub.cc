@@ -285,6 +285,11 @@ bool IntAddSub::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadSta
   return true;
 }
 
+void IntAddSub::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void IntAddSub::ClockRise()
 {
@@ -161,6 +161,11 @@ bool IntMul::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState*
   return true;
 }
 
+void IntMul::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void IntMul::ClockRise()
 {
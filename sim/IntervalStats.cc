@@ -0,0 +1,131 @@
+#include "IntervalStats.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "IssueUnit.h"
+#include "L1Cache.h"
+#include "L2Cache.h"
+#include "memory_controller.h"
+#include "params.h"
+#include <stdlib.h>
+
+// Cumulative counters, in column order. Queue lengths follow these.
+static const char* counter_names[] = {
+  "instructions",
+  "issue_cycles",
+  "icache_conflicts",
+  "fu_dependence",
+  "data_dependence",
+  "halted",
+  "misc",
+  "L1_accesses",
+  "L1_hits",
+  "L1_misses",
+  "L1_bank_conflicts",
+  "L2_accesses",
+  "L2_hits",
+  "L2_misses",
+  "L2_bandwidth_stalls",
+  "dram_reads",
+  "dram_writes",
+};
+#define NUM_COUNTERS (int)(sizeof(counter_names) / sizeof(counter_names[0]))
+
+IntervalStats::IntervalStats(const char* filename, long long int _interval, std::vector<TraxCore*>& _cores,
+			     L2Cache** _L2s, int _num_L2s, bool _usimm_enabled) :
+  interval(_interval), cores(_cores), L2s(_L2s), num_L2s(_num_L2s), usimm_enabled(_usimm_enabled)
+{
+  output = fopen(filename, "w");
+  if (!output) {
+    perror("Failed to open interval stats file for writing.\n");
+    exit(1);
+  }
+
+  fprintf(output, "cycle");
+  for (int i = 0; i < NUM_COUNTERS; i++)
+    fprintf(output, ",%s", counter_names[i]);
+  if (usimm_enabled) {
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      fprintf(output, ",read_queue_%d,write_queue_%d", c, c);
+  }
+  std::vector<std::string>& names = cores[0]->module_names;
+  for (size_t i = 0; i < names.size(); i++)
+    fprintf(output, ",util_%s", names[i].c_str());
+  fprintf(output, "\n");
+
+  // Runs restored from a checkpoint start from the restored counters
+  last_cycle = cores[0]->cycle_num;
+  next_sample = last_cycle + interval;
+  Gather();
+  last_counters = counters;
+  last_utilizations.assign(names.size(), 0.);
+  for (size_t c = 0; c < cores.size(); c++)
+    for (size_t i = 0; i < names.size(); i++)
+      last_utilizations[i] += cores[c]->utilizations[i];
+}
+
+IntervalStats::~IntervalStats()
+{
+  fclose(output);
+}
+
+void IntervalStats::Gather()
+{
+  counters.assign(NUM_COUNTERS, 0);
+  for (size_t c = 0; c < cores.size(); c++) {
+    IssueUnit* issuer = cores[c]->issuer;
+    for (int op = 0; op < Instruction::NUM_OPS; op++)
+      counters[0] += issuer->instruction_bins[op];
+    counters[1] += issuer->instructions_issued;
+    counters[2] += issuer->iCache_conflicts;
+    counters[3] += issuer->fu_dependence;
+    counters[4] += issuer->data_dependence;
+    counters[5] += issuer->halted_count;
+    counters[6] += issuer->instructions_misc;
+    L1Cache* L1 = cores[c]->L1;
+    counters[7] += L1->accesses;
+    counters[8] += L1->hits;
+    counters[9] += L1->misses;
+    counters[10] += L1->bank_conflicts;
+  }
+  for (int i = 0; i < num_L2s; i++) {
+    counters[11] += L2s[i]->accesses;
+    counters[12] += L2s[i]->hits;
+    counters[13] += L2s[i]->misses;
+    counters[14] += L2s[i]->bandwidth_stalls;
+  }
+  if (usimm_enabled) {
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+      counters[15] += stats_reads_completed[c];
+      counters[16] += stats_writes_completed[c];
+    }
+  }
+}
+
+void IntervalStats::Sample(long long int cycle)
+{
+  long long int cycles = cycle - last_cycle;
+  if (cycles <= 0)
+    return;
+
+  Gather();
+  fprintf(output, "%lld", cycle);
+  for (int i = 0; i < NUM_COUNTERS; i++)
+    fprintf(output, ",%lld", counters[i] - last_counters[i]);
+  if (usimm_enabled) {
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      fprintf(output, ",%lld,%lld", read_queue_length[c], write_queue_length[c]);
+  }
+  // Average utilization of each module over the interval, across all TMs
+  for (size_t i = 0; i < last_utilizations.size(); i++) {
+    double sum = 0.;
+    for (size_t c = 0; c < cores.size(); c++)
+      sum += cores[c]->utilizations[i];
+    fprintf(output, ",%.4f", (sum - last_utilizations[i]) / (cycles * cores.size()));
+    last_utilizations[i] = sum;
+  }
+  fprintf(output, "\n");
+
+  counters.swap(last_counters);
+  last_cycle = cycle;
+  next_sample = cycle + interval;
+}
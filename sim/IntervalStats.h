@@ -0,0 +1,50 @@
+#ifndef _SIMHWRT_INTERVAL_STATS_H_
+#define _SIMHWRT_INTERVAL_STATS_H_
+
+// Interval statistics ("--interval-stats"). Every N cycles the counters the end-of-run
+// report is built from (issue and stall bins, L1/L2 hits and misses, DRAM traffic and
+// queue lengths, module utilization) are summed across TMs and written as one CSV row.
+// Counters are deltas over the interval, except queue lengths which are sampled as is.
+// Between samples the only cost is one comparison per cycle.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+class TraxCore;
+class L2Cache;
+
+class IntervalStats {
+public:
+  IntervalStats(const char* filename, long long int interval, std::vector<TraxCore*>& cores,
+		L2Cache** L2s, int num_L2s, bool usimm_enabled);
+  ~IntervalStats();
+
+  // Called by a single simulation thread once 'cycle' cycles have completed
+  void Tick(long long int cycle) {
+    if (cycle >= next_sample)
+      Sample(cycle);
+  }
+  // Writes a row covering everything since the last one
+  void Sample(long long int cycle);
+
+  FILE* output;
+  long long int interval;
+  long long int next_sample;
+  long long int last_cycle;
+
+  std::vector<TraxCore*>& cores;
+  L2Cache** L2s;
+  int num_L2s;
+  bool usimm_enabled;
+
+  // Counter values at the previous sample
+  std::vector<long long int> last_counters;
+  std::vector<double> last_utilizations;
+  std::vector<long long int> counters;
+
+private:
+  void Gather();
+};
+
+#endif // _SIMHWRT_INTERVAL_STATS_H_
@@ -0,0 +1,217 @@
+#include "IssueTrace.h"
+#include "Instruction.h"
+#include "ThreadState.h"
+#include <stdlib.h>
+#include <string.h>
+
+IssueTraceWriter* issue_trace_writer = NULL;
+
+IssueTraceWriter::IssueTraceWriter(const char* _filename, int num_TMs, int threads_per_TM)
+{
+  filename = _filename;
+  output = fopen(filename.c_str(), "wb");
+  if (!output) {
+    perror("Unable to open issue trace file for writing");
+    exit(1);
+  }
+  IssueTraceHeader header;
+  memset(&header, 0, sizeof(header));
+  strncpy(header.magic, ISSUE_TRACE_MAGIC, sizeof(header.magic));
+  header.version = 1;
+  header.num_TMs = num_TMs;
+  header.threads_per_TM = threads_per_TM;
+  fwrite(&header, sizeof(header), 1, output);
+  bytes_written = sizeof(header);
+
+  for (int i = 0; i < num_TMs * ISSUE_TRACE_BLOCKS_PER_TM; i++) {
+    all_blocks.push_back(new IssueTraceBlock);
+    free_blocks.push_back(all_blocks.back());
+  }
+  done = false;
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&full_cond, NULL);
+  pthread_cond_init(&free_cond, NULL);
+  if (pthread_create(&thread, NULL, Run, this) != 0) {
+    perror("Unable to start issue trace writer thread");
+    exit(1);
+  }
+}
+
+IssueTraceWriter::~IssueTraceWriter()
+{
+  for (size_t i = 0; i < traces.size(); i++)
+    traces[i]->Flush();
+
+  pthread_mutex_lock(&mutex);
+  done = true;
+  pthread_cond_signal(&full_cond);
+  pthread_mutex_unlock(&mutex);
+  pthread_join(thread, NULL);
+
+  printf("Wrote %lld bytes of issue trace to '%s'.\n", bytes_written, filename.c_str());
+  fclose(output);
+  for (size_t i = 0; i < all_blocks.size(); i++)
+    delete all_blocks[i];
+  pthread_mutex_destroy(&mutex);
+  pthread_cond_destroy(&full_cond);
+  pthread_cond_destroy(&free_cond);
+}
+
+IssueTraceBlock* IssueTraceWriter::GetBlock()
+{
+  pthread_mutex_lock(&mutex);
+  while (free_blocks.empty())
+    pthread_cond_wait(&free_cond, &mutex);
+  IssueTraceBlock* block = free_blocks.back();
+  free_blocks.pop_back();
+  pthread_mutex_unlock(&mutex);
+  return block;
+}
+
+void IssueTraceWriter::Submit(IssueTraceBlock* block)
+{
+  pthread_mutex_lock(&mutex);
+  full_blocks.push_back(block);
+  pthread_cond_signal(&full_cond);
+  pthread_mutex_unlock(&mutex);
+}
+
+void IssueTraceWriter::Register(IssueTrace* trace)
+{
+  pthread_mutex_lock(&mutex);
+  traces.push_back(trace);
+  pthread_mutex_unlock(&mutex);
+}
+
+void* IssueTraceWriter::Run(void* arg)
+{
+  IssueTraceWriter* writer = static_cast<IssueTraceWriter*>(arg);
+  pthread_mutex_lock(&writer->mutex);
+  while (true) {
+    while (writer->full_blocks.empty() && !writer->done)
+      pthread_cond_wait(&writer->full_cond, &writer->mutex);
+    if (writer->full_blocks.empty())
+      break;
+    IssueTraceBlock* block = writer->full_blocks.front();
+    writer->full_blocks.pop_front();
+
+    // Simulation threads keep filling other blocks while this one goes to disk
+    pthread_mutex_unlock(&writer->mutex);
+    fwrite(&block->tm, sizeof(block->tm), 1, writer->output);
+    fwrite(&block->size, sizeof(block->size), 1, writer->output);
+    fwrite(block->data, 1, block->size, writer->output);
+    pthread_mutex_lock(&writer->mutex);
+
+    writer->bytes_written += sizeof(block->tm) + sizeof(block->size) + block->size;
+    writer->free_blocks.push_back(block);
+    pthread_cond_signal(&writer->free_cond);
+  }
+  pthread_mutex_unlock(&writer->mutex);
+  return NULL;
+}
+
+IssueTrace::IssueTrace(IssueTraceWriter* _writer, int _tm)
+{
+  writer = _writer;
+  tm = _tm;
+  block = NULL;
+  last_cycle = 0;
+  writer->Register(this);
+}
+
+void IssueTrace::Issued(long long int cycle, int proc_id, ThreadState* thread, int slot, const Instruction* ins)
+{
+  Reserve();
+  if ((int)thread_written.size() <= proc_id)
+    thread_written.resize(proc_id + 1);
+  if ((int)thread_written[proc_id].size() <= slot)
+    thread_written[proc_id].resize(slot + 1, false);
+  if (!thread_written[proc_id][slot]) {
+    thread_written[proc_id][slot] = true;
+    PutByte(ISSUE_TRACE_THREAD);
+    PutVarint(proc_id);
+    PutVarint(slot);
+    uint64_t address = (uint64_t)(uintptr_t)thread;
+    for (int i = 0; i < 8; i++)
+      PutByte((unsigned char)(address >> (8 * i)));
+  }
+  PutPC(ins);
+  PutByte(ISSUE_TRACE_ISSUED);
+  PutCycle(cycle);
+  PutVarint(proc_id);
+  PutVarint(slot);
+  PutVarint(ins->pc_address);
+}
+
+void IssueTrace::DataDependence(long long int cycle, int proc_id, const Instruction* ins)
+{
+  Reserve();
+  PutPC(ins);
+  PutByte(ISSUE_TRACE_DEPENDENCE);
+  PutCycle(cycle);
+  PutVarint(proc_id);
+  PutVarint(ins->pc_address);
+  PutVarint(ins->id);
+}
+
+void IssueTrace::Flush()
+{
+  if (block && block->size > 0)
+    writer->Submit(block);
+  block = NULL;
+}
+
+void IssueTrace::Reserve()
+{
+  if (block && block->size + ISSUE_TRACE_MAX_EVENT > ISSUE_TRACE_BLOCK_SIZE)
+    Flush();
+  if (!block) {
+    block = writer->GetBlock();
+    block->tm = tm;
+    block->size = 0;
+  }
+}
+
+void IssueTrace::PutByte(unsigned char byte)
+{
+  block->data[block->size++] = byte;
+}
+
+void IssueTrace::PutVarint(uint64_t value)
+{
+  while (value >= 0x80) {
+    PutByte((unsigned char)(value | 0x80));
+    value >>= 7;
+  }
+  PutByte((unsigned char)value);
+}
+
+void IssueTrace::PutPC(const Instruction* ins)
+{
+  int pc = ins->pc_address;
+  if ((int)pc_written.size() <= pc)
+    pc_written.resize(pc + 1, false);
+  if (pc_written[pc])
+    return;
+  pc_written[pc] = true;
+
+  const std::string& name = Instruction::Opnames[ins->op];
+  size_t length = name.size() < 255 ? name.size() : 255;
+  PutByte(ISSUE_TRACE_PC);
+  PutVarint(pc);
+  PutByte((unsigned char)length);
+  for (size_t i = 0; i < length; i++)
+    PutByte(name[i]);
+  for (int i = 0; i < 3; i++) {
+    int32_t arg = ins->args[i];
+    PutVarint(((uint32_t)arg << 1) ^ (uint32_t)(arg >> 31));
+  }
+}
+
+void IssueTrace::PutCycle(long long int cycle)
+{
+  // Signed: a new frame starts the TM's cycles over
+  int64_t delta = cycle - last_cycle;
+  PutVarint(((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+  last_cycle = cycle;
+}
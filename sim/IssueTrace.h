@@ -0,0 +1,112 @@
+#ifndef _SIMHWRT_ISSUE_TRACE_H_
+#define _SIMHWRT_ISSUE_TRACE_H_
+
+// Binary issue traces ("--issue-verbosity 2" and up), in place of the old tN_trace.txt and
+// t_all_trace.txt text files. Each TM's IssueUnit encodes its events in to blocks of its
+// own, and full blocks are handed to a background thread that writes them out, so the
+// simulation threads never format text or wait on the disk.
+// samples/scripts/issue_trace_decode.py turns a trace back in to the text files.
+//
+// File: IssueTraceHeader, then blocks of (uint32 TM, uint32 size in bytes, records).
+// Records never span blocks. Each starts with a type byte, then unsigned LEB128 varints:
+//   ISSUE_TRACE_ISSUED     cycle delta, thread processor, thread slot, PC
+//   ISSUE_TRACE_DEPENDENCE cycle delta, thread processor, PC, per-thread instruction id
+//   ISSUE_TRACE_PC         PC, op name (length byte + chars), 3 zigzag-encoded args
+//   ISSUE_TRACE_THREAD     thread processor, thread slot, uint64 ThreadState address
+// Cycle deltas are zigzag-encoded, from the TM's previous event. A TM's PC and thread records come before
+// its first event that uses them; the addresses only keep the text's "Thread %p".
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#define ISSUE_TRACE_MAGIC "TRAXITR"
+#define ISSUE_TRACE_FILE "issue_trace.bin"
+#define ISSUE_TRACE_BLOCK_SIZE (1 << 16)
+// Enough for the largest event: its thread and PC records and itself
+#define ISSUE_TRACE_MAX_EVENT 512
+// Blocks per TM, written or waiting to be; a TM that gets this far ahead of the disk waits
+#define ISSUE_TRACE_BLOCKS_PER_TM 4
+
+class Instruction;
+class ThreadState;
+
+struct IssueTraceHeader {
+  char magic[8];
+  unsigned int version;
+  int num_TMs;
+  int threads_per_TM;
+};
+
+enum IssueTraceRecord {
+  ISSUE_TRACE_ISSUED = 0,
+  ISSUE_TRACE_DEPENDENCE,
+  ISSUE_TRACE_PC,
+  ISSUE_TRACE_THREAD
+};
+
+struct IssueTraceBlock {
+  uint32_t tm;
+  uint32_t size;
+  unsigned char data[ISSUE_TRACE_BLOCK_SIZE];
+};
+
+class IssueTrace;
+
+class IssueTraceWriter {
+public:
+  IssueTraceWriter(const char* filename, int num_TMs, int threads_per_TM);
+  // Writes out the IssueTraces' partial blocks, so the simulation must be finished
+  ~IssueTraceWriter();
+
+  // Thread safe. GetBlock waits while every block is queued for writing
+  IssueTraceBlock* GetBlock();
+  void Submit(IssueTraceBlock* block);
+  void Register(IssueTrace* trace);
+
+  static void* Run(void* writer);
+
+  std::string filename;
+  FILE* output;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t full_cond;
+  pthread_cond_t free_cond;
+  std::deque<IssueTraceBlock*> full_blocks;
+  std::vector<IssueTraceBlock*> free_blocks;
+  std::vector<IssueTraceBlock*> all_blocks;
+  std::vector<IssueTrace*> traces;
+  bool done;
+  long long int bytes_written;
+};
+
+// One TM's trace, only used by the simulation thread clocking that TM
+class IssueTrace {
+public:
+  IssueTrace(IssueTraceWriter* writer, int tm);
+
+  void Issued(long long int cycle, int proc_id, ThreadState* thread, int slot, const Instruction* ins);
+  void DataDependence(long long int cycle, int proc_id, const Instruction* ins);
+  void Flush();
+
+  IssueTraceWriter* writer;
+  int tm;
+  IssueTraceBlock* block;
+  long long int last_cycle;
+  std::vector<bool> pc_written;
+  std::vector<std::vector<bool> > thread_written; // [thread processor][slot]
+
+private:
+  void Reserve();
+  void PutByte(unsigned char byte);
+  void PutVarint(uint64_t value);
+  void PutPC(const Instruction* ins);
+  void PutCycle(long long int cycle);
+};
+
+extern IssueTraceWriter* issue_trace_writer;
+
+#endif // _SIMHWRT_ISSUE_TRACE_H_
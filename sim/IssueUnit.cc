@@ -7,6 +7,8 @@
 #include "ReadConfig.h"
 #include "Profiler.h"
 #include "Debugger.h"
+#include "ProfileExport.h"
+#include "IssueTrace.h"
 #include "memory_controller.h"
 #include <stdlib.h>
 #include <fstream>
@@ -21,6 +23,7 @@ IssueUnit::IssueUnit(const char* icache_params_file, std::vector<ThreadProcessor
     :verbosity(_verbosity)
 {
   printed_single_kernel = false;
+  kernel_regions_dropped = 0;
   enable_profiling = _enable_profiling;
   profiler = _profiler;
   debugger = _debugger;
@@ -47,12 +50,14 @@ IssueUnit::IssueUnit(const char* icache_params_file, std::vector<ThreadProcessor
   kernel_cycles = new long long int*[MAX_NUM_KERNELS];
   kernel_calls = new int*[MAX_NUM_KERNELS];
   kernel_profiling = new int*[MAX_NUM_KERNELS];
+  kernel_start = new long long int*[MAX_NUM_KERNELS];
 
   for (size_t i = 0; i < MAX_NUM_KERNELS; ++i)
   {
     kernel_cycles[i] = new long long int[_thread_procs.size()];
     kernel_calls[i] = new int[_thread_procs.size()];
     kernel_profiling[i] = new int[_thread_procs.size()];
+    kernel_start[i] = new long long int[_thread_procs.size()];
 
     for(size_t j = 0; j < _thread_procs.size(); j++)
     {
@@ -61,6 +66,7 @@ IssueUnit::IssueUnit(const char* icache_params_file, std::vector<ThreadProcessor
       //initialize cycles and calls for each kernel
       kernel_cycles[i][j] = 0;
       kernel_calls[i][j] = 0;
+      kernel_start[i][j] = 0;
     }
   }
 
@@ -120,20 +126,10 @@ IssueUnit::IssueUnit(const char* icache_params_file, std::vector<ThreadProcessor
   instructions_stalled = 0;
   instructions_misc = 0;
 
-  // output files
-  if (verbosity > 1)
-  {
-    buf = new char[100];
-    thread_trace.resize(thread_procs.size());
-
-    for (size_t i = 0; i < thread_procs.size(); i++)
-    {
-      sprintf(buf, "t%d_trace.txt", static_cast<int>(i));
-      thread_trace[i] = fopen(buf, "w");
-    }
-
-    all_trace = fopen("t_all_trace.txt", "w");
-  }
+  // binary trace, see IssueTrace.h
+  trace = NULL;
+  if (verbosity > 1 && issue_trace_writer)
+    trace = new IssueTrace(issue_trace_writer, thread_procs[0]->thread_states[0]->core_id);
 
   // tracking who atomincs
   atominc_bins = new int[thread_procs.size()];
@@ -207,8 +203,11 @@ void IssueUnit::Reset()
       //initialize cycles and calls for each kernel
       kernel_cycles[i][j] = 0;
       kernel_calls[i][j] = 0;
+      kernel_start[i][j] = 0;
     }
   }
+  kernel_regions.clear();
+  kernel_regions_dropped = 0;
 
   int count = 0;
   for (size_t i = 0; i < thread_procs.size(); i++)
@@ -287,25 +286,21 @@ void IssueUnit::Reset()
 
 IssueUnit::~IssueUnit()
 {
-  if (verbosity > 1)
-  {
-    delete [] buf;
-    fclose(all_trace);
-
-    for (size_t i = 0; i < thread_procs.size(); i++)
-      fclose(thread_trace[i]);
-  }
+  // The writer has already written out its last block
+  delete trace;
 
   for(size_t i = 0; i < MAX_NUM_KERNELS; i++)
   {
     delete [] kernel_cycles[i];
     delete [] kernel_calls[i];
     delete [] kernel_profiling[i];
+    delete [] kernel_start[i];
   }
 
   delete [] kernel_cycles;
   delete [] kernel_calls;
   delete [] kernel_profiling;
+  delete [] kernel_start;
   delete [] thread_issue_count;
   delete [] atominc_bins;
   delete [] simd_last_issued;
@@ -317,6 +312,15 @@ IssueUnit::~IssueUnit()
   delete [] bank_fetched;
 }
 
+// Un-halts the unit so the program can run again (next animation frame).
+// Unlike Reset(), the cycle count and all statistics keep accumulating.
+void IssueUnit::Restart()
+{
+  num_halted = 0;
+  halted = false;
+  start_proc = 0;
+}
+
 void IssueUnit::HaltSystem()
 {
   // need to do something else here.
@@ -374,24 +378,13 @@ void IssueUnit::IssueVerbosity(ThreadState* thread, Instruction* fetched_instruc
            fetched_instruction->pc_address,
            Instruction::Opnames[fetched_instruction->op].c_str() );
   }
-  else if (verbosity > 1)
+  else if (verbosity > 1 && trace)
   {
-    sprintf(buf, "%s %d %d %d\n",
-            Instruction::Opnames[fetched_instruction->op].c_str(),
-            fetched_instruction->args[0], fetched_instruction->args[1],
-            fetched_instruction->args[2]);
-
-    fprintf(thread_trace[proc_id], "%s", buf );
-    fprintf(all_trace, "%s", buf );
-
-    sprintf(buf, "Cycle %lld: Thread %p: Instruction PC: %d (%s), ISSUED\n",
-            current_cycle,
-            thread,
-            fetched_instruction->pc_address,
-            Instruction::Opnames[fetched_instruction->op].c_str() );
-
-    fprintf(thread_trace[proc_id], "%s", buf );
-    fprintf(all_trace, "%s", buf );
+    std::vector<ThreadState*>& states = thread_procs[proc_id]->thread_states;
+    int slot = 0;
+    while (slot < (int)states.size() - 1 && states[slot] != thread)
+      slot++;
+    trace->Issued(current_cycle, static_cast<int>(proc_id), thread, slot, fetched_instruction);
   }
 }
 
@@ -404,14 +397,9 @@ void IssueUnit::DataDependVerbosity(ThreadState* thread, Instruction* fetched_in
            fetched_instruction->pc_address,
            Instruction::Opnames[fetched_instruction->op].c_str() );
   }
-  else if (verbosity > 1)
+  else if (verbosity > 1 && trace)
   {
-    sprintf(buf, "Cycle %lld: Thread %d: Instruction %llu: NR: DATA DEPENDENCY (%s)\n", current_cycle,
-            static_cast<int>(proc_id),
-            fetched_instruction->id,
-            Instruction::Opnames[fetched_instruction->op].c_str() );
-    fprintf(thread_trace[proc_id], "%s", buf );
-    fprintf(all_trace, "%s", buf );
+    trace->DataDependence(current_cycle, static_cast<int>(proc_id), fetched_instruction);
   }
 }
 
@@ -485,6 +473,20 @@ bool IssueUnit::Issue(ThreadProcessor* tp, ThreadState* thread, Instruction* fet
         if (kernel_profiling[kernel_prof_id][tp->proc_id])
         {
           kernel_calls[kernel_prof_id][tp->proc_id]++;
+          kernel_start[kernel_prof_id][tp->proc_id] = current_cycle;
+        }
+        else if (kernel_trace && kernel_regions.size() >= MAX_KERNEL_REGIONS)
+        {
+          kernel_regions_dropped++;
+        }
+        else if (kernel_trace)
+        {
+          KernelRegion region;
+          region.kernel = kernel_prof_id;
+          region.proc = tp->proc_id;
+          region.start = kernel_start[kernel_prof_id][tp->proc_id];
+          region.end = current_cycle;
+          kernel_regions.push_back(region);
         }
       }
       issued = true;
@@ -618,10 +620,12 @@ bool IssueUnit::Issue(ThreadProcessor* tp, ThreadState* thread, Instruction* fet
       {
         if(fetched_instruction->op != Instruction::HALT)
 	  {
-	    if(enable_profiling)
+	    if(enable_profiling || pc_profiling)
 	      {
 		pthread_mutex_lock(&profile_mutex);
-		thread->runtime = profiler->UpdateRuntime(fetched_instruction, thread->runtime, STALL_CONTENTION);
+		fetched_instruction->contention_stalls++;
+		if(enable_profiling)
+		  thread->runtime = profiler->UpdateRuntime(fetched_instruction, thread->runtime, STALL_CONTENTION);
 		pthread_mutex_unlock(&profile_mutex);
 	      }
 	    fu_dependence++;
@@ -632,13 +636,14 @@ bool IssueUnit::Issue(ThreadProcessor* tp, ThreadState* thread, Instruction* fet
 
   else
   {
-    if(enable_profiling)
+    if(enable_profiling || pc_profiling)
     {
       // All threads point to the same list of Instructions, must protect modifications to it
       pthread_mutex_lock(&profile_mutex);
       thread->GetFailInstruction(fail_reg)->data_stalls++;
       // Data stalls are caused by an old instruction, don't reassign the runtime pointer
-      profiler->UpdateRuntime(thread->GetFailInstruction(fail_reg), thread->runtime, STALL_DATA);
+      if(enable_profiling)
+        profiler->UpdateRuntime(thread->GetFailInstruction(fail_reg), thread->runtime, STALL_DATA);
       pthread_mutex_unlock(&profile_mutex);
     }
     data_dependence++;
@@ -652,11 +657,12 @@ bool IssueUnit::Issue(ThreadProcessor* tp, ThreadState* thread, Instruction* fet
   if (issued)
   {
     // TODO: If the debugger and profler are enabled at the same time, everything will get counted twice.
-    if(enable_profiling)
+    if(enable_profiling || pc_profiling)
     {
       // All threads point to the same list of Instructions, must protect modifications to it
       pthread_mutex_lock(&profile_mutex);
-      thread->runtime = profiler->UpdateRuntime(fetched_instruction, thread->runtime, STALL_EXECUTE);
+      if(enable_profiling)
+        thread->runtime = profiler->UpdateRuntime(fetched_instruction, thread->runtime, STALL_EXECUTE);
       fetched_instruction->executions++;
       pthread_mutex_unlock(&profile_mutex);
     }
@@ -833,10 +839,12 @@ void IssueUnit::MultipleIssueClockFall()
       else
       {
         // icache couldn't fetch
-	if(enable_profiling)
+	if(enable_profiling || pc_profiling)
 	  {
 	    pthread_mutex_lock(&profile_mutex);
-	    thread->runtime = profiler->UpdateRuntime(thread->instructions[thread->program_counter], thread->runtime, STALL_CONTENTION);
+	    thread->instructions[thread->program_counter]->contention_stalls++;
+	    if(enable_profiling)
+	      thread->runtime = profiler->UpdateRuntime(thread->instructions[thread->program_counter], thread->runtime, STALL_CONTENTION);
 	    pthread_mutex_unlock(&profile_mutex);
 	  }
         iCache_conflicts++;
@@ -13,6 +13,10 @@
 #include <string.h>
 
 #define MAX_NUM_KERNELS 16
+// Regions kept per TM for --kernel-trace, later ones are counted but not kept
+#define MAX_KERNEL_REGIONS (1 << 18)
+
+class IssueTrace;
 
 struct IssueStats
 {
@@ -35,6 +39,15 @@ struct IssueStats
 
 };
 
+// One PROF-delimited kernel region run by a thread, kept for --kernel-trace
+struct KernelRegion
+{
+  int kernel;
+  int proc;
+  long long int start;
+  long long int end;
+};
+
 // An IssueUnit takes the current ProgramCounter
 // fetches the next instruction, executes whatever
 // it can, manages dependencies and is notified by
@@ -59,6 +72,9 @@ class IssueUnit : public HardwareModule {
   long long int **kernel_cycles;
   int **kernel_calls;
   int **kernel_profiling;
+  long long int **kernel_start;
+  std::vector<KernelRegion> kernel_regions;
+  long long int kernel_regions_dropped;
   long long int current_cycle;
   //long long int end_sleep_cycle;
   /*   long long int total_kernel_stalls; */
@@ -80,6 +96,7 @@ class IssueUnit : public HardwareModule {
   ~IssueUnit();
 
   void Reset();
+  void Restart();
 
   void ClockRise();
   void ClockFall();
@@ -114,9 +131,7 @@ class IssueUnit : public HardwareModule {
   int * thread_issue_count;
   size_t start_proc;
   int verbosity;
-  std::vector<FILE*> thread_trace;
-  FILE* all_trace;
-  char *buf;
+  IssueTrace* trace;
   //std::vector<Instruction*> all_instructions;
   std::vector<FunctionalUnit*> units;
   std::vector<Instruction*> issued_this_cycle;
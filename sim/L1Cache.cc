@@ -6,11 +6,16 @@
 #include "IssueUnit.h"
 #include "ThreadState.h"
 #include "WriteRequest.h"
+#include "MemoryTrace.h"
+#include "DeterministicExecution.h"
+#include "ProfileExport.h"
+#include "LatencyHistograms.h"
 #include <cassert>
 #include <pthread.h>
 #include <cstdlib>
 
 extern pthread_mutex_t atominc_mutex;
+extern pthread_mutex_t profile_mutex;
 
 extern std::vector<std::string> source_names;
 
@@ -76,6 +81,7 @@ L1Cache::L1Cache(L2Cache* _L2, int _hit_latency,
 
   // start at cycle 0
   current_cycle = 0;
+  trace = NULL;
 
   // set nearby L1s to NULL
   L1_1 = NULL;
@@ -126,8 +132,43 @@ bool L1Cache::SupportsOp(Instruction::Opcode op) const {
 }
 
 bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread) {
+  if (!trace)
+    return Access(ins, issuer->current_cycle, thread);
+
+  // Read the address first, a load may overwrite its own base register
+  reg_value base;
+  Instruction::Opcode failop;
+  int base_reg = ins.op == Instruction::STORE || ins.op == Instruction::ATOMIC_FPADD ? ins.args[0] : ins.args[1];
+  thread->ReadRegister(base_reg, issuer->current_cycle, base, failop);
+  if (!Access(ins, issuer->current_cycle, thread))
+    return false;
+  trace->Record(issuer->current_cycle, base.idata + ins.args[2], thread, ins.op);
+  return true;
+}
+
+// Per-PC memory profile and latency histograms: tags the load's register write with where
+// its data comes from
+static void ProfileLoad(ThreadState* thread, Instruction& ins, char source, long long int issue_cycle)
+{
+  if (pc_profiling || latency_histograms)
+    thread->SetWriteSource(ins.args[0], source, issue_cycle);
+}
+
+// Per-PC memory profile: counts a load turned away, to be retried
+static void ProfileRetry(long long int& counter)
+{
+  if (pc_profiling) {
+    pthread_mutex_lock(&profile_mutex);
+    counter++;
+    pthread_mutex_unlock(&profile_mutex);
+  }
+}
+
+bool L1Cache::Access(Instruction& ins, long long int issue_cycle, ThreadState* thread) {
+  // every access reads or writes main memory, and most reach the shared L2
+  DeterministicGate(thread->core_id);
   // Synchronize current cycle with issuer
-  //current_cycle = issuer->current_cycle;
+  //current_cycle = issue_cycle;
   
   //int bank_id = 0;
   long long int temp_latency = 0;
@@ -143,7 +184,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
   if (ins.op == Instruction::LOAD) {
     reg_value arg1;
     // Read the register
-    if (!thread->ReadRegister(ins.args[1], issuer->current_cycle, arg1, failop)) {
+    if (!thread->ReadRegister(ins.args[1], issue_cycle, arg1, failop)) {
       // bad stuff happened
       printf("Error in L1Cache register read. Should have passed.\n");
     }
@@ -153,7 +194,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
     
     bus_latency = IsOnBus(address, bus_transfer);
     
-    //printf("cycle: %lld, PC %d, loading address %d\n", issuer->current_cycle, ins.pc_address, address);
+    //printf("cycle: %lld, PC %d, loading address %d\n", issue_cycle, ins.pc_address, address);
     int bank_id = address % num_banks;
     if (read_address[bank_id] == address) {
       same_word_conflicts++;
@@ -161,7 +202,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	//printf("\tread_copy hit\n", address);
 	// allow the load to happen for free!
 	// queue register write
-	long long int write_cycle = hit_latency + issuer->current_cycle;
+	long long int write_cycle = hit_latency + issue_cycle;
 	reg_value result;
 	result.udata = data[address].uvalue;
 	if (!thread->QueueWrite(ins.args[0], result, write_cycle, ins.op, &ins)) {
@@ -170,6 +211,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	  return false;
 	}
 	//printf("\thit\n");
+	ProfileLoad(thread, ins, MEM_SOURCE_L1, issue_cycle);
 	hits++;
 	accesses++;
 	//TODO: Take this out?
@@ -180,6 +222,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
     }
     if (issued_this_cycle[bank_id] && !unit_off) {
       bank_conflicts++;
+      ProfileRetry(ins.l1_conflicts);
       //printf("\tbank conflict\n", address);
       return false;
     }
@@ -214,7 +257,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	// hit here
 	int near_latency = 5;
 	// queue register write
-	long long int write_cycle = hit_latency + issuer->current_cycle + near_latency;
+	long long int write_cycle = hit_latency + issue_cycle + near_latency;
 	reg_value result;
 	result.udata = data[address].uvalue;
 	if (!thread->QueueWrite(ins.args[0], result, write_cycle, ins.op, &ins)) {
@@ -222,6 +265,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	  // pipeline hazzard
 	  return false;
 	}
+	ProfileLoad(thread, ins, MEM_SOURCE_NEARBY, issue_cycle);
 	nearby_hits++;
 	accesses++;
 
@@ -250,6 +294,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	    }
 	  
 	  bus_transfer->AddRecipient(address, ins.args[0], thread);
+	  ProfileLoad(thread, ins, MEM_SOURCE_BUS, issue_cycle);
 	  bus_hits++;
 	  misses++;
 	  accesses++;
@@ -258,7 +303,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	  return true;
 	}
       
-      else if (L2->IssueInstruction(&ins, this, thread, temp_latency, issuer->current_cycle, address, unroll_type)) 
+      else if (L2->IssueInstruction(&ins, this, thread, temp_latency, issue_cycle, address, unroll_type)) 
 	{
 	  
 	  reg_value result;
@@ -268,7 +313,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	  if(temp_latency != UNKNOWN_LATENCY)
 	    {
 	      // queue write to register
-	      long long int write_cycle = hit_latency + temp_latency + issuer->current_cycle;
+	      long long int write_cycle = hit_latency + temp_latency + issue_cycle;
 	      
 	      if (!thread->QueueWrite(ins.args[0], result, write_cycle, ins.op, &ins)) {	      
 		// pipeline hazzard
@@ -304,6 +349,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	      AddBusTraffic(address, UNKNOWN_LATENCY, thread, ins.args[0]);
 	    }
 
+	  ProfileLoad(thread, ins, unroll_type == UNROLL_MISS ? MEM_SOURCE_DRAM : MEM_SOURCE_L2, issue_cycle);
 	  misses++;
 	  accesses++;	  
 	  read_address[bank_id] = address;
@@ -318,13 +364,14 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
       else 
 	{
 	  // L2 stalled
+	  ProfileRetry(ins.l2_stalls);
 	  return false;
 	}
     }
     else 
       { // cache hit
 	// queue register write
-	long long int write_cycle = hit_latency + issuer->current_cycle;
+	long long int write_cycle = hit_latency + issue_cycle;
 	reg_value result;
 	result.udata = data[address].uvalue;
 	//printf("\tnotifying thread, register %d, cycle %d, result %u\n", ins.args[0], write_cycle, result.udata);
@@ -334,6 +381,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
 	    return false;
 	  }
 
+	ProfileLoad(thread, ins, MEM_SOURCE_L1, issue_cycle);
 	hits++;
 	accesses++;
 	read_address[bank_id] = address;
@@ -352,7 +400,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
   if (ins.op == Instruction::LOADL1) {
     // Read the register
     reg_value arg1;
-    if (!thread->ReadRegister(ins.args[1], issuer->current_cycle, arg1, failop)) {
+    if (!thread->ReadRegister(ins.args[1], issue_cycle, arg1, failop)) {
       // bad stuff happened
       printf("Error in L1Cache LOADL1. Should have passed.\n");
     }    
@@ -381,7 +429,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
       // cache miss, set miss register
       //accesses++;
       // queue register write
-      long long int write_cycle = hit_latency + issuer->current_cycle;
+      long long int write_cycle = hit_latency + issue_cycle;
       reg_value result;
       // Fail value
       result.idata = 0;
@@ -398,7 +446,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
       //hits++;
       //accesses++;
       // queue register write
-      long long int write_cycle = hit_latency + issuer->current_cycle;
+      long long int write_cycle = hit_latency + issue_cycle;
       reg_value result;
       result.idata = 1;
       if (!thread->QueueWrite(ins.args[0], result, write_cycle, ins.op, &ins)) {
@@ -418,8 +466,8 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
     // Read the register
     reg_value arg0, arg1;
     int unroll_type = 0;
-    if (!thread->ReadRegister(ins.args[0], issuer->current_cycle, arg0, failop) ||
-	!thread->ReadRegister(ins.args[1], issuer->current_cycle, arg1, failop)) {
+    if (!thread->ReadRegister(ins.args[0], issue_cycle, arg0, failop) ||
+	!thread->ReadRegister(ins.args[1], issue_cycle, arg1, failop)) {
       // bad stuff happened
       printf("Error in L1Cache ATOMIC_FPADD. Should have passed.\n");
     }    
@@ -436,7 +484,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
       // set cache as dirty
       tags[index] = 0xFFFFFFFF;
     }
-    if (L2->IssueInstruction(&ins, this, thread, temp_latency, issuer->current_cycle, address, unroll_type)) {
+    if (L2->IssueInstruction(&ins, this, thread, temp_latency, issue_cycle, address, unroll_type)) {
       // complete in temp_latency cycles
       //      misses++;
       //      outstanding_requests++;
@@ -444,7 +492,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
       //execute atomic add here
       data[address].fvalue += arg1.fdata;
       pthread_mutex_unlock(&atominc_mutex);
-      UpdateCache(address, temp_latency + issuer->current_cycle);
+      UpdateCache(address, temp_latency + issue_cycle);
       //read_address[bank_id] = address; // can't be replicated
       issued_this_cycle[bank_id]++;
       return true;
@@ -459,7 +507,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
     // Read the register
     reg_value arg0;
     int unroll_type = 0;
-    if (!thread->ReadRegister(ins.args[0], issuer->current_cycle, arg0, failop)) {
+    if (!thread->ReadRegister(ins.args[0], issue_cycle, arg0, failop)) {
       // bad stuff happened
       printf("Error in L1Cache STORE. Should have passed.\n");
     }    
@@ -478,7 +526,7 @@ bool L1Cache::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState
       // set as cached
       tags[index] = tag;
     }
-    if (L2->IssueInstruction(&ins, this, thread, temp_latency, issuer->current_cycle, address, unroll_type)) {
+    if (L2->IssueInstruction(&ins, this, thread, temp_latency, issue_cycle, address, unroll_type)) {
       stores++;
       misses++;
       accesses++;
@@ -570,6 +618,12 @@ bool L1Cache::snoop(int address) {
   return tags[index] == tag;
 }
 
+void L1Cache::Warm(int address) {
+  int index = (address & index_mask) >> index_shift;
+  tags[index] = address & tag_mask;
+  valid[index] = true;
+}
+
 // This updates the tag to reflect the address given
 bool L1Cache::UpdateCache(int address, long long int write_cycle) {
   int index = (address & index_mask) >> index_shift;
@@ -10,6 +10,7 @@
 
 class L2Cache;
 class MainMemory;
+class MemoryTraceWriter;
 
 class L1Cache : public MemoryBase {
 public:
@@ -26,6 +27,8 @@ public:
   ~L1Cache();
   virtual bool SupportsOp(Instruction::Opcode op) const;
   virtual bool AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread);
+  // Performs a load/store issued on issue_cycle, returns false if it has to be retried
+  bool Access(Instruction& ins, long long int issue_cycle, ThreadState* thread);
 
   // From HardwareModule
   virtual void ClockRise();
@@ -38,6 +41,8 @@ public:
   void AddStats(L1Cache* otherL1);
 
   bool snoop(int address);
+  // Installs the line holding address with no timing or stats (functional cache warming)
+  void Warm(int address);
 
   float area;
   float energy;
@@ -50,6 +55,7 @@ public:
   int line_size;
   int processed_this_cycle;
   L2Cache * L2;
+  MemoryTraceWriter* trace; // records every accepted access when set
   L1Cache * L1_1;
   L1Cache * L1_2;
   L1Cache * L1_3;
@@ -420,6 +420,12 @@ double L2Cache::Utilization() {
 }
 
 // This schedules an update to the tag to reflect the address given
+void L2Cache::Warm(int address) {
+  int index = (address & index_mask) >> index_shift;
+  tags[index] = address & tag_mask;
+  valid[index] = true;
+}
+
 bool L2Cache::UpdateCache(int address, long long int update_cycle) {
   //TODO: Enable this for "fake" read queue limiting
   //if(disable_usimm)
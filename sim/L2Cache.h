@@ -44,6 +44,8 @@ public:
 			int address, int& unroll_type);
   void Reset();
   void Clear();
+  // Installs the line holding address with no timing or stats (functional cache warming)
+  void Warm(int address);
 
   float area;
   float energy;
@@ -0,0 +1,168 @@
+#include "LatencyHistograms.h"
+#include "Instruction.h"
+#include "memory_controller.h"
+#include "params.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+bool latency_histograms = false;
+
+static std::vector<std::vector<Histogram> > load_latency; // [core][MemorySource]
+static Histogram dram_read_latency;
+static Histogram read_queue[MAX_NUM_CHANNELS];
+static Histogram write_queue[MAX_NUM_CHANNELS];
+static Histogram row_reads;
+
+static const char* source_names[NUM_MEM_SOURCES] = {
+  "", "L1 hit", "other L1", "in flight to L1", "L2 hit", "DRAM"
+};
+
+Histogram::Histogram()
+{
+  count = 0;
+  sum = 0;
+  max = 0;
+  memset(buckets, 0, sizeof(buckets));
+}
+
+static int Bucket(long long int value)
+{
+  if (value < HISTOGRAM_SUB_BUCKETS)
+    return value < 0 ? 0 : (int)value;
+  int log = 63 - __builtin_clzll((unsigned long long int)value);
+  int sub = (int)(value >> (log - HISTOGRAM_SUB_BITS)) & (HISTOGRAM_SUB_BUCKETS - 1);
+  return HISTOGRAM_SUB_BUCKETS + (log - HISTOGRAM_SUB_BITS) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+static long long int BucketTop(int bucket)
+{
+  if (bucket < HISTOGRAM_SUB_BUCKETS)
+    return bucket;
+  int log = (bucket - HISTOGRAM_SUB_BUCKETS) / HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BITS;
+  int sub = (bucket - HISTOGRAM_SUB_BUCKETS) % HISTOGRAM_SUB_BUCKETS;
+  long long int width = 1LL << (log - HISTOGRAM_SUB_BITS);
+  return (HISTOGRAM_SUB_BUCKETS + sub) * width + width - 1;
+}
+
+void Histogram::Add(long long int value)
+{
+  buckets[Bucket(value)]++;
+  count++;
+  sum += value;
+  if (value > max)
+    max = value;
+}
+
+void Histogram::Merge(const Histogram& other)
+{
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    buckets[i] += other.buckets[i];
+  count += other.count;
+  sum += other.sum;
+  if (other.max > max)
+    max = other.max;
+}
+
+long long int Histogram::Percentile(double p) const
+{
+  long long int target = (long long int)ceil(p / 100. * count);
+  if (target < 1)
+    target = 1;
+  long long int seen = 0;
+  for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+    seen += buckets[i];
+    if (seen >= target)
+      return BucketTop(i) < max ? BucketTop(i) : max;
+  }
+  return max;
+}
+
+void Histogram::Print(const char* name, const char* unit) const
+{
+  if (count == 0) {
+    printf("   %-32s %12d\n", name, 0);
+    return;
+  }
+  printf("   %-32s %12lld %10.2f %8lld %8lld %8lld %8lld  %s\n", name, count, (double)sum / count,
+	 Percentile(50), Percentile(90), Percentile(99), max, unit);
+}
+
+void LatencyHistogramsSetup(int num_cores)
+{
+  load_latency.assign(num_cores, std::vector<Histogram>(NUM_MEM_SOURCES));
+}
+
+void RecordLoadLatency(int core_id, int source, long long int latency)
+{
+  load_latency[core_id][source].Add(latency);
+}
+
+void RecordDramRead(long long int latency)
+{
+  dram_read_latency.Add(latency);
+}
+
+void RecordDramQueues(int channel, long long int read_queue_length, long long int write_queue_length)
+{
+  read_queue[channel].Add(read_queue_length);
+  write_queue[channel].Add(write_queue_length);
+}
+
+void RecordRowReads(long long int reads)
+{
+  row_reads.Add(reads);
+}
+
+void PrintLatencyHistograms(bool usimm_enabled)
+{
+  printf("Latency histograms:\n");
+  printf("   %-32s %12s %10s %8s %8s %8s %8s\n", "", "samples", "mean", "p50", "p90", "p99", "max");
+
+  std::vector<Histogram> loads(NUM_MEM_SOURCES);
+  Histogram all_loads;
+  for (size_t c = 0; c < load_latency.size(); c++)
+    for (int s = MEM_SOURCE_NONE + 1; s < NUM_MEM_SOURCES; s++) {
+      loads[s].Merge(load_latency[c][s]);
+      all_loads.Merge(load_latency[c][s]);
+    }
+  all_loads.Print("Load latency, all", "cycles");
+  for (int s = MEM_SOURCE_NONE + 1; s < NUM_MEM_SOURCES; s++) {
+    char name[64];
+    snprintf(name, sizeof(name), "Load latency, %s", source_names[s]);
+    loads[s].Print(name, "cycles");
+  }
+
+  if (usimm_enabled) {
+    dram_read_latency.Print("DRAM read latency", "DRAM cycles");
+    for (int c = 0; c < NUM_CHANNELS; c++) {
+      char name[64];
+      snprintf(name, sizeof(name), "Channel %d read queue", c);
+      read_queue[c].Print(name, "requests");
+      snprintf(name, sizeof(name), "Channel %d write queue", c);
+      write_queue[c].Print(name, "requests");
+    }
+    // Rows still open at the end have not been counted yet
+    Histogram all_row_reads = row_reads;
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      for (int r = 0; r < NUM_RANKS; r++)
+	for (int b = 0; b < NUM_BANKS; b++)
+	  if (current_col_reads[c][r][b] > 0)
+	    all_row_reads.Add(current_col_reads[c][r][b]);
+    all_row_reads.Print("Column reads per row activation", "reads");
+
+    // Same measure as printUsimmStats' read page hit rate, bank by bank
+    Histogram bank_hit_rate;
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      for (int r = 0; r < NUM_RANKS; r++)
+	for (int b = 0; b < NUM_BANKS; b++) {
+	  long long int reads = stats_num_read[c][r][b];
+	  if (reads == 0)
+	    continue;
+	  long long int activates = stats_num_activate_read[c][r][b] + stats_num_activate_spec[c][r][b];
+	  bank_hit_rate.Add(100 * (reads - activates) / reads);
+	}
+    bank_hit_rate.Print("Bank read row-hit rate", "% (over banks)");
+  }
+  printf("\n");
+}
@@ -0,0 +1,51 @@
+#ifndef _SIMHWRT_LATENCY_HISTOGRAMS_H_
+#define _SIMHWRT_LATENCY_HISTOGRAMS_H_
+
+// Latency and queueing distributions ("--latency-histograms"), reported as percentiles
+// after the usual stats:
+//   - load latency, issue to register write, by where the data came from (MemorySource)
+//   - DRAM read latency, arrival in the usimm read queue to data returned, in usimm cycles
+//     (DRAM_CLOCK_MULTIPLIER of them per simulated cycle)
+//   - usimm read and write queue occupancy per channel, sampled every DRAM cycle
+//   - column reads per row activation (row-buffer hits + 1), and the spread of read
+//     row-hit rates over all banks
+// The load histograms are kept per TM, so simulation threads never share one. usimm is
+// only clocked by one thread at a time.
+
+#include <vector>
+
+// Each power of two is split in to this many linear buckets, so a reported percentile is
+// at most 1/HISTOGRAM_SUB_BUCKETS above the true value
+#define HISTOGRAM_SUB_BUCKETS 8
+#define HISTOGRAM_SUB_BITS 3
+#define HISTOGRAM_BUCKETS (HISTOGRAM_SUB_BUCKETS * 64)
+
+class Histogram {
+public:
+  Histogram();
+  void Add(long long int value);
+  void Merge(const Histogram& other);
+  // Upper bound of the bucket holding the p'th percentile (0 < p <= 100), capped at max
+  long long int Percentile(double p) const;
+  void Print(const char* name, const char* unit) const;
+
+  long long int count;
+  long long int sum;
+  long long int max;
+  long long int buckets[HISTOGRAM_BUCKETS];
+};
+
+extern bool latency_histograms;
+
+void LatencyHistogramsSetup(int num_cores);
+
+void RecordLoadLatency(int core_id, int source, long long int latency);
+
+// Called from usimm (memory_controller.cc)
+void RecordDramRead(long long int latency);
+void RecordDramQueues(int channel, long long int read_queue, long long int write_queue);
+void RecordRowReads(long long int reads);
+
+void PrintLatencyHistograms(bool usimm_enabled);
+
+#endif // _SIMHWRT_LATENCY_HISTOGRAMS_H_
@@ -9,6 +9,13 @@
 
 using namespace simtrax;
 
+void WriteMachineParams(FourByte* mem, int num_rotation_threads, int num_TMs)
+{
+  mem[23].ivalue = (int)log2f(static_cast<float>(num_rotation_threads)); // + 1 for finer granularity on work assignments
+  mem[25].ivalue = num_rotation_threads;
+  mem[35].ivalue = num_TMs;
+}
+
 void LoadMemory(LoadMemoryParams &pio)
 {
   int permutation[] = { 151,160,137,91,90,15,
@@ -60,9 +67,9 @@ void LoadMemory(LoadMemoryParams &pio)
   
 // pio.mem[21].ivalue = num_nodes;
 // pio.mem[22].ivalue = start_costs;
-  pio.mem[23].ivalue = (int)log2f(static_cast<float>(pio.num_rotation_threads)); // + 1 for finer granularity on work assignments
+  // pio.mem[23], pio.mem[25] and pio.mem[35] describe the machine
+  WriteMachineParams(pio.mem, pio.num_rotation_threads, pio.num_TMs);
 // pio.mem[24].ivalue = start_secondary_bvh;
-  pio.mem[25].ivalue = pio.num_rotation_threads;
   //pio.mem[26].ivalue = start_subtree_sizes;
   //pio.mem[27].ivalue = start_rotated_flags;
   //pio.mem[28].ivalue = start_triangles;
@@ -72,7 +79,7 @@ void LoadMemory(LoadMemoryParams &pio)
   //pio.mem[32].ivalue = start_parent_pointers;
   //pio.mem[33].ivalue = start_subtree_ids;
   //pio.mem[34].ivalue = num_subtrees;
-  pio.mem[35].ivalue = pio.num_TMs;
+  //pio.mem[35].ivalue = num_TMs;
   //pio.mem[36].ivalue = start_vertex_normals;
   //pio.mem[37].ivalue = num_interior_subtrees;
   pio.mem[38].ivalue = pio.pack_split_axis;
@@ -150,32 +157,39 @@ void LoadMemory(LoadMemoryParams &pio)
 
       Grid* grid = NULL;
       if(pio.grid_dimensions==-1)
-        pio.bvh = new BVH( triangles, pio.subtree_size, pio.duplicate_bvh, pio.triangles_store_edges, pio.pack_split_axis, pio.pack_stream_boundaries, pio.store_parent_pointers);
+        pio.bvh = new BVH( triangles, pio.subtree_size, pio.duplicate_bvh, pio.triangles_store_edges, pio.pack_split_axis, pio.pack_stream_boundaries, pio.store_parent_pointers, pio.layout_line_size);
       else
-        grid = new Grid(triangles, pio.triangles_store_edges, pio.grid_dimensions);
-      pio.mem[21].ivalue = pio.bvh->num_nodes;
+        grid = new Grid(triangles, pio.triangles_store_edges, pio.grid_dimensions, pio.num_build_threads);
       int scene_data = pio.start_scene;
 
       printf("Scene starts at %d (0x%08x)\n", scene_data, scene_data);
 
-      if(pio.grid_dimensions==-1)
-        pio.bvh->LoadIntoMemory(scene_data, INT_MAX, pio.mem);
-      else
+      if(pio.grid_dimensions!=-1)
+      {
+        // the grid is self-describing, kernels find it at the scene start
         grid->LoadIntoMemory(scene_data, INT_MAX, pio.mem);
+        pio.mem[8].ivalue  = pio.start_scene;
+        delete grid;
+      }
+      else
+      {
+        pio.mem[21].ivalue = pio.bvh->num_nodes;
+        pio.bvh->LoadIntoMemory(scene_data, INT_MAX, pio.mem);
 
-      pio.start_scene    = pio.bvh->start_nodes;
-      pio.mem[8].ivalue  = pio.bvh->start_nodes;
-      pio.mem[22].ivalue = pio.bvh->start_costs;
-      pio.mem[24].ivalue = pio.bvh->start_secondary_nodes;
-      pio.mem[26].ivalue = pio.bvh->start_subtree_sizes;
-      pio.mem[27].ivalue = pio.bvh->start_rotated_flags;
-      pio.mem[28].ivalue = pio.bvh->start_tris;
-      pio.mem[30].ivalue = pio.bvh->start_tex_coords;
-      pio.mem[32].ivalue = pio.bvh->start_parent_pointers;
-      pio.mem[33].ivalue = pio.bvh->start_subtree_ids;
-      pio.mem[34].ivalue = pio.bvh->num_subtrees;
-      pio.mem[36].ivalue = pio.bvh->start_vertex_normals;
-      pio.mem[37].ivalue = pio.bvh->num_interior_subtrees;
+        pio.start_scene    = pio.bvh->start_nodes;
+        pio.mem[8].ivalue  = pio.bvh->start_nodes;
+        pio.mem[22].ivalue = pio.bvh->start_costs;
+        pio.mem[24].ivalue = pio.bvh->start_secondary_nodes;
+        pio.mem[26].ivalue = pio.bvh->start_subtree_sizes;
+        pio.mem[27].ivalue = pio.bvh->start_rotated_flags;
+        pio.mem[28].ivalue = pio.bvh->start_tris;
+        pio.mem[30].ivalue = pio.bvh->start_tex_coords;
+        pio.mem[32].ivalue = pio.bvh->start_parent_pointers;
+        pio.mem[33].ivalue = pio.bvh->start_subtree_ids;
+        pio.mem[34].ivalue = pio.bvh->num_subtrees;
+        pio.mem[36].ivalue = pio.bvh->start_vertex_normals;
+        pio.mem[37].ivalue = pio.bvh->num_interior_subtrees;
+      }
       
 
       //printf("Triangles start at %d (0x%08x)\n",bvh->start_tris, bvh->start_tris);
@@ -38,6 +38,7 @@ struct LoadMemoryParams
     const char* model_file;
     float       light_pos[3];
     int         grid_dimensions;
+    int         num_build_threads; // host threads used to build the acceleration structure
     bool        duplicate_bvh;
     bool        triangles_store_edges;
 
@@ -46,6 +47,7 @@ struct LoadMemoryParams
     bool pack_split_axis;
     bool pack_stream_boundaries;
     bool store_parent_pointers;
+    int  layout_line_size; // log2 words of the cache line to lay BVH nodes out for, 0 for no layout
 
     // Data to be returned
     BVH* bvh;
@@ -79,6 +81,7 @@ struct LoadMemoryParams
         // Scene data
         model_file(NULL),
         grid_dimensions(-1),
+        num_build_threads(1),
         duplicate_bvh(false),
         triangles_store_edges(false),
 
@@ -87,6 +90,7 @@ struct LoadMemoryParams
         pack_split_axis(false),
         pack_stream_boundaries(false),
         store_parent_pointers(false),
+        layout_line_size(0),
 
         // Data to be returned
         bvh(NULL),
@@ -109,4 +113,7 @@ struct LoadMemoryParams
 
 void LoadMemory(LoadMemoryParams &paramsInOut);
 
+// Rewrites the words of a loaded scene that depend on the thread and TM counts
+void WriteMachineParams(FourByte* mem, int num_rotation_threads, int num_TMs);
+
 #endif // _HWRT_LOADMEMORY_H_
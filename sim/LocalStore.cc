@@ -410,6 +410,11 @@ bool LocalStore::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadSt
   return true;
 }
 
+void LocalStore::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 void LocalStore::ClockRise()
 {
   issued_this_cycle = 0;
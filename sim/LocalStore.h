@@ -19,6 +19,7 @@ class LocalStore : public FunctionalUnit {
   ~LocalStore();
   virtual bool SupportsOp(Instruction::Opcode op) const;
   virtual bool AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread);
+  virtual void ResetIssueLimit();
   virtual void ClockRise();
   virtual void ClockFall();
   virtual void print();
@@ -4,34 +4,27 @@
 #include "Instruction.h"
 #include "ThreadState.h"
 #include "SimpleRegisterFile.h"
+#include "IncrementalOutput.h"
 
 #include <pthread.h>
 
 // use this if writes need to be atomic
 extern pthread_mutex_t memory_mutex;
 
-// Windows pipe stuff (needs stdio.h)
-#ifdef WIN32
-# ifndef popen
-#       define popen _popen
-#       define pclose _pclose
-# endif
-#endif
-
 
 MainMemory::MainMemory(int _num_blocks,  int _latency, int _max_bandwidth)
     :latency(_latency)
 {
-  num_blocks = _num_blocks;
   max_bandwidth = _max_bandwidth;
   issued_atominc = false;
-  data = new FourByte[num_blocks];
+  AllocateData(_num_blocks);
   store_count = 0;
   start_framebuffer = 23;
   stores_between_output = 64;
   image_height = 0;
   image_width = 0;
   incremental_output = false;
+  incremental_writer = NULL;
 }
 
 bool MainMemory::IssueInstruction(Instruction* ins, L2Cache* L2, ThreadState* thread,
@@ -67,39 +60,13 @@ bool MainMemory::IssueInstruction(Instruction* ins, L2Cache* L2, ThreadState* th
     pthread_mutex_lock(&memory_mutex);
     data[address].uvalue = arg1.udata;
     store_count++;
+    // Output as we go along
+    if (incremental_writer && store_count%stores_between_output==0)
+      incremental_writer->Snapshot(store_count/stores_between_output, data + start_framebuffer);
     pthread_mutex_unlock(&memory_mutex);
     return true;
   }
 
-  // Output as we go along
-  if(incremental_output && store_count%stores_between_output==0)
-  {
-    char command_buf[512];
-    sprintf(command_buf, "convert PPM:- out%d.png", store_count/stores_between_output);
-    FILE* output = popen(command_buf, "w");
-    if (!output)
-      perror("Failed to open out.png");
-
-    fprintf(output, "P6\n%d %d\n%d\n", image_width, image_height, 255);
-    for (int j = image_height - 1; j >= 0; j--)
-    {
-      for (int i = 0; i < image_width; i++)
-      {
-        int index = start_framebuffer + 3 * (j * image_width + i);
-        float rgb[3];
-        // for gradient/colors we have the result
-        rgb[0] = L2->mem->getData()[index + 0].fvalue;
-        rgb[1] = L2->mem->getData()[index + 1].fvalue;
-        rgb[2] = L2->mem->getData()[index + 2].fvalue;
-        fprintf(output, "%c%c%c",
-                (char)(int)(rgb[0] * 255),
-                (char)(int)(rgb[1] * 255),
-                (char)(int)(rgb[2] * 255));
-      }
-    }
-    pclose(output);
-  }
-
   return false;
 }
 
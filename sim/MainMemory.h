@@ -6,6 +6,7 @@
 #include "MemoryBase.h"
 
 class L2Cache;
+class IncrementalOutput;
 
 class MainMemory : public MemoryBase {
  public:
@@ -40,6 +41,7 @@ class MainMemory : public MemoryBase {
   int stores_between_output;
   int start_framebuffer;
   bool incremental_output;
+  IncrementalOutput* incremental_writer;
 
   // These are implemented in the parent class
   //   void LoadMemory( const char* file,
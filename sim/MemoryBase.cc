@@ -1,14 +1,129 @@
 #include <fstream>
 #include <stdlib.h> // for gcc (exit)
+#include <string.h>
+#include <stdio.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #include "MemoryBase.h"
 #include "IssueUnit.h"
 #include "ThreadState.h"
 #include "WriteRequest.h"
 
-MemoryBase::MemoryBase() : FunctionalUnit(0){}
+MemoryBase::MemoryBase() : FunctionalUnit(0), data(NULL), num_blocks(0), data_bytes(0) {}
 MemoryBase::~MemoryBase() {
-  delete data;
+  // caches share the top level memory's data, only the owner frees it
+  if(data_bytes == 0)
+    return;
+#ifndef WIN32
+  munmap(data, data_bytes);
+#else
+  free(data);
+#endif
+}
+
+void MemoryBase::AllocateData(int _num_blocks) {
+  num_blocks = _num_blocks;
+  // round up to whole image pages so the last stored page of a memory image always fits
+  size_t page_bytes = MEMORY_IMAGE_PAGE_WORDS * sizeof(FourByte);
+  data_bytes = ((num_blocks * sizeof(FourByte) + page_bytes - 1) / page_bytes) * page_bytes;
+#ifndef WIN32
+  // anonymous mappings are page aligned and zero filled, memory images can be mapped over them
+  // NORESERVE so that large simulated memories don't count against swap until they're touched
+  void* region = mmap(NULL, data_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if(region == MAP_FAILED)
+    {
+      perror("MemoryBase: could not allocate simulated memory");
+      exit(1);
+    }
+  data = static_cast<FourByte*>(region);
+#else
+  data = static_cast<FourByte*>(calloc(data_bytes, 1));
+  if(!data)
+    {
+      printf("MemoryBase: could not allocate simulated memory\n");
+      exit(1);
+    }
+#endif
+}
+
+void MemoryBase::EnableHugePages() {
+#if !defined(WIN32) && defined(MADV_HUGEPAGE)
+  if(data_bytes > 0 && madvise(data, data_bytes, MADV_HUGEPAGE) != 0)
+    perror("MemoryBase: madvise(MADV_HUGEPAGE) failed, using normal pages");
+#else
+  printf("MemoryBase: huge pages not supported on this host, using normal pages\n");
+#endif
+}
+
+long long int MemoryBase::ResidentWords(int start, int end) {
+  if(start < 0)
+    start = 0;
+  if(end > num_blocks)
+    end = num_blocks;
+  if(end <= start)
+    return 0;
+#ifndef WIN32
+  if(data_bytes > 0)
+    {
+      // mincore works on whole host pages, count the part of each resident page inside the range
+      long host_page = sysconf(_SC_PAGESIZE);
+      char* begin = reinterpret_cast<char*>(data + start);
+      char* finish = reinterpret_cast<char*>(data + end);
+      char* page_begin = reinterpret_cast<char*>(data) + ((begin - reinterpret_cast<char*>(data)) / host_page) * host_page;
+      size_t num_pages = (finish - page_begin + host_page - 1) / host_page;
+      unsigned char* resident = new unsigned char[num_pages];
+      long long int bytes = 0;
+      if(mincore(page_begin, finish - page_begin, resident) == 0)
+	{
+	  for(size_t i = 0; i < num_pages; i++)
+	    {
+	      if(!(resident[i] & 1))
+		continue;
+	      char* a = page_begin + i * host_page;
+	      char* b = a + host_page;
+	      if(a < begin)
+		a = begin;
+	      if(b > finish)
+		b = finish;
+	      bytes += b - a;
+	    }
+	}
+      delete[] resident;
+      return bytes / sizeof(FourByte);
+    }
+#endif
+  // can't tell, assume everything is resident
+  return end - start;
+}
+
+void MemoryBase::NonZeroPages(int page_words, std::vector<bool>& nonzero) {
+  size_t num_pages = (num_blocks + page_words - 1) / page_words;
+  nonzero.assign(num_pages, false);
+  // Reading an untouched anonymous page maps the shared zero page, it doesn't commit memory
+  for(size_t i = 0; i < num_pages; i++)
+    {
+      int end = (int)((i + 1) * page_words) < num_blocks ? (int)((i + 1) * page_words) : num_blocks;
+      for(int j = i * page_words; j < end && !nonzero[i]; j++)
+	if(data[j].uvalue != 0)
+	  nonzero[i] = true;
+    }
+}
+
+void MemoryBase::PrintResidency(const char* region, int start, int end) {
+  if(end > num_blocks)
+    end = num_blocks;
+  if(end <= start)
+    return;
+  long long int resident = ResidentWords(start, end);
+  printf("   %-18s \t %10.2f of %10.2f MB resident (%6.2f%%)\n", region,
+	 resident * sizeof(FourByte) / (1024.0 * 1024.0),
+	 (end - start) * (double)sizeof(FourByte) / (1024.0 * 1024.0),
+	 100.0 * resident / (end - start));
 }
 FourByte* MemoryBase::getData() {
   return data;
@@ -35,6 +150,14 @@ void MemoryBase::print() {
 void MemoryBase::PrintStats() {
 }
 
+// Section pointers stored in a memory image, in the order they are written
+static const char* memory_image_sections[] = {
+  "start_wq", "start_framebuffer", "start_scene", "start_matls", "start_camera",
+  "start_bg_color", "start_light", "end_memory", "start_permutation",
+  "light_x", "light_y", "light_z"
+};
+static const int num_memory_image_sections = sizeof(memory_image_sections) / sizeof(memory_image_sections[0]);
+
 // Loads memory from file (previously dumped)
 void MemoryBase::LoadMemory(const char* file,
                 int& start_wq, int& start_framebuffer, int& start_scene,
@@ -51,16 +174,127 @@ void MemoryBase::LoadMemory(const char* file,
       exit(1);
     }
 
-  int numRead = fread(data, sizeof(FourByte), num_blocks, input);
+  MemoryImageHeader header;
+  if(fread(&header, sizeof(header), 1, input) != 1 ||
+     strncmp(header.magic, MEMORY_IMAGE_MAGIC, sizeof(header.magic)) != 0)
+    {
+      // not an image, old style raw dump
+      rewind(input);
+      int numRead = fread(data, sizeof(FourByte), num_blocks, input);
+      fclose(input);
+
+      if(numRead <= 0)
+	{
+	  printf("error: could not read memory file %s\n", file);
+	  exit(1);
+	}
 
-  if(numRead <= 0)
+      printf("Read %d blocks from memory dump (mem size = %d)\n", numRead, num_blocks);
+      end_memory = numRead;
+      return;
+    }
+
+  if(header.version != MEMORY_IMAGE_VERSION || header.page_words != MEMORY_IMAGE_PAGE_WORDS)
+    {
+      printf("error: memory file %s has unsupported version %d (page size %d)\n", file, header.version, header.page_words);
+      exit(1);
+    }
+  if(header.end_memory > num_blocks)
+    {
+      printf("error: memory file %s needs %d blocks while memory size is only %d\n", file, header.end_memory, num_blocks);
+      exit(1);
+    }
+
+  // section pointers
+  float light[3] = {0.f, 0.f, 0.f};
+  for(int i = 0; i < header.num_sections; i++)
+    {
+      MemoryImageSection section;
+      if(fread(&section, sizeof(section), 1, input) != 1)
+	{
+	  printf("error: could not read memory file %s\n", file);
+	  exit(1);
+	}
+      section.name[sizeof(section.name) - 1] = '\0';
+      if(strcmp(section.name, "start_wq") == 0) start_wq = section.value.ivalue;
+      else if(strcmp(section.name, "start_framebuffer") == 0) start_framebuffer = section.value.ivalue;
+      else if(strcmp(section.name, "start_scene") == 0) start_scene = section.value.ivalue;
+      else if(strcmp(section.name, "start_matls") == 0) start_matls = section.value.ivalue;
+      else if(strcmp(section.name, "start_camera") == 0) start_camera = section.value.ivalue;
+      else if(strcmp(section.name, "start_bg_color") == 0) start_bg_color = section.value.ivalue;
+      else if(strcmp(section.name, "start_light") == 0) start_light = section.value.ivalue;
+      else if(strcmp(section.name, "end_memory") == 0) end_memory = section.value.ivalue;
+      else if(strcmp(section.name, "start_permutation") == 0) start_permutation = section.value.ivalue;
+      else if(strcmp(section.name, "light_x") == 0) light[0] = section.value.fvalue;
+      else if(strcmp(section.name, "light_y") == 0) light[1] = section.value.fvalue;
+      else if(strcmp(section.name, "light_z") == 0) light[2] = section.value.fvalue;
+      // unknown sections are from newer writers, skip them
+    }
+  light_pos = new float[3];
+  for(int i = 0; i < 3; i++)
+    light_pos[i] = light[i];
+
+  char* stored = new char[header.num_pages];
+  if((int)fread(stored, 1, header.num_pages, input) != header.num_pages)
     {
       printf("error: could not read memory file %s\n", file);
       exit(1);
     }
 
-  printf("Read %d blocks from memory dump (mem size = %d)\n", numRead, num_blocks);
+  // Map each run of stored pages copy-on-write directly over simulated memory (missing pages are
+  // already zero), so nothing is read until the simulation touches it.
+  // Falls back to reading when the host page size doesn't divide the image page size.
+  size_t page_bytes = header.page_words * sizeof(FourByte);
+  bool use_mmap = false;
+#ifndef WIN32
+  long host_page = sysconf(_SC_PAGESIZE);
+  use_mmap = host_page > 0 && page_bytes % host_page == 0 && header.data_offset % host_page == 0 &&
+    data_bytes > 0;
+#endif
+  int mapped_runs = 0;
+  long long int file_page = 0;
+  for(int page = 0; page < header.num_pages; )
+    {
+      if(!stored[page])
+	{
+	  page++;
+	  continue;
+	}
+      int run_end = page;
+      while(run_end < header.num_pages && stored[run_end])
+	run_end++;
+      size_t run_bytes = (run_end - page) * page_bytes;
+      long long int offset = header.data_offset + file_page * page_bytes;
+      FourByte* dest = data + (long long int)page * header.page_words;
+
+      bool mapped = false;
+#ifndef WIN32
+      if(use_mmap)
+	{
+	  void* region = mmap(dest, run_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+			      fileno(input), (off_t)offset);
+	  mapped = (region != MAP_FAILED);
+	  if(mapped)
+	    mapped_runs++;
+	}
+#endif
+      if(!mapped)
+	{
+	  fseek(input, offset, SEEK_SET);
+	  if(fread(dest, 1, run_bytes, input) != run_bytes)
+	    {
+	      printf("error: could not read memory file %s\n", file);
+	      exit(1);
+	    }
+	}
+      file_page += run_end - page;
+      page = run_end;
+    }
+  delete[] stored;
+  fclose(input);
 
+  printf("Read %d blocks from memory image (%d of %d pages stored, %d mapped runs, mem size = %d)\n",
+	 header.end_memory, header.num_stored_pages, header.num_pages, mapped_runs, num_blocks);
 }
 
 // dumps memory to file
@@ -78,8 +312,77 @@ void MemoryBase::WriteMemory(const char* file,
       exit(1);
     }
 
-  printf("Writing %d blocks to memory dump (mem size = %d)\n", end_memory, num_blocks);
-  if((int)fwrite(data, sizeof(FourByte), end_memory, output) != end_memory)
+  MemoryImageHeader header;
+  memset(&header, 0, sizeof(header));
+  strncpy(header.magic, MEMORY_IMAGE_MAGIC, sizeof(header.magic));
+  header.version = MEMORY_IMAGE_VERSION;
+  header.page_words = MEMORY_IMAGE_PAGE_WORDS;
+  header.num_blocks = num_blocks;
+  header.end_memory = end_memory;
+  header.num_pages = (end_memory + MEMORY_IMAGE_PAGE_WORDS - 1) / MEMORY_IMAGE_PAGE_WORDS;
+  header.num_sections = num_memory_image_sections;
+
+  // find the pages with any non-zero words
+  char* stored = new char[header.num_pages];
+  for(int page = 0; page < header.num_pages; page++)
+    {
+      stored[page] = 0;
+      int end = (page + 1) * MEMORY_IMAGE_PAGE_WORDS;
+      if(end > end_memory)
+	end = end_memory;
+      for(int i = page * MEMORY_IMAGE_PAGE_WORDS; i < end; i++)
+	if(data[i].uvalue != 0)
+	  {
+	    stored[page] = 1;
+	    header.num_stored_pages++;
+	    break;
+	  }
+    }
+
+  int table_end = sizeof(header) + header.num_sections * sizeof(MemoryImageSection) + header.num_pages;
+  header.data_offset = ((table_end + MEMORY_IMAGE_ALIGNMENT - 1) / MEMORY_IMAGE_ALIGNMENT) * MEMORY_IMAGE_ALIGNMENT;
+
+  printf("Writing %d blocks to memory image (%d of %d pages stored, mem size = %d)\n",
+	 end_memory, header.num_stored_pages, header.num_pages, num_blocks);
+
+  bool ok = fwrite(&header, sizeof(header), 1, output) == 1;
+  int section_values[] = {start_wq, start_framebuffer, start_scene, start_matls, start_camera,
+			  start_bg_color, start_light, end_memory, start_permutation};
+  for(int i = 0; i < num_memory_image_sections; i++)
+    {
+      MemoryImageSection section;
+      memset(&section, 0, sizeof(section));
+      strncpy(section.name, memory_image_sections[i], sizeof(section.name) - 1);
+      if(i < 9)
+	section.value.ivalue = section_values[i];
+      else
+	section.value.fvalue = light_pos ? light_pos[i - 9] : 0.f;
+      ok = ok && fwrite(&section, sizeof(section), 1, output) == 1;
+    }
+  ok = ok && (int)fwrite(stored, 1, header.num_pages, output) == header.num_pages;
+
+  // pad out to the aligned page data
+  for(int i = table_end; ok && i < header.data_offset; i++)
+    ok = fputc(0, output) != EOF;
+
+  // the last page is always written whole (anything past end_memory is zeroed)
+  FourByte zero_page[MEMORY_IMAGE_PAGE_WORDS];
+  memset(zero_page, 0, sizeof(zero_page));
+  for(int page = 0; ok && page < header.num_pages; page++)
+    {
+      if(!stored[page])
+	continue;
+      int begin = page * MEMORY_IMAGE_PAGE_WORDS;
+      int words = end_memory - begin;
+      if(words > MEMORY_IMAGE_PAGE_WORDS)
+	words = MEMORY_IMAGE_PAGE_WORDS;
+      ok = (int)fwrite(data + begin, sizeof(FourByte), words, output) == words;
+      if(ok && words < MEMORY_IMAGE_PAGE_WORDS)
+	ok = (int)fwrite(zero_page, sizeof(FourByte), MEMORY_IMAGE_PAGE_WORDS - words, output) == MEMORY_IMAGE_PAGE_WORDS - words;
+    }
+  delete[] stored;
+
+  if(!ok || fclose(output) != 0)
     {
       printf("error: could not write memory file %s\n", file);
       exit(1);
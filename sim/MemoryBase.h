@@ -3,6 +3,7 @@
 
 #include "FunctionalUnit.h"
 #include "FourByte.h"
+#include <vector>
 
 class MemoryBase : public FunctionalUnit {
 public:
@@ -33,9 +34,51 @@ public:
 		    int end_memory, float *light_pos, int start_permutation
 		    );
 
+  // Allocates page-aligned, zeroed storage for num_blocks words (owned by this object)
+  // Only address space is reserved, host pages are committed when first touched
+  void AllocateData(int _num_blocks);
+  // Asks the host to back the memory with transparent huge pages
+  void EnableHugePages();
+  // Number of words in [start, end) backed by resident host pages
+  long long int ResidentWords(int start, int end);
+  void PrintResidency(const char* region, int start, int end);
+  // Flags each group of page_words words that holds a non-zero word
+  void NonZeroPages(int page_words, std::vector<bool>& nonzero);
+
   // These should only be used in top level memory... L2 or higher depending
   FourByte* data;
   int num_blocks;
+  size_t data_bytes; // size of the allocation owned by this object, 0 if data is shared
+};
+
+// Binary memory image ("--write-mem-file"). Layout:
+//   MemoryImageHeader
+//   num_sections * MemoryImageSection (section pointers written by the memory loader)
+//   num_pages bytes of page flags (1 = page stored, 0 = all zeros)
+//   stored pages, in order, starting at data_offset
+// data_offset is aligned so the stored pages can be mmap'd straight in to simulated memory.
+#define MEMORY_IMAGE_MAGIC "TRAXMEM"
+#define MEMORY_IMAGE_VERSION 1
+#define MEMORY_IMAGE_PAGE_WORDS 1024
+#define MEMORY_IMAGE_ALIGNMENT 65536
+
+struct MemoryImageHeader
+{
+  char magic[8];
+  int version;
+  int page_words;
+  int num_blocks;
+  int end_memory;
+  int num_pages;
+  int num_stored_pages;
+  int num_sections;
+  int data_offset;
+};
+
+struct MemoryImageSection
+{
+  char name[24];
+  FourByte value;
 };
 
 class CacheUpdate {
@@ -0,0 +1,236 @@
+#include "MemoryBench.h"
+#include "MemoryTrace.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "ThreadState.h"
+#include "L1Cache.h"
+#include "L2Cache.h"
+#include "memory_controller.h"
+#include "params.h"
+#include <boost/chrono.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ADDRESS_REG 0
+#define BENCH_FIRST_LOAD_REG 1
+
+enum BenchPattern {
+  BENCH_SEQUENTIAL,
+  BENCH_STRIDED,
+  BENCH_RANDOM,
+  BENCH_BVH,
+  BENCH_HOTSET,
+  NUM_BENCH_PATTERNS
+};
+
+static const char* pattern_names[NUM_BENCH_PATTERNS] = {
+  "sequential",
+  "strided",
+  "random",
+  "bvh",
+  "hotset",
+};
+
+static int FindPattern(const char* pattern)
+{
+  for (int i = 0; i < NUM_BENCH_PATTERNS; i++)
+    if (strcmp(pattern, pattern_names[i]) == 0)
+      return i;
+  return -1;
+}
+
+bool ValidMemoryBenchPattern(const char* pattern)
+{
+  return FindPattern(pattern) >= 0;
+}
+
+struct InFlightLoad {
+  int reg;
+  long long int first_attempt; // the cycle the L1 was first asked for it, retries count as latency
+};
+
+struct BenchThread {
+  ThreadState* thread;
+  L1Cache* L1;
+  Instruction* ins;
+  int index;                // global thread number
+  unsigned int seed;
+  long long int count;      // accesses generated so far
+  int node;                 // bvh: current tree node
+  int pending;              // next address, -1 if one has to be generated
+  long long int pending_since; // the cycle pending was first tried
+  std::vector<InFlightLoad> in_flight;
+};
+
+// xorshift, cheap and good enough to scatter addresses
+static unsigned int NextRandom(unsigned int& seed)
+{
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
+
+static int NextAddress(BenchThread& bt, int pattern, int footprint, int num_threads, int line_words)
+{
+  long long int i = bt.count++;
+  switch (pattern) {
+  case BENCH_SEQUENTIAL: {
+    int slice = footprint / num_threads;
+    return bt.index * slice + (int)(i % slice);
+  }
+  case BENCH_STRIDED:
+    return (int)(((i * num_threads + bt.index) * line_words) % footprint);
+  case BENCH_RANDOM:
+    return NextRandom(bt.seed) % footprint;
+  case BENCH_BVH: {
+    // descend to a random child, restart at the root past the bottom of the footprint
+    int num_nodes = footprint / MEMORY_BENCH_NODE_WORDS;
+    bt.node = 2 * bt.node + 1 + (NextRandom(bt.seed) & 1);
+    if (bt.node >= num_nodes)
+      bt.node = 0;
+    return bt.node * MEMORY_BENCH_NODE_WORDS;
+  }
+  default: {
+    int hot = footprint < MEMORY_BENCH_HOT_WORDS ? footprint : MEMORY_BENCH_HOT_WORDS;
+    if (NextRandom(bt.seed) % 10 != 0)
+      return NextRandom(bt.seed) % hot;
+    return NextRandom(bt.seed) % footprint;
+  }
+  }
+}
+
+// Finds a register no load is writing, -1 if there is none
+static int FreeRegister(ThreadState* thread)
+{
+  for (int reg = BENCH_FIRST_LOAD_REG; reg < thread->registers->num_registers; reg++)
+    if (thread->writes_in_flight[reg] == 0)
+      return reg;
+  return -1;
+}
+
+long long int MemoryBenchmark(const char* pattern_name, long long int num_accesses, int footprint,
+			      std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled)
+{
+  int pattern = FindPattern(pattern_name);
+  int threads_per_TM = cores[0]->num_thread_procs;
+  int num_threads = (int)cores.size() * threads_per_TM;
+  int line_words = 1 << L2s[0]->line_size;
+  int max_in_flight = pattern == BENCH_BVH ? 1 : MEMORY_BENCH_MAX_IN_FLIGHT;
+  if (footprint < num_threads * line_words) {
+    printf("ERROR: --memory-bench-footprint must be at least %d words for %d threads\n",
+	   num_threads * line_words, num_threads);
+    exit(1);
+  }
+  printf("Memory benchmark: %s, %lld loads over %d words from %d threads\n",
+	 pattern_name, num_accesses, footprint, num_threads);
+
+  MemorySystemDriver driver(cores, L2s, num_L2s, usimm_enabled);
+  std::vector<BenchThread> threads(num_threads);
+  for (int t = 0; t < num_threads; t++) {
+    BenchThread& bt = threads[t];
+    bt.thread = driver.threads[t];
+    bt.L1 = cores[t / threads_per_TM]->L1;
+    bt.ins = new Instruction(Instruction::LOAD, 0, BENCH_ADDRESS_REG, 0, 0);
+    bt.index = t;
+    bt.seed = 2463534242u + 7919u * t;
+    bt.count = 0;
+    bt.node = 0;
+    bt.pending = -1;
+    bt.pending_since = 0;
+  }
+
+  long long int issued = 0, completed = 0, total_latency = 0, retries = 0;
+  long long int start_L1_hits = 0, start_L2_hits = 0, start_L2_accesses = 0;
+  for (size_t c = 0; c < cores.size(); c++)
+    start_L1_hits += cores[c]->L1->hits;
+  for (int i = 0; i < num_L2s; i++) {
+    start_L2_hits += L2s[i]->hits;
+    start_L2_accesses += L2s[i]->accesses;
+  }
+
+  boost::chrono::steady_clock::time_point host_start = boost::chrono::steady_clock::now();
+  long long int& cycle = driver.cycle;
+  while (completed < num_accesses) {
+    driver.BeginCycle();
+
+    for (int t = 0; t < num_threads; t++) {
+      BenchThread& bt = threads[t];
+      ThreadState* thread = bt.thread;
+
+      // Retire loads whose data has arrived
+      for (size_t i = 0; i < bt.in_flight.size(); ) {
+	if (thread->writes_in_flight[bt.in_flight[i].reg] == 0) {
+	  total_latency += cycle - bt.in_flight[i].first_attempt;
+	  completed++;
+	  bt.in_flight[i] = bt.in_flight.back();
+	  bt.in_flight.pop_back();
+	}
+	else
+	  i++;
+      }
+
+      // One new load per thread per cycle, the last one is retried if the L1 turned it away
+      if (issued >= num_accesses || (int)bt.in_flight.size() >= max_in_flight)
+	continue;
+      int reg = FreeRegister(thread);
+      if (reg < 0)
+	continue;
+      if (bt.pending < 0) {
+	bt.pending = NextAddress(bt, pattern, footprint, num_threads, line_words);
+	bt.pending_since = cycle;
+      }
+      thread->registers->idata[BENCH_ADDRESS_REG] = bt.pending;
+      bt.ins->args[0] = reg;
+      if (!bt.L1->Access(*bt.ins, cycle, thread)) {
+	retries++;
+	continue;
+      }
+      InFlightLoad load;
+      load.reg = reg;
+      load.first_attempt = bt.pending_since;
+      bt.in_flight.push_back(load);
+      bt.pending = -1;
+      issued++;
+    }
+
+    driver.EndCycle();
+  }
+  double host_seconds = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - host_start).count();
+
+  long long int L1_hits = -start_L1_hits, L2_hits = -start_L2_hits, L2_accesses = -start_L2_accesses;
+  for (size_t c = 0; c < cores.size(); c++)
+    L1_hits += cores[c]->L1->hits;
+  for (int i = 0; i < num_L2s; i++) {
+    L2_hits += L2s[i]->hits;
+    L2_accesses += L2s[i]->accesses;
+  }
+  long long int dram_lines = 0;
+  if (usimm_enabled) {
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      dram_lines += stats_reads_completed[c];
+  }
+  else
+    dram_lines = L2_accesses - L2_hits;
+
+  int word_size = 4;
+  float Hz = 1000000000;
+  printf("Memory benchmark results (%s):\n", pattern_name);
+  printf("   Loads: \t\t\t %lld\n", completed);
+  printf("   Cycles: \t\t\t %lld\n", cycle);
+  printf("   L1 hit rate: \t\t %f\n", static_cast<double>(L1_hits) / completed);
+  printf("   L2 hit rate: \t\t %f\n", L2_accesses > 0 ? static_cast<double>(L2_hits) / L2_accesses : 0.);
+  printf("   Average load latency: \t %.2f cycles\n", static_cast<double>(total_latency) / completed);
+  printf("   L1 retries: \t\t\t %lld\n", retries);
+  printf("   L1 to register bandwidth: \t %f GB/s at %dMHz\n",
+	 static_cast<double>(completed) * word_size / cycle, (int)(Hz / 1000000));
+  printf("   memory to L2 bandwidth: \t %f GB/s at %dMHz\n",
+	 static_cast<double>(dram_lines) * word_size * line_words / cycle, (int)(Hz / 1000000));
+  printf("   Host time: \t\t\t %.3f s (%.1f ns per load, %.0f cycles/s)\n\n",
+	 host_seconds, 1e9 * host_seconds / completed, cycle / host_seconds);
+
+  for (int t = 0; t < num_threads; t++)
+    delete threads[t].ins;
+  return cycle;
+}
@@ -0,0 +1,37 @@
+#ifndef _SIMHWRT_MEMORY_BENCH_H_
+#define _SIMHWRT_MEMORY_BENCH_H_
+
+// Memory-system microbenchmarks ("--memory-bench"). Every thread of every TM streams
+// synthetic loads straight in to its L1 (with the L2s and usimm behind it), no program
+// is run. Reports the modeled hit rates, latency and bandwidth alongside what the model
+// costs on the host per access, so the cache and DRAM code can be tuned in isolation.
+//
+// Patterns (word addresses within the footprint):
+//   sequential - each thread walks its own contiguous slice
+//   strided    - threads interleave, each access one L2 line past the last
+//   random     - uniform over the footprint
+//   bvh        - pointer chase down an implicit binary tree of 8-word nodes, one load in
+//                flight per thread. Top levels stay hot, leaves are mostly misses
+//   hotset     - 90% of accesses in a small hot region, the rest uniform
+// All patterns except bvh keep up to MEMORY_BENCH_MAX_IN_FLIGHT loads in flight per thread.
+// A load's latency counts from the first time it was tried, so cycles spent retrying it
+// after the L1 turned it away are part of it.
+
+#include <vector>
+
+#define MEMORY_BENCH_MAX_IN_FLIGHT 8
+#define MEMORY_BENCH_NODE_WORDS 8
+#define MEMORY_BENCH_HOT_WORDS 4096
+
+class TraxCore;
+class L2Cache;
+
+// Returns false for an unknown pattern name
+bool ValidMemoryBenchPattern(const char* pattern);
+
+// Issues num_accesses loads in total over a footprint of footprint words starting at address 0,
+// and waits for them all to complete. Returns the number of cycles that took.
+long long int MemoryBenchmark(const char* pattern, long long int num_accesses, int footprint,
+			      std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled);
+
+#endif // _SIMHWRT_MEMORY_BENCH_H_
@@ -0,0 +1,256 @@
+#include "MemoryTrace.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "ThreadState.h"
+#include "L1Cache.h"
+#include "L2Cache.h"
+#include "usimm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REPLAY_CHUNK 4096
+
+// Registers the replay uses on each thread, all others are load destinations
+#define REPLAY_ADDRESS_REG 0
+#define REPLAY_VALUE_REG 1
+#define REPLAY_FIRST_LOAD_REG 2
+
+MemoryTraceWriter::MemoryTraceWriter(const char* filename, int num_TMs, int threads_per_TM)
+{
+  if (threads_per_TM > 256 || num_TMs > 65536) {
+    printf("ERROR: memory traces support at most 65536 TMs with 256 threads each\n");
+    exit(1);
+  }
+  MemoryTraceHeader header;
+  memset(&header, 0, sizeof(header));
+  strncpy(header.magic, MEMORY_TRACE_MAGIC, sizeof(header.magic));
+  header.version = MemoryTrace::version;
+  header.num_TMs = num_TMs;
+  header.threads_per_TM = threads_per_TM;
+  buffer = new DiskBuffer<MemoryTrace, MemoryTraceHeader>(filename, REPLAY_CHUNK, header);
+  pthread_mutex_init(&trace_mutex, NULL);
+  num_records = 0;
+}
+
+MemoryTraceWriter::~MemoryTraceWriter()
+{
+  delete buffer;
+  pthread_mutex_destroy(&trace_mutex);
+}
+
+void MemoryTraceWriter::Record(long long int cycle, int address, ThreadState* thread, Instruction::Opcode op)
+{
+  MemoryTrace record;
+  record.cycle = cycle;
+  record.address = address;
+  record.tm = thread->core_id;
+  record.thread = thread->thread_id;
+  if (op == Instruction::STORE)
+    record.op = MemoryTrace::Store;
+  else if (op == Instruction::ATOMIC_FPADD)
+    record.op = MemoryTrace::AtomicAdd;
+  else if (op == Instruction::LOADL1)
+    record.op = MemoryTrace::LoadL1;
+  else
+    record.op = MemoryTrace::Load;
+
+  pthread_mutex_lock(&trace_mutex);
+  buffer->AddItem(record);
+  num_records++;
+  pthread_mutex_unlock(&trace_mutex);
+}
+
+MemorySystemDriver::MemorySystemDriver(std::vector<TraxCore*>& _cores, L2Cache** _L2s, int _num_L2s,
+				       bool _usimm_enabled) :
+  cores(_cores), L2s(_L2s), num_L2s(_num_L2s), usimm_enabled(_usimm_enabled), cycle(0)
+{
+  for (size_t c = 0; c < cores.size(); c++)
+    for (int t = 0; t < cores[c]->num_thread_procs; t++)
+      threads.push_back(cores[c]->thread_procs[t]->thread_states[0]);
+}
+
+void MemorySystemDriver::BeginCycle()
+{
+  for (size_t c = 0; c < cores.size(); c++)
+    cores[c]->L1->ClockRise();
+}
+
+void MemorySystemDriver::EndCycle()
+{
+  for (size_t c = 0; c < cores.size(); c++)
+    cores[c]->L1->ClockFall();
+  for (size_t i = 0; i < threads.size(); i++)
+    threads[i]->ApplyWrites(cycle);
+  for (int i = 0; i < num_L2s; i++) {
+    L2s[i]->ClockRise();
+    L2s[i]->ClockFall();
+  }
+  if (usimm_enabled) {
+    for (int i = 0; i < DRAM_CLOCK_MULTIPLIER; i++)
+      usimmClock();
+  }
+  cycle++;
+}
+
+bool MemorySystemDriver::Idle()
+{
+  if (usimm_enabled && usimmIsBusy())
+    return false;
+  for (size_t i = 0; i < threads.size(); i++)
+    if (!threads[i]->write_requests.empty())
+      return false;
+  return true;
+}
+
+// Per-thread replay state. The thread's own registers stand in for the program's:
+// the address goes in a fixed register and loads rotate through the rest, so a load is
+// never aimed at a register that still has a load in flight.
+struct ReplayThread {
+  ThreadState* thread;
+  L1Cache* L1;
+  Instruction* ins;
+  int next_reg;
+  bool blocked; // an older access is waiting, keep this thread's accesses in order
+};
+
+static bool ReplayAccess(ReplayThread& rt, const MemoryTrace& record, long long int cycle)
+{
+  ThreadState* thread = rt.thread;
+  Instruction* ins = rt.ins;
+  thread->registers->idata[REPLAY_ADDRESS_REG] = record.address;
+  ins->args[2] = 0;
+
+  if (record.op == MemoryTrace::Store || record.op == MemoryTrace::AtomicAdd) {
+    ins->op = record.op == MemoryTrace::Store ? Instruction::STORE : Instruction::ATOMIC_FPADD;
+    ins->args[0] = REPLAY_ADDRESS_REG;
+    ins->args[1] = REPLAY_VALUE_REG;
+    return rt.L1->Access(*ins, cycle, thread);
+  }
+
+  int num_regs = thread->registers->num_registers - REPLAY_FIRST_LOAD_REG;
+  for (int i = 0; i < num_regs; i++) {
+    int reg = REPLAY_FIRST_LOAD_REG + (rt.next_reg + i) % num_regs;
+    if (thread->writes_in_flight[reg] > 0)
+      continue;
+    ins->op = record.op == MemoryTrace::LoadL1 ? Instruction::LOADL1 : Instruction::LOAD;
+    ins->args[0] = reg;
+    ins->args[1] = REPLAY_ADDRESS_REG;
+    if (!rt.L1->Access(*ins, cycle, thread))
+      return false;
+    rt.next_reg = (rt.next_reg + i + 1) % num_regs;
+    return true;
+  }
+  // every register is waiting on a load
+  return false;
+}
+
+long long int ReplayMemoryTrace(const char* filename, std::vector<TraxCore*>& cores,
+				L2Cache** L2s, int num_L2s, bool usimm_enabled)
+{
+  FILE* input = fopen(filename, "rb");
+  if (!input) {
+    perror("Failed to open memory trace for reading.\n");
+    exit(1);
+  }
+  MemoryTraceHeader header;
+  if (fread(&header, sizeof(header), 1, input) != 1 ||
+      strncmp(header.magic, MEMORY_TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != MemoryTrace::version) {
+    printf("ERROR: %s is not a version %d memory trace\n", filename, MemoryTrace::version);
+    exit(1);
+  }
+  int threads_per_TM = cores[0]->num_thread_procs;
+  if (header.num_TMs != (int)cores.size() || header.threads_per_TM != threads_per_TM) {
+    printf("ERROR: memory trace was recorded with %d TMs of %d threads, simulator has %d TMs of %d threads\n",
+	   header.num_TMs, header.threads_per_TM, (int)cores.size(), threads_per_TM);
+    exit(1);
+  }
+  if (cores[0]->num_regs <= REPLAY_FIRST_LOAD_REG) {
+    printf("ERROR: memory trace replay needs more than %d registers\n", REPLAY_FIRST_LOAD_REG);
+    exit(1);
+  }
+  printf("Replaying memory trace %s\n", filename);
+
+  MemorySystemDriver driver(cores, L2s, num_L2s, usimm_enabled);
+  std::vector<ReplayThread> threads(driver.threads.size());
+  for (size_t i = 0; i < threads.size(); i++) {
+    ReplayThread& rt = threads[i];
+    rt.thread = driver.threads[i];
+    rt.L1 = cores[i / threads_per_TM]->L1;
+    rt.ins = new Instruction(Instruction::LOAD, 0, 0, 0, 0);
+    rt.next_reg = 0;
+    rt.blocked = false;
+    rt.thread->registers->idata[REPLAY_VALUE_REG] = 0;
+  }
+
+  MemoryTrace* chunk = new MemoryTrace[REPLAY_CHUNK];
+  size_t chunk_size = 0, chunk_pos = 0;
+  bool trace_done = false;
+  std::vector<MemoryTrace> waiting, still_waiting;
+  long long int num_accesses = 0, num_delayed = 0, delay_cycles = 0, last_recorded = 0;
+
+  long long int& cycle = driver.cycle;
+  while (true) {
+    driver.BeginCycle();
+
+    // Accesses the caches turned away go first, in their original order
+    still_waiting.clear();
+    for (size_t i = 0; i < threads.size(); i++)
+      threads[i].blocked = false;
+    for (size_t i = 0; i < waiting.size(); i++) {
+      ReplayThread& rt = threads[waiting[i].tm * threads_per_TM + waiting[i].thread];
+      if (rt.blocked || !ReplayAccess(rt, waiting[i], cycle)) {
+	rt.blocked = true;
+	still_waiting.push_back(waiting[i]);
+      }
+      else
+	delay_cycles += cycle - waiting[i].cycle;
+    }
+    waiting.swap(still_waiting);
+
+    // Then everything recorded for this cycle
+    while (!trace_done) {
+      if (chunk_pos == chunk_size) {
+	chunk_size = fread(chunk, sizeof(MemoryTrace), REPLAY_CHUNK, input);
+	chunk_pos = 0;
+	if (chunk_size == 0) {
+	  trace_done = true;
+	  break;
+	}
+      }
+      MemoryTrace& record = chunk[chunk_pos];
+      if ((long long int)record.cycle > cycle)
+	break;
+      if (record.tm >= cores.size() || record.thread >= threads_per_TM) {
+	printf("ERROR: memory trace record for TM %d thread %d is out of range\n", record.tm, record.thread);
+	exit(1);
+      }
+      ReplayThread& rt = threads[record.tm * threads_per_TM + record.thread];
+      if (rt.blocked || !ReplayAccess(rt, record, cycle)) {
+	rt.blocked = true;
+	waiting.push_back(record);
+	num_delayed++;
+      }
+      last_recorded = record.cycle;
+      num_accesses++;
+      chunk_pos++;
+    }
+
+    driver.EndCycle();
+
+    if (trace_done && waiting.empty() && driver.Idle())
+      break;
+  }
+  fclose(input);
+
+  printf("Replayed %lld accesses in %lld cycles (last access was recorded on cycle %lld)\n",
+	 num_accesses, cycle, last_recorded);
+  printf("   %lld accesses were delayed by the memory system, %lld cycles in total\n",
+	 num_delayed, delay_cycles);
+
+  delete [] chunk;
+  for (size_t i = 0; i < threads.size(); i++)
+    delete threads[i].ins;
+  return cycle;
+}
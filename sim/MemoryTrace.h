@@ -0,0 +1,88 @@
+#ifndef _SIMHWRT_MEMORY_TRACE_H_
+#define _SIMHWRT_MEMORY_TRACE_H_
+
+// Memory-access traces ("--memory-trace") and trace-driven replay ("--replay-memory-trace").
+// A trace holds every access accepted by the L1s of a full simulation. Replaying it drives
+// the L1s, L2s and usimm directly with no TraxCores clocked, so memory-system parameters
+// can be swept far faster than re-running the whole machine. Replay is open-loop: each
+// access is issued on its recorded cycle (or later if the caches push back), so changes
+// in memory latency do not feed back in to when the program would have issued.
+
+#include "DiskBuffer.h"
+#include "Instruction.h"
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+
+#define MEMORY_TRACE_MAGIC "TRAXMTR"
+
+class ThreadState;
+class TraxCore;
+class L2Cache;
+
+struct MemoryTraceHeader {
+  char magic[8];
+  unsigned int version;
+  int num_TMs;
+  int threads_per_TM;
+};
+
+struct MemoryTraceV1 {
+  uint64_t cycle;
+  int32_t address;
+  uint16_t tm;
+  uint8_t thread;
+  enum {
+    Load=0,
+    Store,
+    AtomicAdd,
+    LoadL1
+  };
+  uint8_t op;
+  static const unsigned version = 1;
+};
+typedef MemoryTraceV1 MemoryTrace;
+
+class MemoryTraceWriter {
+public:
+  MemoryTraceWriter(const char* filename, int num_TMs, int threads_per_TM);
+  ~MemoryTraceWriter();
+
+  // Thread safe, the L1s of all simulation threads share one writer
+  void Record(long long int cycle, int address, ThreadState* thread, Instruction::Opcode op);
+
+  DiskBuffer<MemoryTrace, MemoryTraceHeader>* buffer;
+  pthread_mutex_t trace_mutex;
+  long long int num_records;
+};
+
+// Clocks the L1s of 'cores' (which are never clocked themselves), the L2s and usimm one
+// cycle at a time, for the trace replay and the memory benchmarks (MemoryBench.h). The
+// accesses of a cycle are made on the L1s between BeginCycle and EndCycle.
+class MemorySystemDriver {
+public:
+  MemorySystemDriver(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled);
+
+  // The L1s' rising edge
+  void BeginCycle();
+  // The rest of the cycle: the L1s' falling edge, returned loads written back, the L2s
+  // and usimm. Then moves on to the next cycle.
+  void EndCycle();
+  // No access is still on its way through the memory system
+  bool Idle();
+
+  std::vector<TraxCore*>& cores;
+  L2Cache** L2s;
+  int num_L2s;
+  bool usimm_enabled;
+  // The first thread of every thread processor, TM by TM, the accesses are made for these
+  std::vector<ThreadState*> threads;
+  long long int cycle;
+};
+
+// Feeds a trace through the L1s of 'cores', the L2s and usimm with a MemorySystemDriver,
+// until every access has completed. Returns the number of cycles that took.
+long long int ReplayMemoryTrace(const char* filename, std::vector<TraxCore*>& cores,
+				L2Cache** L2s, int num_L2s, bool usimm_enabled);
+
+#endif // _SIMHWRT_MEMORY_TRACE_H_
@@ -0,0 +1,474 @@
+#include "ProfileExport.h"
+#include "Assembler.h"
+#include "Instruction.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "IssueUnit.h"
+#include <algorithm>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+
+bool pc_profiling = false;
+bool kernel_trace = false;
+
+static bool CompareFunctions(const ProfileFunction& a, const ProfileFunction& b)
+{
+  return a.start_pc < b.start_pc;
+}
+
+void ProfileFunctions(const std::vector<symbol*>& text_labels, std::vector<ProfileFunction>& functions)
+{
+  for (size_t i = 0; i < text_labels.size(); i++) {
+    if (text_labels[i]->names[0][0] == '$')
+      continue;
+    ProfileFunction function;
+    function.start_pc = text_labels[i]->address;
+    function.name = text_labels[i]->names[0];
+    functions.push_back(function);
+  }
+  std::stable_sort(functions.begin(), functions.end(), CompareFunctions);
+}
+
+static FILE* OpenOutput(const char* filename)
+{
+  FILE* output = fopen(filename, "wb");
+  if (!output) {
+    printf("Error: could not open \"%s\" for writing. Profile not written.\n", filename);
+  }
+  return output;
+}
+
+static long long int Loads(const Instruction* ins)
+{
+  long long int loads = 0;
+  for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+    loads += ins->mem_sources[i];
+  return loads;
+}
+
+static bool HasCost(const Instruction* ins)
+{
+  return ins->executions > 0 || ins->data_stalls > 0 || ins->contention_stalls > 0 ||
+    Loads(ins) > 0 || ins->l1_conflicts > 0 || ins->l2_stalls > 0;
+}
+
+// Names of the memory sources as callgrind events and pprof sample types
+static const char* source_events[NUM_MEM_SOURCES] = {
+  "", "L1Hit", "OtherL1", "InFlight", "L2Hit", "DRAM"
+};
+static const char* source_types[NUM_MEM_SOURCES] = {
+  "", "l1_hit", "other_l1", "in_flight", "l2_hit", "dram"
+};
+
+// Source file and line of an instruction, falling back to the assembly
+static void SourceLine(const Instruction* ins, const char* assem_file, const std::vector<std::string>& source_names,
+		       std::string& file, int& line)
+{
+  if (ins->srcInfo.fileNum >= 0 && ins->srcInfo.fileNum < (int)source_names.size()) {
+    file = source_names[ins->srcInfo.fileNum];
+    line = ins->srcInfo.lineNum;
+  }
+  else {
+    file = assem_file;
+    line = ins->lineNum;
+  }
+}
+
+// Index in to functions of the function containing pc, -1 if it is before the first label.
+// Advances function_index, so PCs must be visited in order.
+static int FunctionOf(int pc, const std::vector<ProfileFunction>& functions, int& function_index)
+{
+  while (function_index + 1 < (int)functions.size() && functions[function_index + 1].start_pc <= pc)
+    function_index++;
+  if (function_index < 0 || functions[function_index].start_pc > pc)
+    return -1;
+  return function_index;
+}
+
+static const char* FunctionName(int function, const std::vector<ProfileFunction>& functions)
+{
+  return function < 0 ? "<unknown>" : functions[function].name.c_str();
+}
+
+void WriteCallgrindProfile(const char* filename, const char* assem_file,
+			   const std::vector<Instruction*>& instructions,
+			   const std::vector<ProfileFunction>& functions,
+			   const std::vector<std::string>& source_names)
+{
+  FILE* output = OpenOutput(filename);
+  if (!output)
+    return;
+
+  long long int total_issue = 0, total_data = 0, total_contention = 0, total_latency = 0;
+  long long int total_sources[NUM_MEM_SOURCES] = {0};
+  for (size_t pc = 0; pc < instructions.size(); pc++) {
+    total_issue += instructions[pc]->executions;
+    total_data += instructions[pc]->data_stalls;
+    total_contention += instructions[pc]->contention_stalls;
+    for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+      total_sources[i] += instructions[pc]->mem_sources[i];
+    total_latency += instructions[pc]->mem_latency;
+  }
+
+  fprintf(output, "# callgrind format\n");
+  fprintf(output, "version: 1\n");
+  fprintf(output, "creator: simtrax\n");
+  fprintf(output, "cmd: %s\n", assem_file);
+  fprintf(output, "positions: instr line\n");
+  fprintf(output, "events: Issue DataStall ContentionStall");
+  for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+    fprintf(output, " %s", source_events[i]);
+  fprintf(output, " LoadCycles\n");
+  fprintf(output, "summary: %lld %lld %lld", total_issue, total_data, total_contention);
+  for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+    fprintf(output, " %lld", total_sources[i]);
+  fprintf(output, " %lld\n\n", total_latency);
+  fprintf(output, "ob=%s\n", assem_file);
+
+  int function_index = -1;
+  int current_function = -2;
+  std::string current_file;
+  for (size_t pc = 0; pc < instructions.size(); pc++) {
+    const Instruction* ins = instructions[pc];
+    int function = FunctionOf((int)pc, functions, function_index);
+    if (!HasCost(ins))
+      continue;
+
+    std::string file;
+    int line;
+    SourceLine(ins, assem_file, source_names, file, line);
+    if (function != current_function) {
+      // a function's file is where its first costly instruction is, fi= switches within it
+      fprintf(output, "fl=%s\n", file.c_str());
+      fprintf(output, "fn=%s\n", FunctionName(function, functions));
+      current_function = function;
+      current_file = file;
+    }
+    else if (file != current_file) {
+      fprintf(output, "fi=%s\n", file.c_str());
+      current_file = file;
+    }
+    fprintf(output, "0x%x %d %lld %lld %lld", (unsigned int)pc, line < 0 ? 0 : line,
+	    ins->executions, ins->data_stalls, ins->contention_stalls);
+    if (Loads(ins) > 0) {
+      for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+	fprintf(output, " %lld", ins->mem_sources[i]);
+      fprintf(output, " %lld", ins->mem_latency);
+    }
+    fprintf(output, "\n");
+  }
+
+  fclose(output);
+  printf("Wrote callgrind profile to '%s'.\n", filename);
+}
+
+
+// Minimal protobuf encoding for the pprof profile.proto messages
+static void Varint(std::string& out, unsigned long long int value)
+{
+  while (value >= 0x80) {
+    out += (char)((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  out += (char)value;
+}
+
+static void VarintField(std::string& out, int field, unsigned long long int value)
+{
+  Varint(out, (unsigned long long int)field << 3);
+  Varint(out, value);
+}
+
+static void BytesField(std::string& out, int field, const std::string& bytes)
+{
+  Varint(out, ((unsigned long long int)field << 3) | 2);
+  Varint(out, bytes.size());
+  out += bytes;
+}
+
+class StringTable {
+public:
+  std::vector<std::string> strings;
+  std::map<std::string, int> ids;
+
+  StringTable()
+  {
+    Id("");
+  }
+
+  int Id(const std::string& s)
+  {
+    std::map<std::string, int>::iterator it = ids.find(s);
+    if (it != ids.end())
+      return it->second;
+    ids[s] = (int)strings.size();
+    strings.push_back(s);
+    return (int)strings.size() - 1;
+  }
+};
+
+static std::string ValueType(StringTable& strings, const char* type, const char* unit)
+{
+  std::string message;
+  VarintField(message, 1, strings.Id(type));
+  VarintField(message, 2, strings.Id(unit));
+  return message;
+}
+
+void WritePprofProfile(const char* filename, const char* assem_file,
+		       const std::vector<Instruction*>& instructions,
+		       const std::vector<ProfileFunction>& functions,
+		       const std::vector<std::string>& source_names)
+{
+  FILE* output = OpenOutput(filename);
+  if (!output)
+    return;
+
+  StringTable strings;
+  std::string profile;
+  BytesField(profile, 1, ValueType(strings, "issue", "cycles"));
+  BytesField(profile, 1, ValueType(strings, "data_stall", "cycles"));
+  BytesField(profile, 1, ValueType(strings, "contention_stall", "cycles"));
+  for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+    BytesField(profile, 1, ValueType(strings, source_types[i], "count"));
+  BytesField(profile, 1, ValueType(strings, "load_latency", "cycles"));
+
+  // pprof functions have a single file, so a label whose code comes from several source
+  // files (inlining) becomes one function per file
+  std::map<std::pair<int, int>, unsigned long long int> function_ids;
+  std::string function_messages;
+
+  int function_index = -1;
+  for (size_t pc = 0; pc < instructions.size(); pc++) {
+    const Instruction* ins = instructions[pc];
+    int function = FunctionOf((int)pc, functions, function_index);
+    if (!HasCost(ins))
+      continue;
+
+    std::string file;
+    int line;
+    SourceLine(ins, assem_file, source_names, file, line);
+    std::pair<int, int> key(function, strings.Id(file));
+    std::map<std::pair<int, int>, unsigned long long int>::iterator it = function_ids.find(key);
+    unsigned long long int function_id;
+    if (it == function_ids.end()) {
+      function_id = function_ids.size() + 1;
+      function_ids[key] = function_id;
+      int name = strings.Id(FunctionName(function, functions));
+      std::string message;
+      VarintField(message, 1, function_id);
+      VarintField(message, 2, name);
+      VarintField(message, 3, name);
+      VarintField(message, 4, key.second);
+      BytesField(function_messages, 5, message);
+    }
+    else
+      function_id = it->second;
+
+    // One sample per PC, the location id is the PC + 1 (0 is reserved)
+    std::string values;
+    Varint(values, ins->executions);
+    Varint(values, ins->data_stalls);
+    Varint(values, ins->contention_stalls);
+    for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+      Varint(values, ins->mem_sources[i]);
+    Varint(values, ins->mem_latency);
+    std::string location_ids;
+    Varint(location_ids, pc + 1);
+    std::string sample;
+    BytesField(sample, 1, location_ids);
+    BytesField(sample, 2, values);
+    BytesField(profile, 2, sample);
+
+    std::string line_message;
+    VarintField(line_message, 1, function_id);
+    VarintField(line_message, 2, line < 0 ? 0 : line);
+    std::string location;
+    VarintField(location, 1, pc + 1);
+    VarintField(location, 3, pc);
+    BytesField(location, 4, line_message);
+    BytesField(profile, 4, location);
+  }
+  profile += function_messages;
+
+  // period: one sample value is one cycle
+  BytesField(profile, 11, ValueType(strings, "cycles", "count"));
+  VarintField(profile, 12, 1);
+  VarintField(profile, 14, strings.Id("issue"));
+
+  for (size_t i = 0; i < strings.strings.size(); i++)
+    BytesField(profile, 6, strings.strings[i]);
+
+  fwrite(profile.data(), 1, profile.size(), output);
+  fclose(output);
+  printf("Wrote pprof profile to '%s'.\n", filename);
+}
+
+
+// One row of the memory profile, a PC or a source line
+struct MemoryCounts {
+  long long int sources[NUM_MEM_SOURCES];
+  long long int latency;
+  long long int l1_conflicts;
+  long long int l2_stalls;
+  std::string label;
+
+  MemoryCounts() : latency(0), l1_conflicts(0), l2_stalls(0)
+  {
+    for (int i = 0; i < NUM_MEM_SOURCES; i++)
+      sources[i] = 0;
+  }
+
+  void Add(const Instruction* ins)
+  {
+    for (int i = 0; i < NUM_MEM_SOURCES; i++)
+      sources[i] += ins->mem_sources[i];
+    latency += ins->mem_latency;
+    l1_conflicts += ins->l1_conflicts;
+    l2_stalls += ins->l2_stalls;
+  }
+
+  long long int Loads() const
+  {
+    long long int loads = 0;
+    for (int i = MEM_SOURCE_NONE + 1; i < NUM_MEM_SOURCES; i++)
+      loads += sources[i];
+    return loads;
+  }
+};
+
+// Most total load cycles first
+static bool CompareMemoryCounts(const MemoryCounts& a, const MemoryCounts& b)
+{
+  return a.latency > b.latency;
+}
+
+static void PrintMemoryTable(FILE* output, std::vector<MemoryCounts>& rows)
+{
+  std::stable_sort(rows.begin(), rows.end(), CompareMemoryCounts);
+  fprintf(output, "%12s %8s %8s %8s %8s %8s %8s %10s %12s %12s   %s\n",
+	  "loads", "L1", "otherL1", "inflight", "L2", "DRAM", "avg lat", "load cyc", "L1 conflict", "L2 stall", "location");
+  for (size_t i = 0; i < rows.size(); i++) {
+    const MemoryCounts& row = rows[i];
+    long long int loads = row.Loads();
+    if (loads == 0 && row.l1_conflicts == 0 && row.l2_stalls == 0)
+      continue;
+    double scale = loads > 0 ? 100. / loads : 0.;
+    fprintf(output, "%12lld %7.2f%% %7.2f%% %7.2f%% %7.2f%% %7.2f%% %8.1f %10lld %12lld %12lld   %s\n",
+	    loads, scale * row.sources[MEM_SOURCE_L1], scale * row.sources[MEM_SOURCE_NEARBY],
+	    scale * row.sources[MEM_SOURCE_BUS], scale * row.sources[MEM_SOURCE_L2],
+	    scale * row.sources[MEM_SOURCE_DRAM], loads > 0 ? (double)row.latency / loads : 0.,
+	    row.latency, row.l1_conflicts, row.l2_stalls, row.label.c_str());
+  }
+}
+
+void WriteMemoryProfile(const char* filename, const char* assem_file,
+			const std::vector<Instruction*>& instructions,
+			const std::vector<std::string>& source_names)
+{
+  FILE* output = OpenOutput(filename);
+  if (!output)
+    return;
+
+  std::vector<MemoryCounts> pcs;
+  std::vector<MemoryCounts> lines;
+  std::map<std::pair<std::string, int>, size_t> line_rows;
+  MemoryCounts total;
+  for (size_t pc = 0; pc < instructions.size(); pc++) {
+    const Instruction* ins = instructions[pc];
+    if (Loads(ins) == 0 && ins->l1_conflicts == 0 && ins->l2_stalls == 0)
+      continue;
+    std::string file;
+    int line;
+    SourceLine(ins, assem_file, source_names, file, line);
+    char location[64];
+    snprintf(location, sizeof(location), ":%d", line);
+
+    MemoryCounts row;
+    row.Add(ins);
+    char pc_label[64];
+    snprintf(pc_label, sizeof(pc_label), "PC %d %s ", (int)pc, Instruction::Opnames[ins->op].c_str());
+    row.label = pc_label + file + location;
+    pcs.push_back(row);
+    total.Add(ins);
+
+    std::pair<std::string, int> key(file, line);
+    std::map<std::pair<std::string, int>, size_t>::iterator it = line_rows.find(key);
+    if (it == line_rows.end()) {
+      line_rows[key] = lines.size();
+      lines.push_back(MemoryCounts());
+      lines.back().label = file + location;
+      lines.back().Add(ins);
+    }
+    else
+      lines[it->second].Add(ins);
+  }
+
+  fprintf(output, "Memory profile of %s\n", assem_file);
+  fprintf(output, "Loads by where their data came from, load cycles are issue to register write.\n");
+  fprintf(output, "Conflicts and stalls count accesses turned away and retried.\n\n");
+  total.label = "total";
+  std::vector<MemoryCounts> totals(1, total);
+  PrintMemoryTable(output, totals);
+  fprintf(output, "\nBy source line:\n");
+  PrintMemoryTable(output, lines);
+  fprintf(output, "\nBy PC:\n");
+  PrintMemoryTable(output, pcs);
+
+  fclose(output);
+  printf("Wrote memory profile to '%s'.\n", filename);
+}
+
+
+void WriteKernelTrace(const char* filename, std::vector<TraxCore*>& cores)
+{
+  FILE* output = OpenOutput(filename);
+  if (!output)
+    return;
+
+  fprintf(output, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  bool first = true;
+  long long int num_regions = 0;
+  long long int num_dropped = 0;
+  for (size_t c = 0; c < cores.size(); c++) {
+    IssueUnit* issuer = cores[c]->issuer;
+    int pid = (int)cores[c]->core_id;
+    num_dropped += issuer->kernel_regions_dropped;
+    std::vector<KernelRegion> regions = issuer->kernel_regions;
+    for (int k = 0; k < MAX_NUM_KERNELS; k++)
+      for (int p = 0; p < cores[c]->num_thread_procs; p++)
+	if (issuer->kernel_profiling[k][p]) {
+	  KernelRegion region;
+	  region.kernel = k;
+	  region.proc = p;
+	  region.start = issuer->kernel_start[k][p];
+	  region.end = cores[c]->cycle_num;
+	  regions.push_back(region);
+	}
+    if (regions.empty())
+      continue;
+
+    fprintf(output, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"TM %d\"}}",
+	    first ? "" : ",\n", pid, pid);
+    first = false;
+    std::vector<bool> named(cores[c]->num_thread_procs, false);
+    for (size_t i = 0; i < regions.size(); i++) {
+      const KernelRegion& region = regions[i];
+      if (!named[region.proc]) {
+	fprintf(output, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+		pid, region.proc, region.proc);
+	named[region.proc] = true;
+      }
+      fprintf(output, ",\n{\"name\":\"kernel %d\",\"cat\":\"kernel\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+	      region.kernel, pid, region.proc, region.start, region.end - region.start);
+      num_regions++;
+    }
+  }
+  fprintf(output, "\n]}\n");
+  fclose(output);
+  printf("Wrote %lld kernel regions to '%s'.\n", num_regions, filename);
+  if (num_dropped > 0)
+    printf("WARNING: %lld later kernel regions were left out, only the first %d of each TM are kept.\n",
+	   num_dropped, MAX_KERNEL_REGIONS);
+}
@@ -0,0 +1,61 @@
+#ifndef _SIMHWRT_PROFILE_EXPORT_H_
+#define _SIMHWRT_PROFILE_EXPORT_H_
+
+// Profile exporters for existing tools:
+//   --profile-callgrind <file>  per-PC costs in callgrind format (KCachegrind, callgrind_annotate)
+//   --profile-pprof <file>      the same as an uncompressed pprof protobuf (go tool pprof)
+//   --profile-memory <file>     text report of where each PC's and source line's loads were
+//                               served from and how long they took
+//   --kernel-trace <file>       PROF kernel regions of every thread as a Chrome trace-event
+//                               timeline (chrome://tracing, Perfetto), one process per TM,
+//                               up to MAX_KERNEL_REGIONS regions per TM
+//
+// Each PC gets three costs, in cycles summed over all threads: Issue (the instruction
+// issued), DataStall (an instruction waiting on it for its result) and ContentionStall
+// (it was ready but its functional unit or the icache was busy). Loads also count where
+// their data came from (Instruction.h MemorySource), their total latency, and how often
+// the L1 or L2 turned them away (L1Cache::Access).
+// Functions are the assembler's text labels, '$' labels (basic blocks) belong to the
+// function above them. Source file and line come from the debug info when the program
+// has it, otherwise the assembly file and line. None of these need -g, unlike --profile.
+//
+// Trace timestamps are cycles, so 1us in the viewer is one cycle.
+
+#include <string>
+#include <vector>
+
+struct symbol;
+class Instruction;
+class TraxCore;
+
+// Count per-PC issue, stall and load stats (in Instruction) even without --profile
+extern bool pc_profiling;
+// Record PROF kernel regions in each IssueUnit
+extern bool kernel_trace;
+
+struct ProfileFunction {
+  int start_pc;
+  std::string name;
+};
+
+// Builds the function list from the assembler's text labels, sorted by PC
+void ProfileFunctions(const std::vector<symbol*>& text_labels, std::vector<ProfileFunction>& functions);
+
+void WriteCallgrindProfile(const char* filename, const char* assem_file,
+			   const std::vector<Instruction*>& instructions,
+			   const std::vector<ProfileFunction>& functions,
+			   const std::vector<std::string>& source_names);
+
+void WritePprofProfile(const char* filename, const char* assem_file,
+		       const std::vector<Instruction*>& instructions,
+		       const std::vector<ProfileFunction>& functions,
+		       const std::vector<std::string>& source_names);
+
+void WriteMemoryProfile(const char* filename, const char* assem_file,
+			const std::vector<Instruction*>& instructions,
+			const std::vector<std::string>& source_names);
+
+// Regions still open when the simulation ended are closed at the TM's last cycle
+void WriteKernelTrace(const char* filename, std::vector<TraxCore*>& cores);
+
+#endif // _SIMHWRT_PROFILE_EXPORT_H_
@@ -137,6 +137,11 @@ void Profiler::PrintProfile(std::vector<Instruction*>& instructions, long long i
   // Write out a graphviz file representing the profile information
   dwarfReader->rootRuntime->WriteDot("runtime.dot", total_thread_cycles);
 
+  // For debugging. May be useful
+  // Writes a graphviz file representing the source tree (the parts the run read)
+  dwarfReader->WriteDot("sourcetree.dot");
+  dwarfReader->PrintMemoryUse();
+
 }
 
 
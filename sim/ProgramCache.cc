@@ -0,0 +1,153 @@
+#include "ProgramCache.h"
+#include "Assembler.h"
+#include <stdlib.h>
+#include <string.h>
+
+// FNV-1a
+static void HashBytes(uint64_t& hash, const unsigned char* data, size_t size)
+{
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+}
+
+static bool HashFile(const char* filename, uint64_t& hash)
+{
+  FILE* input = fopen(filename, "rb");
+  if (!input)
+    return false;
+  unsigned char buf[1 << 16];
+  size_t count;
+  while ((count = fread(buf, 1, sizeof(buf), input)) > 0)
+    HashBytes(hash, buf, count);
+  fclose(input);
+  return true;
+}
+
+ProgramCacheStream::ProgramCacheStream(const char* cache_dir, const char* assem_file, bool _writing)
+{
+  writing = _writing;
+  ok = true;
+  file = NULL;
+
+  hash = 14695981039346656037ULL;
+  int version = PROGRAM_CACHE_VERSION;
+  HashBytes(hash, reinterpret_cast<const unsigned char*>(&version), sizeof(version));
+  if (!HashFile(assem_file, hash)) {
+    ok = false;
+    return;
+  }
+
+  const char* name = strrchr(assem_file, '/');
+  name = name ? name + 1 : assem_file;
+  char hash_string[32];
+  sprintf(hash_string, "-%016llx.tpc", (unsigned long long)hash);
+  filename = std::string(cache_dir) + "/" + name + hash_string;
+  temp_filename = filename + ".tmp";
+
+  file = fopen(writing ? temp_filename.c_str() : filename.c_str(), writing ? "wb" : "rb");
+  if (!file) {
+    if (writing)
+      printf("WARNING: unable to write program cache %s\n", filename.c_str());
+    ok = false;
+    return;
+  }
+
+  char magic[8];
+  uint64_t file_hash = hash;
+  memcpy(magic, PROGRAM_CACHE_MAGIC, 8);
+  Bytes(magic, 8);
+  Value(version);
+  Value(file_hash);
+  if (memcmp(magic, PROGRAM_CACHE_MAGIC, 8) != 0 || version != PROGRAM_CACHE_VERSION || file_hash != hash)
+    ok = false;
+}
+
+ProgramCacheStream::~ProgramCacheStream()
+{
+  if (!file)
+    return;
+  fclose(file);
+  if (writing) {
+    if (ok)
+      ok = rename(temp_filename.c_str(), filename.c_str()) == 0;
+    if (!ok) {
+      printf("WARNING: unable to write program cache %s\n", filename.c_str());
+      remove(temp_filename.c_str());
+    }
+  }
+}
+
+void ProgramCacheStream::Bytes(void* data, size_t size)
+{
+  if (size == 0)
+    return;
+  if (writing) {
+    if (ok && fwrite(data, 1, size, file) != size)
+      ok = false;
+  }
+  else if (!ok || fread(data, 1, size, file) != size) {
+    ok = false;
+    memset(data, 0, size);
+  }
+}
+
+void ProgramCacheStream::String(std::string& value)
+{
+  uint32_t length = (uint32_t)value.size();
+  Value(length);
+  // a damaged length must not turn in to a huge allocation
+  if (!ok || length > (1u << 28)) {
+    ok = false;
+    return;
+  }
+  if (!writing)
+    value.resize(length);
+  if (length > 0)
+    Bytes(&value[0], length);
+}
+
+void ProgramCacheStream::Strings(std::vector<std::string>& values)
+{
+  uint32_t count = (uint32_t)values.size();
+  Value(count);
+  if (!ok || count > (1u << 24)) {
+    ok = false;
+    return;
+  }
+  if (!writing)
+    values.resize(count);
+  for (uint32_t i = 0; i < count && ok; i++)
+    String(values[i]);
+}
+
+void ProgramCacheStream::Symbols(std::vector<symbol*>& symbols)
+{
+  uint32_t count = (uint32_t)symbols.size();
+  Value(count);
+  if (!ok || count > (1u << 24)) {
+    ok = false;
+    return;
+  }
+  for (uint32_t i = 0; i < count && ok; i++) {
+    symbol* sym = writing ? symbols[i] : new symbol();
+    std::vector<std::string> names;
+    for (size_t j = 0; j < sym->names.size(); j++)
+      names.push_back(sym->names[j]);
+    Strings(names);
+    Value(sym->address);
+    Value(sym->size);
+    Value(sym->isText);
+    Value(sym->isJumpTable);
+    Value(sym->isAscii);
+    if (!writing) {
+      // The assembler's names are malloc'ed
+      for (size_t j = 0; j < names.size(); j++) {
+	sym->names.push_back((char*)malloc(names[j].size() + 1));
+	strcpy(sym->names.back(), names[j].c_str());
+      }
+      symbols.push_back(sym);
+    }
+  }
+}
@@ -0,0 +1,50 @@
+#ifndef _SIMHWRT_PROGRAM_CACHE_H_
+#define _SIMHWRT_PROGRAM_CACHE_H_
+
+// Assembled-program cache ("--program-cache <directory>"). After assembling a .s file the
+// Assembler saves everything it produced in <directory>/<name>-<hash>.tpc, where the hash
+// covers the assembly file's contents, so a later run of the unchanged file skips the
+// parse entirely. Debug info is kept as the raw .debug_info/.debug_abbrev bytes and
+// labels, and DwarfReader parses it again on load, which is quick next to assembling. The
+// source files named by .file directives are not covered by the hash, so their lines are
+// read again on load rather than cached.
+//
+// Like CheckpointStream, a ProgramCacheStream either writes or reads with the same calls,
+// so Assembler::CacheProgram describes the layout once. Unlike a checkpoint, a cache that
+// is missing, stale or damaged is not an error: reading just reports failure and the file
+// is assembled as usual.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define PROGRAM_CACHE_MAGIC "TRAXPGC"
+#define PROGRAM_CACHE_VERSION 2
+
+struct symbol;
+
+class ProgramCacheStream {
+public:
+  // Opens the cache file for 'assem_file' in 'cache_dir'
+  ProgramCacheStream(const char* cache_dir, const char* assem_file, bool _writing);
+  // A written cache only replaces the old file once it is complete
+  ~ProgramCacheStream();
+
+  void Bytes(void* data, size_t size);
+  template <class T> void Value(T& value) { Bytes(&value, sizeof(T)); }
+  void String(std::string& value);
+  void Strings(std::vector<std::string>& values);
+  // Symbols are written by value. On read the vector is filled with new ones
+  void Symbols(std::vector<symbol*>& symbols);
+
+  bool writing;
+  // False once anything has gone wrong, reads then return zeros
+  bool ok;
+  FILE* file;
+  std::string filename;
+  std::string temp_filename;
+  uint64_t hash;
+};
+
+#endif // _SIMHWRT_PROGRAM_CACHE_H_
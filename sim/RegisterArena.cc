@@ -0,0 +1,25 @@
+#include "RegisterArena.h"
+#include "ThreadState.h"
+#include "WriteRequest.h"
+
+RegisterArena::RegisterArena(int _num_threads, int _num_regs) :
+  num_threads(_num_threads), num_regs(_num_regs)
+{
+  register_ready = new long long int[num_threads * num_regs]();
+  writes_in_flight = new int[num_threads * num_regs]();
+  registers = new float[num_threads * num_regs * 4]();
+  write_requests = new WriteRequest[num_threads * WRITE_QUEUE_SIZE];
+}
+
+RegisterArena::~RegisterArena()
+{
+  delete[] register_ready;
+  delete[] writes_in_flight;
+  delete[] registers;
+  delete[] write_requests;
+}
+
+WriteRequest* RegisterArena::WriteRequests(int thread)
+{
+  return write_requests + thread * WRITE_QUEUE_SIZE;
+}
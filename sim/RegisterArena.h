@@ -0,0 +1,32 @@
+#ifndef _SIMHWRT_REGISTER_ARENA_H_
+#define _SIMHWRT_REGISTER_ARENA_H_
+
+// Register state for every thread of a TM, one allocation per field (structure of
+// arrays). Thread t's slice of a field follows thread t-1's, so when the IssueUnit walks
+// a TM's threads each cycle, their register_ready (and writes_in_flight, write queues and
+// register values) sit in one block instead of a small heap allocation per thread.
+// ThreadState and SimpleRegisterFile point in to their thread's slices and don't own them.
+// Threads are numbered within the TM: proc_id * threads_per_proc + thread.
+
+class WriteRequest;
+
+class RegisterArena {
+ public:
+  RegisterArena(int _num_threads, int _num_regs);
+  ~RegisterArena();
+
+  long long int* RegisterReady(int thread) { return register_ready + thread * num_regs; }
+  int* WritesInFlight(int thread) { return writes_in_flight + thread * num_regs; }
+  // 4 words per register for MSA, as SimpleRegisterFile lays them out
+  float* Registers(int thread) { return registers + thread * num_regs * 4; }
+  WriteRequest* WriteRequests(int thread);
+
+  int num_threads;
+  int num_regs;
+  long long int* register_ready;
+  int* writes_in_flight;
+  float* registers;
+  WriteRequest* write_requests;
+};
+
+#endif // _SIMHWRT_REGISTER_ARENA_H_
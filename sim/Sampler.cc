@@ -0,0 +1,148 @@
+#include "Sampler.h"
+#include "FunctionalExecution.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "IssueUnit.h"
+#include "L1Cache.h"
+#include "L2Cache.h"
+#include "memory_controller.h"
+#include "params.h"
+#include <math.h>
+#include <stdio.h>
+
+// two-sided 95% interval, windows are assumed numerous enough for the normal approximation
+#define SAMPLE_CONFIDENCE_Z 1.96
+
+long long int CountInstructions(std::vector<TraxCore*>& cores)
+{
+  long long int total = 0;
+  for (size_t i = 0; i < cores.size(); i++)
+    for (int op = 0; op < Instruction::NUM_OPS; op++)
+      total += cores[i]->issuer->instruction_bins[op];
+  return total;
+}
+
+long long int LatestCycle(std::vector<TraxCore*>& cores)
+{
+  long long int cycle = 0;
+  for (size_t i = 0; i < cores.size(); i++)
+    if (cores[i]->cycle_num > cycle)
+      cycle = cores[i]->cycle_num;
+  return cycle;
+}
+
+static SampleWindow Snapshot(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled)
+{
+  SampleWindow snap;
+  snap.cycles = LatestCycle(cores);
+  snap.instructions = CountInstructions(cores);
+  snap.L1_accesses = 0;
+  for (size_t i = 0; i < cores.size(); i++)
+    snap.L1_accesses += cores[i]->L1->accesses;
+  snap.memory_lines = 0;
+  if (usimm_enabled) {
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      snap.memory_lines += stats_reads_completed[c];
+  }
+  else {
+    for (int i = 0; i < num_L2s; i++)
+      snap.memory_lines += L2s[i]->misses;
+  }
+  return snap;
+}
+
+Sampler::Sampler(long long int _interval, long long int _window, long long int _warmup)
+{
+  interval = _interval;
+  window = _window;
+  warmup = _warmup;
+  functional_instructions = 0;
+}
+
+bool Sampler::FastForward(std::vector<TraxCore*>& cores, MainMemory* memory)
+{
+  functional_instructions += FunctionalExecution(cores, memory, interval, true);
+  for (size_t i = 0; i < cores.size(); i++)
+    if (!cores[i]->issuer->halted)
+      return true;
+  return false;
+}
+
+void Sampler::BeginWindow(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled)
+{
+  window_start = Snapshot(cores, L2s, num_L2s, usimm_enabled);
+}
+
+void Sampler::EndWindow(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled)
+{
+  SampleWindow end = Snapshot(cores, L2s, num_L2s, usimm_enabled);
+  end.cycles -= window_start.cycles;
+  end.instructions -= window_start.instructions;
+  end.L1_accesses -= window_start.L1_accesses;
+  end.memory_lines -= window_start.memory_lines;
+  // the program may have ended before the window was over
+  if (end.cycles > 0 && end.instructions > 0)
+    windows.push_back(end);
+}
+
+void Sampler::PrintEstimates(long long int total_instructions, int num_frames, int L2_line_words)
+{
+  printf("Sampled simulation estimates:\n");
+  printf("   Measured windows: \t\t %d (%lld cycles each, %lld warmup)\n",
+	 (int)windows.size(), window, warmup);
+  printf("   Functional instructions: \t %lld\n", functional_instructions);
+  printf("   Total instructions: \t\t %lld\n", total_instructions);
+  if (windows.size() == 0) {
+    printf("   No complete windows were measured, use a smaller --sample-interval\n\n");
+    return;
+  }
+
+  // IPC is the ratio of the windows' totals, so each window counts by its length. The
+  // interval uses the ratio estimator's variance, from each window's instructions against
+  // what the overall IPC predicts for its cycles.
+  double n = windows.size();
+  long long int instructions = 0, cycles = 0, L1_accesses = 0, memory_lines = 0;
+  for (size_t i = 0; i < windows.size(); i++) {
+    instructions += windows[i].instructions;
+    cycles += windows[i].cycles;
+    L1_accesses += windows[i].L1_accesses;
+    memory_lines += windows[i].memory_lines;
+  }
+  double ipc = static_cast<double>(instructions) / cycles;
+  double half_width = 0;
+  if (windows.size() > 1) {
+    double residuals = 0;
+    for (size_t i = 0; i < windows.size(); i++) {
+      double residual = windows[i].instructions - ipc * windows[i].cycles;
+      residuals += residual * residual;
+    }
+    double mean_cycles = cycles / n;
+    half_width = SAMPLE_CONFIDENCE_Z * sqrt(residuals / (n - 1) / n) / mean_cycles;
+  }
+
+  // Cycles are inversely proportional to IPC, so the interval maps over flipped
+  double est_cycles = total_instructions / ipc;
+  double low_cycles = total_instructions / (ipc + half_width);
+  double high_cycles = ipc > half_width ? total_instructions / (ipc - half_width) : HUGE_VAL;
+  float Hz = 1000000000;
+  int word_size = 4;
+
+  if (windows.size() > 1) {
+    printf("   IPC (all TMs): \t\t %f +/- %f (95%% confidence)\n", ipc, half_width);
+    printf("   Estimated clock cycles: \t %.0f [%.0f, %.0f]\n", est_cycles, low_cycles, high_cycles);
+    printf("   Estimated FPS assuming %dMHz clock: \t %.4lf [%.4lf, %.4lf]\n", (int)Hz / 1000000,
+	   Hz * num_frames / est_cycles, Hz * num_frames / high_cycles, Hz * num_frames / low_cycles);
+    printf("   Relative error bound: \t %.2f%%\n", 100. * half_width / ipc);
+  }
+  else {
+    // One window says nothing about how much the IPC varies
+    printf("   IPC (all TMs): \t\t %f (one window, no confidence interval)\n", ipc);
+    printf("   Estimated clock cycles: \t %.0f\n", est_cycles);
+    printf("   Estimated FPS assuming %dMHz clock: \t %.4lf\n", (int)Hz / 1000000,
+	   Hz * num_frames / est_cycles);
+  }
+  printf("Bandwidth numbers for %dMHz clock (GB/s, measured windows):\n", static_cast<int>(Hz/1000000));
+  printf("   L1 to register bandwidth: \t %f\n", static_cast<float>(L1_accesses) * word_size / cycles);
+  printf("   memory to L2 bandwidth: \t %f\n", static_cast<float>(memory_lines) * word_size * L2_line_words / cycles);
+  printf("\n");
+}
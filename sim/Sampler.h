@@ -0,0 +1,54 @@
+#ifndef _SIMHWRT_SAMPLER_H_
+#define _SIMHWRT_SAMPLER_H_
+
+// Statistical sampling ("--sample-interval"), in the style of SMARTS. The program
+// fast-forwards functionally between short cycle-accurate windows. Fast-forwarding warms
+// the L1 and L2 tags, then each window runs a few unmeasured warmup cycles to refill the
+// pipelines before it is measured. The window is followed by a drain, so no loads or
+// register writes are in flight when functional execution resumes. Whole-run cycles, FPS
+// and bandwidth are extrapolated from the windows' IPC (all their instructions over all
+// their cycles), with a confidence interval once there are two windows or more.
+
+#include <vector>
+
+class TraxCore;
+class MainMemory;
+class L2Cache;
+
+struct SampleWindow {
+  long long int cycles;
+  long long int instructions;
+  long long int L1_accesses;
+  long long int memory_lines; // lines read from DRAM (or L2 misses without usimm)
+};
+
+class Sampler {
+public:
+  Sampler(long long int interval, long long int window, long long int warmup);
+
+  // Runs the next functional interval. Returns false once every core has halted.
+  bool FastForward(std::vector<TraxCore*>& cores, MainMemory* memory);
+
+  // Bracket the measured part of a cycle-accurate window
+  void BeginWindow(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled);
+  void EndWindow(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled);
+
+  // total_instructions covers the whole run, functional and cycle-accurate
+  void PrintEstimates(long long int total_instructions, int num_frames, int L2_line_words);
+
+  long long int interval; // instructions executed functionally between windows
+  long long int window;   // measured cycles per window
+  long long int warmup;   // unmeasured cycles before each window
+  long long int functional_instructions;
+
+  std::vector<SampleWindow> windows;
+  SampleWindow window_start;
+};
+
+// Sum of all instructions issued by the cores so far
+long long int CountInstructions(std::vector<TraxCore*>& cores);
+
+// Cycle of the cores still running (serial execution stops clocking halted cores)
+long long int LatestCycle(std::vector<TraxCore*>& cores);
+
+#endif // _SIMHWRT_SAMPLER_H_
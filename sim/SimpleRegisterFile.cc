@@ -4,7 +4,7 @@
 #include "WriteRequest.h"
 #include <cassert>
 
-SimpleRegisterFile::SimpleRegisterFile(int num_regs, int _thread_id) :
+SimpleRegisterFile::SimpleRegisterFile(int num_regs, int _thread_id, float* storage) :
     FunctionalUnit(0),
     num_registers(num_regs)
 {
@@ -18,7 +18,7 @@ SimpleRegisterFile::SimpleRegisterFile(int num_regs, int _thread_id) :
   // 128-bit registers are mapped on to 32-bit register names, so
   // all control logic will assume only num_regs exist, and will operate on the 32-bit registers.
   // Extra words only used in MSA instructions
-  fdata = new float[num_regs * 4];
+  fdata = storage ? storage : new float[num_regs * 4];
 
   buffer = NULL;
   
@@ -509,6 +509,11 @@ bool SimpleRegisterFile::AcceptInstruction(Instruction& ins, IssueUnit* issuer,
   return true;
 }
 
+void SimpleRegisterFile::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void SimpleRegisterFile::ClockRise() {}
 
@@ -30,7 +30,8 @@ typedef RegisterTraceV1 RegisterTrace;
 class SimpleRegisterFile : public FunctionalUnit {
  public:
   long long int current_cycle;
-  SimpleRegisterFile(int num_regs, int _thread_id);
+  // Without storage (4 words per register) the register file allocates its own
+  SimpleRegisterFile(int num_regs, int _thread_id, float* storage = NULL);
   ~SimpleRegisterFile();
 
   int ReadInt(int which_reg, long long int which_cycle) const;
@@ -45,6 +46,7 @@ class SimpleRegisterFile : public FunctionalUnit {
 
   virtual bool SupportsOp(Instruction::Opcode op) const;
   virtual bool AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadState* thread);
+  virtual void ResetIssueLimit();
 
   // From HardwareModule
   virtual void ClockRise();
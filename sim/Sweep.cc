@@ -0,0 +1,142 @@
+#include "Sweep.h"
+#include "MainMemory.h"
+#include "TraxCore.h"
+#include "IssueUnit.h"
+#include "L1Cache.h"
+#include "L2Cache.h"
+#include "memory_controller.h"
+#include "params.h"
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void ReadSweepFile(const char* filename, std::vector<SweepPoint>& points)
+{
+  FILE* input = fopen(filename, "r");
+  if (!input) {
+    perror("Unable to open sweep file");
+    exit(1);
+  }
+
+  char line_buf[4096];
+  int line_num = 0;
+  while (fgets(line_buf, sizeof(line_buf), input)) {
+    line_num++;
+    std::vector<std::string> tokens;
+    for (char* token = strtok(line_buf, " \t\r\n"); token; token = strtok(NULL, " \t\r\n"))
+      tokens.push_back(token);
+    if (tokens.empty() || tokens[0][0] == '#')
+      continue;
+
+    SweepPoint point;
+    point.name = tokens[0];
+    point.num_cores = 0;
+    point.simulation_threads = 0;
+    for (size_t i = 1; i < tokens.size(); i += 2) {
+      if (i + 1 >= tokens.size()) {
+	printf("ERROR: %s line %d: %s needs a value\n", filename, line_num, tokens[i].c_str());
+	exit(1);
+      }
+      const std::string& option = tokens[i];
+      const std::string& value = tokens[i + 1];
+      if (option == "--num-TMs" || option == "--num-cores" || option == "--simulation-threads") {
+	// 0 stands for "not given", so a point has to ask for at least one
+	char* end;
+	long count = strtol(value.c_str(), &end, 10);
+	if (*end != '\0' || count < 1 || count > INT_MAX) {
+	  printf("ERROR: %s line %d: %s needs a positive number, got %s\n", filename, line_num,
+		 option.c_str(), value.c_str());
+	  exit(1);
+	}
+	if (option == "--simulation-threads")
+	  point.simulation_threads = count;
+	else
+	  point.num_cores = count;
+      }
+      else if (option == "--config-file")
+	point.config_file = value;
+      else if (option == "--dcacheparams")
+	point.dcache_params_file = value;
+      else if (option == "--usimm-config")
+	point.usimm_config_file = value;
+      else if (option == "--vi-file")
+	point.usimm_vi_file = value;
+      else {
+	printf("ERROR: %s line %d: unsupported sweep option %s\n", filename, line_num, option.c_str());
+	exit(1);
+      }
+    }
+    points.push_back(point);
+  }
+  fclose(input);
+
+  if (points.empty()) {
+    printf("ERROR: no sweep points in %s\n", filename);
+    exit(1);
+  }
+}
+
+void GatherSweepResult(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled,
+		       double host_seconds, SweepResult& result)
+{
+  memset(&result, 0, sizeof(result));
+  result.host_seconds = host_seconds;
+  for (size_t c = 0; c < cores.size(); c++) {
+    if (cores[c]->cycle_num > result.cycles)
+      result.cycles = cores[c]->cycle_num;
+    for (int op = 0; op < Instruction::NUM_OPS; op++)
+      result.instructions += cores[c]->issuer->instruction_bins[op];
+    result.L1_accesses += cores[c]->L1->accesses;
+    result.L1_hits += cores[c]->L1->hits;
+  }
+  for (int i = 0; i < num_L2s; i++) {
+    result.L2_accesses += L2s[i]->accesses;
+    result.L2_hits += L2s[i]->hits;
+  }
+  if (usimm_enabled) {
+    for (int c = 0; c < NUM_CHANNELS; c++)
+      result.dram_reads += stats_reads_completed[c];
+  }
+  else
+    result.dram_reads = result.L2_accesses - result.L2_hits;
+}
+
+static double Ratio(long long int a, long long int b)
+{
+  return b > 0 ? static_cast<double>(a) / b : 0.;
+}
+
+void WriteSweepResults(const char* filename, const std::vector<SweepPoint>& points,
+		       const std::vector<SweepResult>& results)
+{
+  FILE* output = fopen(filename, "w");
+  if (!output) {
+    perror("Failed to open sweep results file for writing.\n");
+    exit(1);
+  }
+  fprintf(output, "name,TMs,simulation_threads,config_file,dcacheparams,usimm_config,vi_file,"
+	  "cycles,instructions,IPC,L1_hit_rate,L2_hit_rate,dram_reads,host_seconds\n");
+
+  printf("Sweep results:\n");
+  printf("   %-20s %5s %8s %14s %8s %8s %8s %12s %10s\n",
+	 "name", "TMs", "threads", "cycles", "IPC", "L1 hit", "L2 hit", "DRAM reads", "host (s)");
+  for (size_t i = 0; i < points.size(); i++) {
+    const SweepPoint& point = points[i];
+    const SweepResult& result = results[i];
+    double IPC = Ratio(result.instructions, result.cycles);
+    double L1_hit_rate = Ratio(result.L1_hits, result.L1_accesses);
+    double L2_hit_rate = Ratio(result.L2_hits, result.L2_accesses);
+    printf("   %-20s %5d %8d %14lld %8.3f %8.4f %8.4f %12lld %10.2f\n",
+	   point.name.c_str(), point.num_cores, point.simulation_threads, result.cycles,
+	   IPC, L1_hit_rate, L2_hit_rate, result.dram_reads, result.host_seconds);
+    fprintf(output, "%s,%d,%d,%s,%s,%s,%s,%lld,%lld,%f,%f,%f,%lld,%f\n",
+	    point.name.c_str(), point.num_cores, point.simulation_threads,
+	    point.config_file.c_str(), point.dcache_params_file.c_str(),
+	    point.usimm_config_file.c_str(), point.usimm_vi_file.c_str(),
+	    result.cycles, result.instructions, IPC, L1_hit_rate, L2_hit_rate,
+	    result.dram_reads, result.host_seconds);
+  }
+  printf("Wrote sweep results to '%s'.\n\n", filename);
+  fclose(output);
+}
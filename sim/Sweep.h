@@ -0,0 +1,52 @@
+#ifndef _SIMHWRT_SWEEP_H_
+#define _SIMHWRT_SWEEP_H_
+
+// In-process parameter sweeps ("--sweep <file>"). The program is assembled and the scene
+// loaded once, then each point of the sweep gets its own L2s, main memory, TMs and DRAM
+// set up from that, and is run to completion in turn. A combined table of the results is
+// written at the end.
+//
+// Sweep file: one point per line, '#' starts a comment line. Each line is a name followed
+// by any of the options below, anything not given is taken from the command line:
+//   gddr5_16tm --num-TMs 16 --config-file big.config --usimm-config gddr5_8ch.cfg
+// Options: --num-TMs, --simulation-threads, --config-file, --dcacheparams, --usimm-config,
+//          --vi-file
+
+#include <string>
+#include <vector>
+
+class TraxCore;
+class L2Cache;
+
+struct SweepPoint {
+  std::string name;
+  int num_cores;              // TMs per L2, 0 for the command line's
+  int simulation_threads;     // 0 for the command line's
+  std::string config_file;    // empty for the command line's, same for the rest
+  std::string dcache_params_file;
+  std::string usimm_config_file;
+  std::string usimm_vi_file;
+};
+
+struct SweepResult {
+  long long int cycles;
+  long long int instructions;
+  long long int L1_accesses, L1_hits;
+  long long int L2_accesses, L2_hits;
+  long long int dram_reads;
+  double host_seconds;
+};
+
+// Reads the sweep file, exits on a syntax error
+void ReadSweepFile(const char* filename, std::vector<SweepPoint>& points);
+
+// Sums the counters of a point that has finished running
+void GatherSweepResult(std::vector<TraxCore*>& cores, L2Cache** L2s, int num_L2s, bool usimm_enabled,
+		       double host_seconds, SweepResult& result);
+
+// Prints the table and writes it as CSV. points (with the command line's settings filled
+// in) and results line up.
+void WriteSweepResults(const char* filename, const std::vector<SweepPoint>& points,
+		       const std::vector<SweepResult>& results);
+
+#endif // _SIMHWRT_SWEEP_H_
@@ -10,6 +10,9 @@ Synchronize::Synchronize(int _latency, int _width, int _simd_width, int _num_thr
   FunctionalUnit(_latency), width(_width), simd_width(_simd_width),
   num_threads(_num_threads) {
   issued_this_cycle = 0;
+  // barrier logic is not counted towards chip area or energy
+  area = 0;
+  energy = 0;
   
   locked = new int[num_threads];
   for (int i = 0; i < num_threads; ++i) {
@@ -73,6 +76,11 @@ bool Synchronize::AcceptInstruction(Instruction& ins, IssueUnit* issuer, ThreadS
   }
 }
 
+void Synchronize::ResetIssueLimit()
+{
+  issued_this_cycle = 0;
+}
+
 // From HardwareModule
 void Synchronize::ClockRise() {
   // We do nothing on rise (or read from register file on first cycle, but
@@ -1,6 +1,6 @@
 #include "ThreadProcessor.h"
 
-ThreadProcessor::ThreadProcessor(int _num_threads, int num_regs, int _proc_id, SchedulingScheme ss, std::vector<Instruction*>* _instructions, std::vector<HardwareModule*> &modules, std::vector<FunctionalUnit*> *_functional_units, size_t threadprocid, size_t coreid, size_t l2id)
+ThreadProcessor::ThreadProcessor(int _num_threads, int num_regs, int _proc_id, SchedulingScheme ss, std::vector<Instruction*>* _instructions, std::vector<HardwareModule*> &modules, std::vector<FunctionalUnit*> *_functional_units, size_t threadprocid, size_t coreid, size_t l2id, RegisterArena* arena)
 {
   num_threads = _num_threads;
   active_thread = 0;
@@ -13,14 +13,14 @@ ThreadProcessor::ThreadProcessor(int _num_threads, int num_regs, int _proc_id, S
   // set up multiple thread states for multi-threading (default is 1 thread per proc)
   for(int i=0; i<num_threads; i++){
     int thread_id = proc_id * num_threads + i;
-    SimpleRegisterFile *simple_regs = new SimpleRegisterFile(num_regs, thread_id);
+    SimpleRegisterFile *simple_regs = new SimpleRegisterFile(num_regs, thread_id, arena->Registers(thread_id));
     // load IDs in to reserved registers
     simple_regs->udata[1] = threadprocid * num_threads + i;
     simple_regs->udata[2] = coreid;
     simple_regs->udata[3] = l2id;
     
     //TODO: threadprocid should be varied for multi-threading
-    thread_states.push_back(new ThreadState(simple_regs, *_instructions, threadprocid, coreid));
+    thread_states.push_back(new ThreadState(simple_regs, *_instructions, threadprocid, coreid, arena, thread_id));
     modules.push_back(simple_regs);
   }
 }
@@ -2,6 +2,7 @@
 #define _SIMHWRT_THREAD_PROCESSOR_H_
 #include "ThreadState.h"
 #include "Instruction.h"
+#include "RegisterArena.h"
 #include <vector>
 
 class IssueUnit;
@@ -25,7 +26,7 @@ class ThreadProcessor{
   int proc_id;
   bool halted;
   int num_halted;
-  ThreadProcessor(int _num_threads, int num_regs, int _proc_id, SchedulingScheme ss, std::vector<Instruction*>* _instructions, std::vector<HardwareModule*> &modules, std::vector<FunctionalUnit*> *_functional_units, size_t threadprocid, size_t coreid, size_t l2id);
+  ThreadProcessor(int _num_threads, int num_regs, int _proc_id, SchedulingScheme ss, std::vector<Instruction*>* _instructions, std::vector<HardwareModule*> &modules, std::vector<FunctionalUnit*> *_functional_units, size_t threadprocid, size_t coreid, size_t l2id, RegisterArena* arena);
   ~ThreadProcessor();
   void Reset();
   bool ReadRegister(int which_reg, long long int which_cycle, reg_value &val, Instruction::Opcode &op);
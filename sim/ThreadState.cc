@@ -1,28 +1,33 @@
 #include "ThreadState.h"
+#include "RegisterArena.h"
 #include "SimpleRegisterFile.h"
 #include "Instruction.h"
 #include "WriteRequest.h"
 #include "L2Cache.h"
+#include "ProfileExport.h"
+#include "LatencyHistograms.h"
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 
-#define N 1000
+extern pthread_mutex_t profile_mutex;
 
+#define N WRITE_QUEUE_SIZE
 
-WriteQueue::WriteQueue() {
-  requests = new WriteRequest[N];
+
+WriteQueue::WriteQueue(WriteRequest* storage) {
+  requests = storage;
   head = 0;
   tail = 0;
 }
 
 WriteQueue::~WriteQueue() {
-  delete[] requests;
 }
 
 void WriteQueue::clear()
 {
-  delete[] requests;
-  requests = new WriteRequest[N];
+  for (int i = 0; i < N; i++)
+    requests[i] = WriteRequest();
   head = 0;
   tail = 0;
 }
@@ -76,7 +81,10 @@ bool WriteQueue::update(ThreadState* thread, int which_reg, long long int which_
 	  requests[(tail+i)%N].op = new_op;
 	  // If this function was called by UpdateWriteCycle, then we don't change the instruction
 	  if(new_instr != NULL)
-	    requests[(tail+i)%N].instr = new_instr;
+	    {
+	      requests[(tail+i)%N].instr = new_instr;
+	      requests[(tail+i)%N].source = MEM_SOURCE_NONE;
+	    }
 	  thread->register_ready[which_reg] = new_cycle;
 	  return true;
 	}
@@ -105,7 +113,10 @@ bool WriteQueue::updateMSA(ThreadState* thread, int which_reg, long long int whi
 	  requests[(tail+i)%N].op = new_op;
 	  // If this function was called by UpdateWriteCycle, then we don't change the instruction
 	  if(new_instr != NULL)
-	    requests[(tail+i)%N].instr = new_instr;
+	    {
+	      requests[(tail+i)%N].instr = new_instr;
+	      requests[(tail+i)%N].source = MEM_SOURCE_NONE;
+	    }
 	  thread->register_ready[which_reg] = new_cycle;
 	  return true;
 	}
@@ -142,6 +153,14 @@ Instruction::Opcode WriteQueue::GetOp(int which_reg) {
   return return_op;
 }
 
+WriteRequest* WriteQueue::Last(int which_reg) {
+  int num = size();
+  for(int i = 1; i <= num; ++i)
+    if (requests[(head-i+N)%N].which_reg == which_reg)
+      return &requests[(head-i+N)%N];
+  return NULL;
+}
+
 Instruction* WriteQueue::GetInstruction(int which_reg) {
   // do a linear search to find the op for the register
   int num = size();
@@ -200,8 +219,10 @@ void WriteQueue::print() {
 
 ThreadState::ThreadState(SimpleRegisterFile* regs,
                          std::vector<Instruction*>& _instructions,
-			 unsigned int _thread_id, unsigned int coreid) :
-  thread_id(_thread_id), core_id(coreid), registers(regs), instructions(_instructions) {
+			 unsigned int _thread_id, unsigned int coreid,
+			 RegisterArena* arena, int arena_thread) :
+  thread_id(_thread_id), core_id(coreid), registers(regs), instructions(_instructions),
+  write_requests(arena->WriteRequests(arena_thread)) {
   carry_register = 0;
   compare_register = 0;
   halted = false;
@@ -218,8 +239,8 @@ ThreadState::ThreadState(SimpleRegisterFile* regs,
   issued_this_cycle = NULL;
   runtime = NULL;
 
-  register_ready = new long long int[regs->num_registers];
-  writes_in_flight = new int[regs->num_registers];
+  register_ready = arena->RegisterReady(arena_thread);
+  writes_in_flight = arena->WritesInFlight(arena_thread);
   for (int i = 0; i < registers->num_registers; i++) {
     register_ready[i] = 0;
     writes_in_flight[i] = 0;
@@ -278,9 +299,10 @@ bool ThreadState::QueueWrite(int which_reg, reg_value val, long long int which_c
   new_write->idata = val.idata;
   new_write->op = op;
   new_write->instr = instr;
+  new_write->isMSA = isMSA;
+  new_write->source = MEM_SOURCE_NONE;
   if(isMSA)
     {
-      new_write->isMSA = true;
       new_write->idataMSA[0] = val.idataMSA[0];
       new_write->idataMSA[1] = val.idataMSA[1];
       new_write->idataMSA[2] = val.idataMSA[2];
@@ -293,6 +315,16 @@ bool ThreadState::QueueWrite(int which_reg, reg_value val, long long int which_c
 }
 
 
+void ThreadState::SetWriteSource(int which_reg, char source, long long int issue_cycle)
+{
+  WriteRequest* request = write_requests.Last(which_reg);
+  if(request)
+    {
+      request->source = source;
+      request->issue_cycle = issue_cycle;
+    }
+}
+
 void ThreadState::UpdateWriteCycle(int which_reg, long long int which_cycle, unsigned int val, long long int new_cycle, Instruction::Opcode op)
 {
   write_requests.update(this, which_reg, which_cycle, val, new_cycle, val, op, NULL);
@@ -350,6 +382,20 @@ void ThreadState::ApplyWrites(long long int cur_cycle) {
 	registers->WriteIntMSA(request->which_reg + (registers->num_registers * 2), request->idataMSA[1], request->ready_cycle);
 	registers->WriteIntMSA(request->which_reg + (registers->num_registers * 3), request->idataMSA[2], request->ready_cycle);
       }
+    if(request->source != MEM_SOURCE_NONE)
+      {
+	long long int latency = request->ready_cycle - request->issue_cycle;
+	if(latency_histograms)
+	  RecordLoadLatency(core_id, request->source, latency);
+	if(pc_profiling && request->instr)
+	  {
+	    // All threads point to the same list of Instructions
+	    pthread_mutex_lock(&profile_mutex);
+	    request->instr->mem_sources[(int)request->source]++;
+	    request->instr->mem_latency += latency;
+	    pthread_mutex_unlock(&profile_mutex);
+	  }
+      }
     writes_in_flight[request->which_reg]--;
     write_requests.pop();
     request = write_requests.front();
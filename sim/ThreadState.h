@@ -10,12 +10,17 @@
 
 
 class Instruction;
+class RegisterArena;
 class SimpleRegisterFile;
 class WriteRequest;
 
+// number of entries in each thread's write queue ring buffer
+#define WRITE_QUEUE_SIZE 1000
+
 class WriteQueue {
  public:
-  WriteQueue();
+  // The ring buffer is WRITE_QUEUE_SIZE entries of storage, which stays the caller's
+  WriteQueue(WriteRequest* storage);
   ~WriteQueue();
   void clear();
   WriteRequest* push(long long int cycle);
@@ -28,6 +33,7 @@ class WriteQueue {
   bool CycleUsed(long long int cycle);
   Instruction::Opcode GetOp(int which_reg);
   Instruction* GetInstruction(int which_reg);
+  WriteRequest* Last(int which_reg);
   bool ReadyBy(int which_reg, long long int which_cycle, long long int &ready_cycle, reg_value &val, Instruction::Opcode &op);
   void print();
 
@@ -51,9 +57,11 @@ public:
 
   // MIPS Stuff
   int compare_register;
+  // The thread's register_ready, writes_in_flight and write queue are its slices of arena
   ThreadState(SimpleRegisterFile* regs,
               std::vector<Instruction*>& instructions,
-	      unsigned int thread_id, unsigned int core_id);
+	      unsigned int thread_id, unsigned int core_id,
+	      RegisterArena* arena, int arena_thread);
   ~ThreadState();
   void Reset();
   // Deprecating the following
@@ -75,6 +83,8 @@ public:
   Instruction* GetFailInstruction(int which_reg);
 
   void UpdateWriteCycle(int which_reg, long long int which_cycle, unsigned int val, long long int new_cycle, Instruction::Opcode op);
+  // Tags the write just queued to which_reg as a load served from source (MemorySource)
+  void SetWriteSource(int which_reg, char source, long long int issue_cycle);
 
   void Sleep(int num_cycles);
   
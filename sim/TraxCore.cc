@@ -23,6 +23,7 @@ TraxCore::TraxCore(int _num_thread_procs, int _threads_per_proc, int _num_regs,
   schedule = ss;
   core_id = coreid;
   l2_id = l2id;
+  register_arena = NULL;
 }
 
 TraxCore::~TraxCore(){
@@ -31,6 +32,7 @@ TraxCore::~TraxCore(){
   for(i=0; i<thread_procs.size(); i++){
     delete thread_procs[i];
   }
+  delete register_arena;
 }
 
 void TraxCore::initialize(const char* icache_params_file, int issue_verbosity, 
@@ -38,8 +40,9 @@ void TraxCore::initialize(const char* icache_params_file, int issue_verbosity,
 			  char* jump_table, int jtable_size, 
 			  std::vector<std::string> ascii_literals) {
   // set up thread states
+  register_arena = new RegisterArena(num_thread_procs * threads_per_proc, num_regs);
   for (int i = 0; i < num_thread_procs; i++) {
-    ThreadProcessor *tp = new ThreadProcessor(threads_per_proc, num_regs, i, schedule, instructions, modules, &functional_units, (size_t)i, core_id, l2_id);
+    ThreadProcessor *tp = new ThreadProcessor(threads_per_proc, num_regs, i, schedule, instructions, modules, &functional_units, (size_t)i, core_id, l2_id, register_arena);
     if(i==enable_proc_trace){
       tp->EnableRegisterDump();
     }
@@ -87,6 +90,15 @@ void TraxCore::Reset()
   L1->Reset();
 }
 
+// Restarts the program on every thread (next animation frame)
+// Cycle counts, statistics, and cache contents are kept so the frames form one continuous run
+void TraxCore::Restart()
+{
+  for(int i=0; i < num_thread_procs; i++)
+    thread_procs[i]->Reset();
+  issuer->Restart();
+}
+
 
 void TraxCore::EnableRegisterDump(int proc_num){
   enable_proc_trace = proc_num;
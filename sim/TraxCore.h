@@ -36,6 +36,7 @@ public:
 		  std::vector<std::string> ascii_literals);
   void EnableRegisterDump(int proc_num);
   void Reset();
+  void Restart();
   void SetSymbols(std::vector<symbol*> *regs);
   void AddStats(TraxCore* otherCore);
 
@@ -66,6 +67,8 @@ public:
   // instructions just pointed to
   std::vector<Instruction*>* instructions;
   std::vector<ThreadProcessor*> thread_procs;
+  // Register state of all the thread procs' threads
+  RegisterArena* register_arena;
   IssueUnit* issuer;
 
   // modules from loadConfig
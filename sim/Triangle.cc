@@ -47,7 +47,8 @@ Triangle::Triangle(const Vector3& p0, const Vector3& p1, const Vector3& p2,
 }
 
 Triangle::Triangle(const Triangle& t) :
-  p0(t.p0), p1(t.p1), p2(t.p2), object_id(t.object_id), shader_id(t.shader_id)
+  p0(t.p0), p1(t.p1), p2(t.p2), t0(t.t0), t1(t.t1), t2(t.t2), n0(t.n0), n1(t.n1), n2(t.n2),
+  object_id(t.object_id), shader_id(t.shader_id)
 {
   
 }
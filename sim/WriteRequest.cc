@@ -7,6 +7,8 @@ WriteRequest::WriteRequest() {
   instr = NULL;
   which_reg = -1;
   isMSA = false;
+  source = MEM_SOURCE_NONE;
+  issue_cycle = 0;
   // set good debugging value...
   fdata = FLT_MAX;
 }
@@ -17,6 +19,8 @@ WriteRequest::WriteRequest(long long int which_cycle) :
   fdata = FLT_MAX;
   instr = NULL;
   isMSA = false;
+  source = MEM_SOURCE_NONE;
+  issue_cycle = 0;
 }
 
 bool WriteRequest::IsReady(long long int current_cycle) const {
@@ -18,6 +18,10 @@ public:
   Instruction* instr;
   int which_reg;
   bool isMSA;
+  // For loads when profiling per PC: where the data came from (MemorySource) and when the
+  // load issued
+  char source;
+  long long int issue_cycle;
   
   union {
     int idata;
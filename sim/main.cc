@@ -2,6 +2,7 @@
 #include "BranchUnit.h"
 #include "BVH.h"
 #include "Camera.h"
+#include "Checkpoint.h"
 #include "ConversionUnit.h"
 #include "CustomLoadMemory.h"
 #include "DebugUnit.h"
@@ -11,25 +12,37 @@
 #include "FPInvSqrt.h"
 #include "FPMinMax.h"
 #include "FPMul.h"
+#include "FunctionalExecution.h"
 #include "FunctionalUnit.h"
 #include "GlobalRegisterFile.h"
+#include "HostProfiler.h"
 #include "Instruction.h"
 #include "IntAddSub.h"
 #include "IntMul.h"
+#include "IncrementalOutput.h"
+#include "IntervalStats.h"
+#include "IssueTrace.h"
 #include "IssueUnit.h"
 #include "IWLoader.h"
 #include "L1Cache.h"
 #include "L2Cache.h"
+#include "LatencyHistograms.h"
 #include "LoadMemory.h"
 #include "LocalStore.h"
 #include "MainMemory.h"
+#include "MemoryBench.h"
 #include "OBJLoader.h"
+#include "ProfileExport.h"
 #include "Profiler.h"
 #include "Debugger.h"
+#include "DeterministicExecution.h"
 #include "DwarfReader.h"
 #include "ReadConfig.h"
 #include "ReadViewfile.h"
 #include "ReadLightfile.h"
+#include "MemoryTrace.h"
+#include "Sampler.h"
+#include "Sweep.h"
 #include "SimpleRegisterFile.h"
 #include "Synchronize.h"
 #include "ThreadState.h"
@@ -37,7 +50,10 @@
 #include "TraxCore.h"
 #include "Triangle.h"
 #include "Vector3.h"
+#include "WriteRequest.h"
 #include "Assembler.h"
+#include "AsmLexer.h"
+#include "Animation.h"
 #include "usimm.h"
 #include "memory_controller.h"
 #include "params.h"
@@ -89,6 +105,8 @@ bool wait_usimm;
 int BRANCH_DELAY = 0;
 L2Cache** L2s;
 unsigned int num_L2s;
+IntervalStats* interval_stats;
+HostProfiler* host_profiler;
 
 // global verbosity flag
 int trax_verbosity;
@@ -170,6 +188,8 @@ struct CoreThreadArgs {
   int end_core;
   int thread_num;
   long long int stop_cycle;
+  long long int pause_cycle; // return early (without halting) on reaching this cycle, -1 for never
+  bool quiet; // don't announce the run (sampled windows start many short runs)
   std::vector<TraxCore*>* cores;
 };
 
@@ -181,11 +201,24 @@ void SyncThread( CoreThreadArgs* core_args ) {
     pthread_cond_wait(&sync_cond, &sync_mutex);
   }
   else {
+    // Every core has finished the cycle (and counted it) and the other threads are waiting,
+    // so counters are stable
+    long long int cycle = core_args->cores->front()->cycle_num;
+    if(interval_stats)
+      interval_stats->Tick(cycle);
+    if(host_profiler) {
+      if((cycle & 1023) == 0)
+        host_profiler->Progress(cycle, *core_args->cores);
+      host_profiler->Lap(core_args->thread_num, HOST_STATS);
+    }
+
     // Last thread sync caches
     for(size_t i = 0; i < num_L2s; i++) {
       L2s[i]->ClockRise();
       L2s[i]->ClockFall();
     }
+    if(host_profiler)
+      host_profiler->Lap(core_args->thread_num, HOST_L2_CLOCK);
 
     // Last thread updates the DRAM
     // Multiple DRAM cycles per trax cycle
@@ -193,26 +226,38 @@ void SyncThread( CoreThreadArgs* core_args ) {
       for(int i=0; i < DRAM_CLOCK_MULTIPLIER; i++)
         usimmClock();
     }
+    if(host_profiler)
+      host_profiler->Lap(core_args->thread_num, HOST_DRAM);
+    if(deterministic_execution)
+      DeterministicNextCycle(*core_args->cores);
 
     // Last thread signal the others to wake up
     current_simulation_threads = global_total_simulation_threads;
     pthread_cond_broadcast(&sync_cond);
   }
   pthread_mutex_unlock(&sync_mutex);
+  if(host_profiler)
+    host_profiler->Lap(core_args->thread_num, HOST_BARRIER);
 }
 
 void *CoreThread( void* args ) {
   CoreThreadArgs* core_args = static_cast<CoreThreadArgs*>(args);
   long long int stop_cycle = core_args->stop_cycle;
-  printf("Thread %d running cores\t%d to\t%d ...\n", (int) core_args->thread_num, (int) core_args->start_core, (int) core_args->end_core-1);
+  if(!core_args->quiet)
+    printf("Thread %d running cores\t%d to\t%d ...\n", (int) core_args->thread_num, (int) core_args->start_core, (int) core_args->end_core-1);
+  if(host_profiler) {
+    host_profiler->times[core_args->thread_num].num_cores = core_args->end_core - core_args->start_core;
+    host_profiler->Start(core_args->thread_num);
+  }
   // main loop for this core
   while (true) {
     // Choose the first core to issue from
 
+    // deterministic runs always go in TM order
     int start_core = 0;
     long long int max_stall_cycles = -1;
     std::vector<TraxCore*>::iterator tpIter = core_args->cores->begin() + core_args->start_core;
-    for(int i = core_args->start_core; i < core_args->end_core; ++i, ++tpIter) {
+    for(int i = core_args->start_core; i < core_args->end_core && !deterministic_execution; ++i, ++tpIter) {
 //      long long int stall_cycles = (*core_args->cores)[i]->CountStalls();
       long long int stall_cycles = (*tpIter)->CountStalls();
       if(stall_cycles > max_stall_cycles) {
@@ -241,24 +286,38 @@ void *CoreThread( void* args ) {
 //      SystemClockRise((*core_args->cores)[core_id]->modules);
 //      SystemClockFall((*core_args->cores)[core_id]->modules);
 //    }
+    // Finish the cycle before the barrier, so the last thread in sees every TM's counters
+    // for it (as the serial loop does)
+    tpIter = core_args->cores->begin() + core_args->start_core;
+    for(int i = core_args->start_core; i < core_args->end_core; ++i, ++tpIter) {
+      TraxCore *coreRef = *tpIter;
+      TrackUtilization(coreRef->modules, coreRef->utilizations);
+      coreRef->cycle_num++;
+    }
+    if(deterministic_execution)
+      DeterministicThreadDone(core_args->thread_num);
+    if(host_profiler)
+      host_profiler->Lap(core_args->thread_num, HOST_TM_CLOCK);
 
     SyncThread(core_args);
 
     bool all_done = true;
     tpIter = core_args->cores->begin() + core_args->start_core;
     for(int i = core_args->start_core; i < core_args->end_core; ++i, ++tpIter) {
-      TraxCore *coreRef = *tpIter;
-      TrackUtilization(coreRef->modules, coreRef->utilizations);
-      coreRef->cycle_num++;
-      if(!coreRef->issuer->halted) {
+      if(!(*tpIter)->issuer->halted) {
         all_done = false;
       }
     }
+    if(deterministic_execution)
+      all_done = DeterministicAllHalted();
     
     if(wait_usimm && usimmIsBusy())
       all_done = false;
+    if(host_profiler)
+      host_profiler->Lap(core_args->thread_num, HOST_STATS);
     
-    if(core_args->cores->front()->cycle_num == stop_cycle || all_done) {
+    if(core_args->cores->front()->cycle_num == stop_cycle ||
+       core_args->cores->front()->cycle_num == core_args->pause_cycle || all_done) {
       break;
     }
 //    bool all_done = true;
@@ -274,6 +333,8 @@ void *CoreThread( void* args ) {
 //    }
   }
 
+  if(deterministic_execution)
+    DeterministicThreadExit(core_args->thread_num);
   pthread_mutex_lock(&sync_mutex);
   global_total_simulation_threads--;
   current_simulation_threads--;
@@ -288,10 +349,16 @@ void *CoreThread( void* args ) {
 
 
 void SerialExecution(CoreThreadArgs* core_args, int num_cores) {
-  printf("Cores 0 through %d running (serial execution mode)\n", num_cores - 1);
+  if(!core_args[0].quiet)
+    printf("Cores 0 through %d running (serial execution mode)\n", num_cores - 1);
+  if(host_profiler) {
+    host_profiler->times[0].num_cores = num_cores;
+    host_profiler->Start(0);
+  }
 
   while (true) {
     bool all_halted = true;
+    long long int last_cycle = -1;
     //TODO: put the core pointers into a vector (or some kind of collection),
     // and remove them when they halt, to cut down this loop... (or just swap halted ones to the end of the array?
     std::vector<TraxCore*>* cores = core_args[0].cores;
@@ -304,33 +371,400 @@ void SerialExecution(CoreThreadArgs* core_args, int num_cores) {
       all_halted = false;
       SystemClockRise(core->modules);
       SystemClockFall(core->modules);
+      if(host_profiler)
+        host_profiler->Lap(0, HOST_TM_CLOCK);
       TrackUtilization(core->modules, core->utilizations);
       core->cycle_num++;
+      last_cycle = core->cycle_num;
       if(core->cycle_num == stop_cycle)
         core->issuer->halted = true;
     }
-    if(all_halted)
+    if(interval_stats && last_cycle >= 0)
+      interval_stats->Tick(last_cycle);
+    if(host_profiler) {
+      if((last_cycle & 1023) == 0)
+        host_profiler->Progress(last_cycle, *cores);
+      host_profiler->Lap(0, HOST_STATS);
+    }
+    if(all_halted || last_cycle == core_args[0].pause_cycle)
+      break;
+  }
+}
+
+
+// Splits the TMs between the simulation threads
+void PartitionCores(CoreThreadArgs* args, int num_threads, std::vector<TraxCore*>* cores,
+                    long long int stop_cycle, bool quiet) {
+  int total_cores = (int)cores->size();
+  int cores_per_thread = total_cores / num_threads + 1;
+  int remainder_threads = total_cores % num_threads;
+  int start_core = 0;
+  for(int i = 0; i < num_threads; ++i) {
+    if(remainder_threads == i) {
+      cores_per_thread--;
+    }
+    args[i].start_core = start_core;
+    args[i].end_core   = start_core + cores_per_thread;
+    start_core        += cores_per_thread;
+    args[i].thread_num = i;
+    args[i].stop_cycle = stop_cycle;
+    args[i].pause_cycle = -1;
+    args[i].quiet      = quiet;
+    args[i].cores      = cores;
+  }
+  // Have the last thread do the remainder
+  args[num_threads - 1].end_core = total_cores;
+}
+
+
+// Runs the cycle-accurate model until every core halts, or the stop or pause cycle in args
+void RunCores(CoreThreadArgs* args, int num_threads, bool serial_execution,
+              pthread_attr_t* attr, pthread_t* threadids, bool deterministic) {
+  if(serial_execution) {
+    SerialExecution(args, (int)args[0].cores->size());
+    return;
+  }
+
+  // Only gate while the threads run, other paths clock the cores from one thread
+  if(deterministic) {
+    std::vector<int> thread_of_core(args[0].cores->size());
+    for(int i = 0; i < num_threads; ++i)
+      for(int core = args[i].start_core; core < args[i].end_core; ++core)
+        thread_of_core[core] = i;
+    DeterministicSetup(num_threads, thread_of_core);
+    deterministic_execution = true;
+  }
+
+  global_total_simulation_threads = num_threads;
+  current_simulation_threads = num_threads;
+  for(int i = 0; i < num_threads; ++i) {
+    if(!args[i].quiet)
+      printf("Creating thread %d...\n", (int)i);
+    pthread_create( &threadids[i], attr, CoreThread, (void *)&args[i] );
+  }
+
+  // Wait for machine to halt
+  for(int i = 0; i < num_threads; ++i) {
+    pthread_join( threadids[i], NULL );
+  }
+  deterministic_execution = false;
+}
+
+
+// Clocks the machine without issuing anything new until no register writes or DRAM requests
+// are left in flight. Used at the end of a sampled window before going back to functional mode.
+void DrainCores(std::vector<TraxCore*>& cores) {
+  std::vector<bool> halted(cores.size());
+  for(size_t i = 0; i < cores.size(); i++) {
+    halted[i] = cores[i]->issuer->halted;
+    cores[i]->issuer->halted = true;
+  }
+
+  for(int cycle = 0; ; cycle++) {
+    bool busy = !disable_usimm && usimmIsBusy();
+    // Once usimm is idle nothing will update a load still waiting at UNKNOWN_LATENCY. That
+    // happens when the word was stored to before its line came back, UpdateBus no longer
+    // finds the write by its value. It is written below with the value it was queued with.
+    for(size_t i = 0; i < cores.size() && !busy; i++)
+      for(size_t j = 0; j < cores[i]->thread_procs.size() && !busy; j++)
+        for(int k = 0; k < cores[i]->thread_procs[j]->num_threads; k++) {
+          ThreadState* thread = cores[i]->thread_procs[j]->thread_states[k];
+          if(!thread->write_requests.empty() && thread->write_requests.front()->ready_cycle != UNKNOWN_LATENCY)
+            busy = true;
+        }
+    if(!busy)
       break;
+    if(cycle == 10000000) {
+      printf("Error: sampled window did not drain after %d cycles\n", cycle);
+      exit(1);
+    }
+
+    for(size_t i = 0; i < cores.size(); i++) {
+      SystemClockRise(cores[i]->modules);
+      SystemClockFall(cores[i]->modules);
+      cores[i]->cycle_num++;
+    }
+    for(size_t i = 0; i < num_L2s; i++) {
+      L2s[i]->ClockRise();
+      L2s[i]->ClockFall();
+    }
+    if(!disable_usimm) {
+      for(int i=0; i < DRAM_CLOCK_MULTIPLIER; i++)
+        usimmClock();
+    }
   }
+
+  // Their real latency isn't known, so they aren't counted as loads
+  for(size_t i = 0; i < cores.size(); i++)
+    for(size_t j = 0; j < cores[i]->thread_procs.size(); j++)
+      for(int k = 0; k < cores[i]->thread_procs[j]->num_threads; k++) {
+        ThreadState* thread = cores[i]->thread_procs[j]->thread_states[k];
+        WriteQueue& queue = thread->write_requests;
+        for(int n = 0; n < queue.size(); n++) {
+          WriteRequest& request = queue.requests[(queue.tail + n) % WRITE_QUEUE_SIZE];
+          if(request.ready_cycle == UNKNOWN_LATENCY)
+            request.source = MEM_SOURCE_NONE;
+        }
+        thread->ApplyWrites(UNKNOWN_LATENCY);
+      }
+
+  for(size_t i = 0; i < cores.size(); i++)
+    cores[i]->issuer->halted = halted[i];
 }
 
 
+// Writes the framebuffer out as an image, frame >= 0 is appended to the file name
+void WriteFrameImage(FourByte* data, int start_framebuffer, int image_width, int image_height,
+                     const char* output_prefix, bool use_png_ext_for_output, int frame) {
+  const int imgNameLen = strlen(output_prefix);
+  bool outputPrefixHasExtension = false;
+  for(int i=imgNameLen-1; i>=0; --i) {
+    if(output_prefix[i]=='\\' || output_prefix[i]=='/')
+      break;
+    if(output_prefix[i]=='.') {
+      outputPrefixHasExtension = true;
+      break;
+    }
+  }
+
+  // Get output filename with appropriate extension
+  char outputName[512];
+  const char *outputExt = (use_png_ext_for_output ? "png" : "ppm");
+  const bool outputPrefixHasExt = (imgNameLen > 3 &&
+                                   output_prefix[imgNameLen-3] == outputExt[0] &&
+                                   output_prefix[imgNameLen-2] == outputExt[1] &&
+                                   output_prefix[imgNameLen-1] == outputExt[2]);
+
+  // if not extension - just add it at the end
+  // animation frames get the frame number appended to the prefix
+  if(frame >= 0) {
+    int prefixLen = outputPrefixHasExt ? imgNameLen - 4 : imgNameLen;
+    sprintf(outputName, "%.*s_%04d.%s", prefixLen, output_prefix, frame, outputExt);
+  }
+  else if(outputPrefixHasExt) {
+    sprintf(outputName, "%s", output_prefix);
+  }
+  else {
+    sprintf(outputName, "%s.%s", output_prefix, outputExt);
+  }
+
+  // Write out using PNG extension?
+  if(use_png_ext_for_output) {
+
+    // save using lodePNG
+    unsigned char *imgRGBA = new unsigned char[4*image_width*image_height];
+    unsigned char *curImgPixel = imgRGBA;
+    for(int j = (int)(image_height - 1); j >= 0; j--) {
+      for(int i = 0; i < image_width; i++, curImgPixel+=4) {
+        const int index = start_framebuffer + 3 * (j * image_width + i);
+
+        float rgb[3];
+        rgb[0] = data[index + 0].fvalue;
+        rgb[1] = data[index + 1].fvalue;
+        rgb[2] = data[index + 2].fvalue;
+
+        curImgPixel[0] = (char)(int)(rgb[0] * 255);
+        curImgPixel[1] = (char)(int)(rgb[1] * 255);
+        curImgPixel[2] = (char)(int)(rgb[2] * 255);
+        curImgPixel[3] = 255;
+      }
+    }
+
+    unsigned char* png;
+    size_t pngsize;
+
+    unsigned error = lodepng_encode32(&png, &pngsize, imgRGBA, image_width, image_height);
+    if(!error)
+      lodepng_save_file(png, pngsize, outputName);
+    else
+      printf("Error %u: %s\n", error, lodepng_error_text(error));
+
+    free(png);
+    delete[] imgRGBA;
+  }
+
+  // Write out using PPM extension
+  else {
+
+    FILE* output = fopen(outputName, "wb");
+    if(!output)
+      printf("Error: Failed to open image output file: %s\n", outputName);
+
+#if OBJECTID_MAP
+      srand( (unsigned)time( NULL ) );
+      const int num_ids = 100000;
+      float id_colors[num_ids][3];
+      for (int i = 0; i < num_ids; i++) {
+        id_colors[i][0] = drand48();
+        id_colors[i][1] = drand48();
+        id_colors[i][2] = drand48();
+    }
+#endif
+
+      fprintf(output, "P6\n%d %d\n%d\n", image_width, image_height, 255);
+      for(int j = image_height - 1; j >= 0; j--) {
+        for(int i = 0; i < image_width; i++) {
+          const int index = start_framebuffer + 3 * (j * image_width + i);
+
+          float rgb[3];
+#if OBJECTID_MAP
+          int object_id = data[index].ivalue;
+
+          switch (object_id) {
+            case -1:
+              rgb[0] = .2;
+              rgb[1] = .1;
+              rgb[2] = .5;
+              break;
+            case 0:
+              rgb[0] = 1.;
+              rgb[1] = .4;
+              rgb[2] = 1.;
+              break;
+            case 1:
+              rgb[0] = .2;
+              rgb[1] = .3;
+              rgb[2] = 1.;
+              break;
+            case 2:
+              rgb[0] = 1.;
+              rgb[1] = .3;
+              rgb[2] = .2;
+              break;
+            default:
+              rgb[0] = id_colors[object_id % num_ids][0];
+              rgb[1] = id_colors[object_id % num_ids][1];
+              rgb[2] = id_colors[object_id % num_ids][2];
+              break;
+          };
+#else
+          // for gradient/colors we have the result
+          rgb[0] = data[index + 0].fvalue;
+          rgb[1] = data[index + 1].fvalue;
+          rgb[2] = data[index + 2].fvalue;
+#endif
+          fprintf(output, "%c%c%c",
+                  (char)(int)(rgb[0] * 255),
+                  (char)(int)(rgb[1] * 255),
+                  (char)(int)(rgb[2] * 255));
+        }
+      } // end for j
+      fclose(output);
+    }
+}
+
+// Builds num_cores TMs for each L2 from the config, all sharing the global register file
+void BuildCores(ReadConfig& config_reader, L2Cache** L2s, size_t num_L2s, size_t num_cores,
+                int num_thread_procs, int threads_per_proc, int num_regs, int simd_width,
+                ThreadProcessor::SchedulingScheme scheduling_scheme, int proc_register_trace,
+                bool run_profile, std::vector<Instruction*>* instructions, std::vector<symbol*>* regs,
+                GlobalRegisterFile* globals, Profiler* profiler, Debugger* debugger,
+                std::vector<TraxCore*>& cores, double& core_size) {
+  // loop through the L2s
+  for(size_t l2_id = 0; l2_id < num_L2s; ++l2_id) {
+    L2Cache* L2 = L2s[l2_id];
+    // load the cores
+    for(size_t i = 0; i < num_cores; ++i) {
+      size_t core_id = i + num_cores * l2_id;
+      if(trax_verbosity)
+        printf("Loading core %d.\n", (int)core_id);
+
+      // only one computation is needed... we'll end up with the last one after the loop
+      core_size = 0;
+      TraxCore *current_core = new TraxCore(num_thread_procs, threads_per_proc, num_regs, 
+					    scheduling_scheme, instructions, L2, core_id, 
+					    l2_id, run_profile, profiler, debugger);
+      config_reader.current_core = current_core;
+      config_reader.LoadConfig(L2, core_size);
+      current_core->modules.push_back(globals);
+      current_core->functional_units.push_back(globals);
+      if (proc_register_trace > -1 && i == 0) {
+        current_core->EnableRegisterDump(proc_register_trace);
+        //current_core->register_files[thread_register_trace]->EnableDump(thread_trace_file);
+      }
+
+      // Add Sync unit
+      Synchronize *sync_unit = new Synchronize(0,0,simd_width,num_thread_procs);
+      current_core->modules.push_back(sync_unit);
+      current_core->functional_units.push_back(sync_unit);
+
+      // Add any other custom units before the push_back
+      LocalStore *ls_unit = new LocalStore(1, num_thread_procs);
+      current_core->modules.push_back(ls_unit);
+      current_core->functional_units.push_back(ls_unit);
+      current_core->SetSymbols(regs);
+
+      // Link the FPAdder to the FPMul for fmad ops
+      // Similarly for integers
+      FPMul* fpmul = NULL;
+      FPAddSub* fpadd = NULL;
+      IntMul* intmul = NULL;
+      IntAddSub* intadd = NULL;
+      for(size_t unit_id = 0; unit_id < current_core->functional_units.size(); unit_id++)
+	{
+	  if(fpmul == NULL)
+	    fpmul = dynamic_cast<FPMul*>(current_core->functional_units[unit_id]);
+	  if(fpadd == NULL)
+	    fpadd = dynamic_cast<FPAddSub*>(current_core->functional_units[unit_id]);
+	  if(intmul == NULL)
+	    intmul = dynamic_cast<IntMul*>(current_core->functional_units[unit_id]);
+	  if(intadd == NULL)
+	    intadd = dynamic_cast<IntAddSub*>(current_core->functional_units[unit_id]);
+	}
+      if(fpmul != NULL && fpadd != NULL)
+	fpmul->SetAdder(fpadd);
+      if(intmul != NULL && intadd != NULL)
+	intmul->SetAdder(intadd);
+
+      cores.push_back(current_core);
+    }
+  }
+}
+
 // TODO: use popt.h instead of reinventing the wheel
 void printUsage(char* program_name) {
   printf("%s\n", program_name);
   printf(" + Simulator Parameters:\n");
   printf("    --atominc-report       <(debug): number of cycles between reporting global registers -- default 0, 0 means off>\n");
+  printf("    --check-assembler      [(debug): run the original regex matchers next to the assembler's lexer and stop at the first disagreement]\n");
+  printf("    --checkpoint-cycle     <save the full simulator state on reaching this cycle, then continue>\n");
+  printf("    --checkpoint-file      <checkpoint file name -- default checkpoint.ckpt>\n");
   printf("    --debug                <(debug): run TRaX progrem in the simtrax debugger>\n");
+  printf("    --deterministic        [make multi-threaded results independent of --simulation-threads and host timing]\n");
+  printf("    --functional           [execute the program with no timing model (no caches, DRAM or latencies)]\n");
+  printf("    --host-profile         [report the simulator's own speed and where its host time goes]\n");
+  printf("    --host-profile-period  <seconds between --host-profile progress lines -- default 10, 0 means only at the end>\n");
+  printf("    --huge-pages           [back simulated main memory with transparent huge pages]\n");
   printf("    --ignore-dcache-area   <reported chip area will not include data caches>\n");
-  printf("    --issue-verbosity      <level of verbosity for issue unit -- default 0>\n");
+  printf("    --incremental-output   <while running, write the framebuffer to outN.png every this many stores>\n");
+  printf("    --interval-stats       <write counters summed over every --interval-stats-period cycles to this CSV file>\n");
+  printf("    --interval-stats-period <cycles per row of --interval-stats -- default 10000>\n");
+  printf("    --issue-verbosity      <level of verbosity for issue unit, 2 and up write the binary issue_trace.bin (decode with samples/scripts/issue_trace_decode.py) -- default 0>\n");
+  printf("    --kernel-trace         <write each thread's PROF kernel regions to this file as a Chrome trace-event timeline>\n");
+  printf("    --latency-histograms   [report load latency, DRAM latency, DRAM queue occupancy and row-buffer hit percentiles]\n");
   printf("    --load-mem-file        [read memory dump from file]\n");
   printf("    --mem-file             <memory dump file name -- default memory.mem>\n");
+  printf("    --memory-bench         <stream synthetic loads through the caches and DRAM instead of running a program: sequential, strided, random, bvh or hotset>\n");
+  printf("    --memory-bench-accesses <total loads for --memory-bench -- default 1000000>\n");
+  printf("    --memory-bench-footprint <words of memory --memory-bench touches -- default 4194304>\n");
+  printf("    --memory-trace         <record every L1 data access to this binary trace file>\n");
   printf("    --print-instructions   [print contents of instruction memory]\n");
   printf("    --print-symbols        [print symbol table generated by assembler]\n");
   printf("    --profile              [print per-instruction execution info to \"profile.out\"]\n");
+  printf("    --profile-callgrind    <write per-PC issue and stall cycles to this file in callgrind format (KCachegrind)>\n");
+  printf("    --profile-memory       <write where each PC's and source line's loads were served from (L1, L2, DRAM) and their latency to this file>\n");
+  printf("    --profile-pprof        <write per-PC issue and stall cycles to this file as a pprof protobuf>\n");
+  printf("    --program-cache        <directory to keep assembled programs in, keyed by the assembly file's contents, so unchanged programs load without assembling>\n");
+  printf("    --replay-memory-trace  <drive the L1s, L2s and DRAM from a recorded memory trace instead of running the program>\n");
+  printf("    --restore-checkpoint   <resume simulation from a checkpoint file. TM, thread, cache and DRAM geometry must match>\n");
+  printf("    --sample-interval      <sampled simulation: instructions run functionally between cycle-accurate windows -- default 0, 0 means off>\n");
+  printf("    --sample-warmup        <unmeasured cycle-accurate cycles before each sample window -- default 1000>\n");
+  printf("    --sample-window        <measured cycles per sample window -- default 10000>\n");
   printf("    --serial-execution     [use a single pthread to run simulation]\n");
-  printf("    --simulation-threads   <number of simulator pthreads. -- default 1>\n");
+  printf("    --simulation-threads   <number of simulator pthreads, also used to build the grid -- default 1>\n");
   printf("    --stop-cycle           <stop the simulation on reaching this cycle number>\n");
+  printf("    --sweep                <run each configuration listed in this file on the same loaded program and scene, see Sweep.h>\n");
+  printf("    --sweep-output         <CSV file for the combined --sweep results -- default sweep.csv>\n");
   printf("    --verbose              enables output verbosity\n");
   printf("    --write-dot            <depth> generates a dot file for the BVH (bvh.dot). Depth should not exceed 8\n");
   printf("    --write-mem-file       [write memory dump to file]\n");
@@ -354,6 +788,7 @@ void printUsage(char* program_name) {
   printf("    --config-file     <config file name>\n");
   printf("    --dcacheparams    <data cache params file name>\n");
   printf("    --icacheparams    <instruction cache params file name>\n");
+  printf("    --keyframes       <text file listing one .obj per line, rendered as consecutive animation frames>\n");
   printf("    --light-file      <light file name>\n");
   printf("    --load-assembly   <TRaX assembly file to execute>\n");
   printf("    --model           <model file name (.obj)>\n");
@@ -369,14 +804,17 @@ void printUsage(char* program_name) {
   printf("    --height          <framebuffer height in pixels -- default 128>\n");
   printf("    --no-png          [disable png output]\n");
   printf("    --no-scene        <specify there is no model, camera, or light. use for non-ray tracing programs>\n");
+  printf("    --num-frames      <number of frames to simulate, cycling through the keyframes -- default one per keyframe, or 1>\n");
   printf("    --num-samples     <number of samples per pixel, pre-loaded to main memory -- default 1>\n");
   printf("    --ray-depth       <depth of rays, pre-loaded to main memory -- default 1>\n");
+  printf("    --rebuild-every   <rebuild the BVH every N frames instead of refitting it -- default 0 (always refit)>\n");
   printf("    --use-png-ext     [use png for file output -- default no (ppm instead)\\n");
   printf("    --width           <framebuffer width in pixels -- default 128>\n");
 
 
   printf("\n");
   printf("  + Other:\n");
+  printf("    --cache-line-layout       [lay out BVH nodes so that likely-visited sibling pairs share L1 cache lines]\n");
   printf("    --pack-split-axis         [BVH nodes will pack split axis in the 2nd byte and num_children in the 1st byte (lsB) of 6th word]\n");
   printf("    --store-parent-pointers   [BVH parent pointers will be stored in a separate array starting at TRAX_START_PARENT_POINTERS]\n");
   printf("    --triangles-store-edges   [set flag to store 2 edge vecs in a tri instead of 2 verts -- default: off]\n");
@@ -401,7 +839,7 @@ int main(int argc, char* argv[]) {
   int num_thread_procs                  = 1;
   int threads_per_proc                  = 1;
   int simd_width                        = 1;
-  int num_frames                        = 1;
+  int num_frames                        = 0; // 0 means one per keyframe (or a single frame)
   int rebuild_frequency                 = 0;
   bool duplicate_bvh                    = false;
   unsigned int num_cores                = 1;
@@ -410,6 +848,9 @@ int main(int argc, char* argv[]) {
   bool l2_off                           = false;
   bool l1_read_copy                     = false;
   long long int stop_cycle              = -1;
+  long long int checkpoint_cycle        = -1;
+  char* checkpoint_file                 = (char*)"checkpoint.ckpt";
+  char* restore_file                    = NULL;
   char* config_file                     = NULL;
   char* view_file                       = NULL;
   char* model_file                      = NULL;
@@ -435,7 +876,15 @@ int main(int argc, char* argv[]) {
   int num_icaches                       = 1;
   int icache_banks                      = 1;
   char *assem_file                      = NULL;
-  bool memory_trace                     = false;
+  char* memory_trace_file               = NULL;
+  char* replay_file                     = NULL;
+  char* memory_bench                    = NULL;
+  long long int memory_bench_accesses   = 1000000;
+  int memory_bench_footprint            = 1 << 22;
+  char* interval_stats_file             = NULL;
+  long long int interval_stats_period   = 10000;
+  bool host_profile                     = false;
+  double host_profile_period            = 10.;
   int proc_register_trace               = -1;
   bool print_symbols                    = false;
   char mem_file_orig[64]                = "memory.mem";
@@ -445,16 +894,30 @@ int main(int argc, char* argv[]) {
   int custom_mem_loader                 = 0;
   bool incremental_output               = false;
   bool serial_execution                 = false;
+  bool functional                       = false;
+  bool deterministic                    = false;
+  char* sweep_file                      = NULL;
+  char* callgrind_file                  = NULL;
+  char* pprof_file                      = NULL;
+  char* memory_profile_file             = NULL;
+  char* kernel_trace_file               = NULL;
+  char* program_cache_dir               = NULL;
+  char* sweep_output                    = (char*)"sweep.csv";
+  long long int sample_interval         = 0;
+  long long int sample_window           = 10000;
+  long long int sample_warmup           = 1000;
   bool triangles_store_edges            = false;
   int stores_between_output             = 64;
   int subtree_size                      = 0;
   bool pack_split_axis                  = false;
   bool pack_stream_boundaries           = false;
   bool store_parent_pointers            = false;
+  bool cache_line_layout                = false;
+  bool huge_pages                       = false;
   disable_usimm                         = false; // globally defined for use above
   wait_usimm                            = false;
-  BVH* bvh;
-  //Animation *animation                  = NULL;
+  BVH* bvh                              = NULL;
+  Animation *animation                  = NULL;
   ThreadProcessor::SchedulingScheme scheduling_scheme = ThreadProcessor::SIMPLE;
   int total_simulation_threads          = 1;
   char *usimm_config_file               = NULL;
@@ -527,6 +990,12 @@ int main(int argc, char* argv[]) {
       l1_read_copy = true;
     } else if (strcmp(argv[i], "--stop-cycle") == 0) {
       stop_cycle = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--checkpoint-cycle") == 0) {
+      checkpoint_cycle = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--checkpoint-file") == 0) {
+      checkpoint_file = argv[++i];
+    } else if (strcmp(argv[i], "--restore-checkpoint") == 0) {
+      restore_file = argv[++i];
     } else if (strcmp(argv[i], "--config-file") == 0) {
       config_file = argv[++i];
     } else if (strcmp(argv[i], "--view-file") == 0) {
@@ -535,7 +1004,7 @@ int main(int argc, char* argv[]) {
       model_file = argv[++i];
     } else if (strcmp(argv[i], "--far-value") == 0) {
       far = static_cast<float>( atof(argv[++i]) );
-    } else if (strcmp(argv[i], "--first-keyframe") == 0) {
+    } else if (strcmp(argv[i], "--keyframes") == 0) {
       keyframe_file = argv[++i];
     } else if (strcmp(argv[i], "--num-frames") == 0) {
       num_frames = atoi(argv[++i]);
@@ -582,7 +1051,23 @@ int main(int argc, char* argv[]) {
     } else if (strcmp(argv[i], "--load-assembly") == 0) {
       assem_file = argv[++i];
     } else if (strcmp(argv[i], "--memory-trace") == 0) {
-      memory_trace = true;
+      memory_trace_file = argv[++i];
+    } else if (strcmp(argv[i], "--memory-bench") == 0) {
+      memory_bench = argv[++i];
+    } else if (strcmp(argv[i], "--memory-bench-accesses") == 0) {
+      memory_bench_accesses = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--memory-bench-footprint") == 0) {
+      memory_bench_footprint = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--replay-memory-trace") == 0) {
+      replay_file = argv[++i];
+    } else if (strcmp(argv[i], "--host-profile") == 0) {
+      host_profile = true;
+    } else if (strcmp(argv[i], "--host-profile-period") == 0) {
+      host_profile_period = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--interval-stats") == 0) {
+      interval_stats_file = argv[++i];
+    } else if (strcmp(argv[i], "--interval-stats-period") == 0) {
+      interval_stats_period = atoll(argv[++i]);
     } else if (strcmp(argv[i], "--proc-register-trace") == 0) {
       proc_register_trace = atoi(argv[++i]);
     } else if (strcmp(argv[i], "--print-symbols") == 0) {
@@ -590,6 +1075,20 @@ int main(int argc, char* argv[]) {
     } else if (strcmp(argv[i], "--profile") == 0) {
       run_profile = true;
       needs_debug_symbols = true;
+    } else if (strcmp(argv[i], "--profile-callgrind") == 0) {
+      callgrind_file = argv[++i];
+    } else if (strcmp(argv[i], "--profile-pprof") == 0) {
+      pprof_file = argv[++i];
+    } else if (strcmp(argv[i], "--profile-memory") == 0) {
+      memory_profile_file = argv[++i];
+    } else if (strcmp(argv[i], "--kernel-trace") == 0) {
+      kernel_trace_file = argv[++i];
+    } else if (strcmp(argv[i], "--program-cache") == 0) {
+      program_cache_dir = argv[++i];
+    } else if (strcmp(argv[i], "--check-assembler") == 0) {
+      AsmLexer::check_regex = true;
+    } else if (strcmp(argv[i], "--latency-histograms") == 0) {
+      latency_histograms = true;
     } else if (strcmp(argv[i], "--debug") == 0) {
       run_debugger = true;
       needs_debug_symbols = true;
@@ -606,6 +1105,20 @@ int main(int argc, char* argv[]) {
       stores_between_output = atoi(argv[++i]);
     } else if (strcmp(argv[i], "--serial-execution") == 0) {
       serial_execution = true;
+    } else if (strcmp(argv[i], "--sweep") == 0) {
+      sweep_file = argv[++i];
+    } else if (strcmp(argv[i], "--sweep-output") == 0) {
+      sweep_output = argv[++i];
+    } else if (strcmp(argv[i], "--deterministic") == 0) {
+      deterministic = true;
+    } else if (strcmp(argv[i], "--functional") == 0) {
+      functional = true;
+    } else if (strcmp(argv[i], "--sample-interval") == 0) {
+      sample_interval = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--sample-window") == 0) {
+      sample_window = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "--sample-warmup") == 0) {
+      sample_warmup = atoll(argv[++i]);
     } else if (strcmp(argv[i], "--triangles-store-edges") == 0) {
       triangles_store_edges = true;
     } else if (strcmp(argv[i], "--subtree-size") == 0) {
@@ -614,6 +1127,8 @@ int main(int argc, char* argv[]) {
       pack_split_axis = true;
     } else if (strcmp(argv[i], "--store-parent-pointers") == 0) {
       store_parent_pointers = true;
+    } else if (strcmp(argv[i], "--cache-line-layout") == 0) {
+      cache_line_layout = true;
     } else if (strcmp(argv[i], "--pack-stream-boundaries") == 0) {
       pack_stream_boundaries = true;
     } else if (strcmp(argv[i], "--scheduling") == 0) {
@@ -636,6 +1151,8 @@ int main(int argc, char* argv[]) {
       disable_usimm = 1;
     } else if (strcmp(argv[i], "--wait-usimm") == 0) {
       wait_usimm = true;
+    } else if (strcmp(argv[i], "--huge-pages") == 0) {
+      huge_pages = true;
     }
     else {
       printf(" Unrecognized option %s\n", argv[i]);
@@ -648,7 +1165,8 @@ int main(int argc, char* argv[]) {
   }
 
 
-  if(rebuild_frequency > 0)
+  // frames update the primary BVH in place, there is no second copy to keep in sync
+  if(rebuild_frequency > 0 || keyframe_file != NULL)
     duplicate_bvh = false;
   
   // size estimates
@@ -659,6 +1177,8 @@ int main(int argc, char* argv[]) {
 
   // Keep track of register names
   std::vector<symbol*> regs;
+  // and instruction labels, for the profile exporters
+  std::vector<symbol*> text_labels;
 
   // Assembler needs somewhere to store the jump table and string literals, to be loaded in to local stores after assembly
   char* jump_table;
@@ -683,67 +1203,13 @@ int main(int argc, char* argv[]) {
 
   //if (config_file != NULL) {
   // Set up memory from config (L2 and main memory)
-  ReadConfig config_reader(config_file, dcache_params_file, L2s, num_L2s, memory, L2_size, disable_usimm, memory_trace, l1_off, l2_off, l1_read_copy);
-
-  // loop through the L2s
-  for(size_t l2_id = 0; l2_id < num_L2s; ++l2_id) {
-    L2Cache* L2 = L2s[l2_id];
-    // load the cores
-    for(size_t i = 0; i < num_cores; ++i) {
-      size_t core_id = i + num_cores * l2_id;
-      if(trax_verbosity)
-        printf("Loading core %d.\n", (int)core_id);
-
-      // only one computation is needed... we'll end up with the last one after the loop
-      core_size = 0;
-      TraxCore *current_core = new TraxCore(num_thread_procs, threads_per_proc, num_regs, 
-					    scheduling_scheme, &instructions, L2, core_id, 
-					    l2_id, run_profile, &profiler, &debugger);
-      config_reader.current_core = current_core;
-      config_reader.LoadConfig(L2, core_size);
-      current_core->modules.push_back(&globals);
-      current_core->functional_units.push_back(&globals);
-      if (proc_register_trace > -1 && i == 0) {
-        current_core->EnableRegisterDump(proc_register_trace);
-        //current_core->register_files[thread_register_trace]->EnableDump(thread_trace_file);
-      }
+  ReadConfig config_reader(config_file, dcache_params_file, L2s, num_L2s, memory, L2_size, disable_usimm, memory_trace_file != NULL, l1_off, l2_off, l1_read_copy);
+  if(huge_pages)
+    memory->EnableHugePages();
 
-      // Add Sync unit
-      Synchronize *sync_unit = new Synchronize(0,0,simd_width,num_thread_procs);
-      current_core->modules.push_back(sync_unit);
-      current_core->functional_units.push_back(sync_unit);
-
-      // Add any other custom units before the push_back
-      LocalStore *ls_unit = new LocalStore(1, num_thread_procs);
-      current_core->modules.push_back(ls_unit);
-      current_core->functional_units.push_back(ls_unit);
-      current_core->SetSymbols(&regs);
-
-      // Link the FPAdder to the FPMul for fmad ops
-      // Similarly for integers
-      FPMul* fpmul = NULL;
-      FPAddSub* fpadd = NULL;
-      IntMul* intmul = NULL;
-      IntAddSub* intadd = NULL;
-      for(size_t unit_id = 0; unit_id < current_core->functional_units.size(); unit_id++)
-	{
-	  if(fpmul == NULL)
-	    fpmul = dynamic_cast<FPMul*>(current_core->functional_units[unit_id]);
-	  if(fpadd == NULL)
-	    fpadd = dynamic_cast<FPAddSub*>(current_core->functional_units[unit_id]);
-	  if(intmul == NULL)
-	    intmul = dynamic_cast<IntMul*>(current_core->functional_units[unit_id]);
-	  if(intadd == NULL)
-	    intadd = dynamic_cast<IntAddSub*>(current_core->functional_units[unit_id]);
-	}
-      if(fpmul != NULL && fpadd != NULL)
-	fpmul->SetAdder(fpadd);
-      if(intmul != NULL && intadd != NULL)
-	intmul->SetAdder(intadd);
-
-      cores.push_back(current_core);
-    }
-  }
+  BuildCores(config_reader, L2s, num_L2s, num_cores, num_thread_procs, threads_per_proc, num_regs,
+             simd_width, scheduling_scheme, proc_register_trace, run_profile, &instructions, &regs,
+             &globals, &profiler, &debugger, cores, core_size);
 
   // set up L1 snooping if enabled
   if(cache_snoop) {
@@ -816,11 +1282,13 @@ int main(int argc, char* argv[]) {
         return -1;
       }
 
-      // just set the model file equal to the keyframe file and load it the same way
+      // just set the model file equal to the first keyframe and load it the same way
       // first frame will be loaded exactly the same way, memory loader doesn't need to change.
       // subsequent frames will be updated by the Animation, directly in simulator's memory
-      //if(keyframe_file != NULL)
-      //model_file = keyframe_file;
+      if(keyframe_file != NULL) {
+        animation = new Animation(keyframe_file, rebuild_frequency);
+        model_file = (char*)animation->keyframes[0].c_str();
+      }
 
       if(!no_scene && model_file == NULL) {
         printf("ERROR: No model data supplied.\n");
@@ -845,6 +1313,7 @@ int main(int argc, char* argv[]) {
       paramsForLoadMemory.image_width               = image_width;
       paramsForLoadMemory.image_height              = image_height;
       paramsForLoadMemory.grid_dimensions           = grid_dimensions;
+      paramsForLoadMemory.num_build_threads         = total_simulation_threads;
       paramsForLoadMemory.camera                    = camera;
       paramsForLoadMemory.model_file                = model_file;
       paramsForLoadMemory.background_color[0]       = background_color[0];
@@ -866,6 +1335,8 @@ int main(int argc, char* argv[]) {
       paramsForLoadMemory.pack_split_axis           = pack_split_axis;
       paramsForLoadMemory.pack_stream_boundaries    = pack_stream_boundaries;
       paramsForLoadMemory.store_parent_pointers     = store_parent_pointers;
+      if(cache_line_layout)
+        paramsForLoadMemory.layout_line_size        = cores[0]->L1->line_size;
 
       LoadMemory(paramsForLoadMemory);
 
@@ -883,6 +1354,137 @@ int main(int argc, char* argv[]) {
     }
   } // end else for memory dump file
 
+  if(animation && bvh == NULL) {
+    printf("ERROR: --keyframes requires the scene to be loaded in to a BVH\n");
+    return -1;
+  }
+
+  // by default render each keyframe once
+  if(num_frames < 1)
+    num_frames = animation ? (int)animation->keyframes.size() : 1;
+
+  if((checkpoint_cycle >= 0 || restore_file) && (num_frames > 1 || run_profile)) {
+    printf("ERROR: checkpoints are not supported with multiple frames or --profile\n");
+    return -1;
+  }
+
+  // Functional mode has no cycles to checkpoint, profile or step through
+  if(functional) {
+    if(checkpoint_cycle >= 0 || restore_file || run_profile || run_debugger) {
+      printf("ERROR: --functional is not supported with checkpoints, --profile or --debug\n");
+      return -1;
+    }
+    disable_usimm = true;
+    wait_usimm = false;
+    print_cpi = false;
+  }
+
+  // Sampled runs report extrapolated estimates instead of the usual stats
+  Sampler* sampler = NULL;
+  if(sample_interval > 0) {
+    if(functional || checkpoint_cycle >= 0 || restore_file || run_profile || run_debugger) {
+      printf("ERROR: --sample-interval is not supported with --functional, checkpoints, --profile or --debug\n");
+      return -1;
+    }
+    if(sample_window < 1 || sample_warmup < 0) {
+      printf("ERROR: --sample-window must be positive and --sample-warmup not negative\n");
+      return -1;
+    }
+    sampler = new Sampler(sample_interval, sample_window, sample_warmup);
+    print_cpi = false;
+  }
+
+  // Replay only drives the memory system, so there is no program state to save or profile
+  if(replay_file) {
+    if(functional || sampler || memory_trace_file || checkpoint_cycle >= 0 || restore_file || run_profile || run_debugger || num_frames > 1) {
+      printf("ERROR: --replay-memory-trace is not supported with --functional, sampling, --memory-trace, checkpoints, multiple frames, --profile or --debug\n");
+      return -1;
+    }
+    print_png = false;
+  }
+
+  // Same for the memory microbenchmarks, which don't run the program at all
+  if(memory_bench) {
+    if(!ValidMemoryBenchPattern(memory_bench)) {
+      printf("ERROR: unknown --memory-bench pattern '%s'\n", memory_bench);
+      return -1;
+    }
+    if(functional || sampler || replay_file || memory_trace_file || checkpoint_cycle >= 0 || restore_file || run_profile || run_debugger || num_frames > 1) {
+      printf("ERROR: --memory-bench is not supported with --functional, sampling, memory traces, checkpoints, multiple frames, --profile or --debug\n");
+      return -1;
+    }
+    if(memory_bench_accesses < 1) {
+      printf("ERROR: --memory-bench-accesses must be positive\n");
+      return -1;
+    }
+    if(memory_bench_footprint > memory->getSize())
+      memory_bench_footprint = memory->getSize();
+    print_png = false;
+  }
+
+  // Interval stats follow the cycle-accurate clock, which these modes skip or fake
+  if(interval_stats_file) {
+    if(functional || sampler || replay_file || memory_bench) {
+      printf("ERROR: --interval-stats is not supported with --functional, sampling, --replay-memory-trace or --memory-bench\n");
+      return -1;
+    }
+    if(interval_stats_period < 1) {
+      printf("ERROR: --interval-stats-period must be positive\n");
+      return -1;
+    }
+  }
+
+  // Sweep points are plain runs to completion, each on a fresh machine
+  if(sweep_file) {
+    if(functional || sampler || replay_file || memory_bench || memory_trace_file || checkpoint_cycle >= 0 || restore_file ||
+       run_profile || run_debugger || num_frames > 1 || interval_stats_file || host_profile || cache_snoop || incremental_output) {
+      printf("ERROR: --sweep is not supported with --functional, sampling, --replay-memory-trace, --memory-bench, --memory-trace, checkpoints, --profile, --debug, multiple frames, --interval-stats, --host-profile, --cache-snoop or --incremental-output\n");
+      return -1;
+    }
+    print_png = false;
+  }
+
+  // The exporters need every issue of the program run cycle-accurately, start to finish
+  if(callgrind_file || pprof_file || memory_profile_file || kernel_trace_file) {
+    if(functional || sampler || replay_file || memory_bench || checkpoint_cycle >= 0 || restore_file || sweep_file) {
+      printf("ERROR: --profile-callgrind, --profile-pprof, --profile-memory and --kernel-trace are not supported with --functional, sampling, --replay-memory-trace, --memory-bench, checkpoints or --sweep\n");
+      return -1;
+    }
+    pc_profiling = callgrind_file || pprof_file || memory_profile_file;
+    kernel_trace = kernel_trace_file != NULL;
+  }
+
+  // Histograms are not reset between sweep points, and checkpoints don't save them or the
+  // loads' issue cycles
+  if(latency_histograms) {
+    if(functional || sweep_file || checkpoint_cycle >= 0 || restore_file) {
+      printf("ERROR: --latency-histograms is not supported with --functional, --sweep or checkpoints\n");
+      return -1;
+    }
+    LatencyHistogramsSetup(num_cores * num_L2s);
+  }
+
+  // Snooping L1s read each other's lines, which can belong to TMs on other threads
+  if(deterministic && cache_snoop) {
+    printf("ERROR: --deterministic is not supported with --cache-snoop\n");
+    return -1;
+  }
+
+  // Sweep points would restart each TM's trace
+  if(issue_verbosity > 1) {
+    if(sweep_file) {
+      printf("ERROR: --issue-verbosity above 1 is not supported with --sweep\n");
+      return -1;
+    }
+    issue_trace_writer = new IssueTraceWriter(ISSUE_TRACE_FILE, num_cores * num_L2s, num_thread_procs);
+  }
+
+  MemoryTraceWriter* memory_trace = NULL;
+  if(memory_trace_file) {
+    memory_trace = new MemoryTraceWriter(memory_trace_file, num_cores * num_L2s, num_thread_procs);
+    for(size_t i = 0; i < num_cores * num_L2s; ++i)
+      cores[i]->L1->trace = memory_trace;
+  }
 
   // Set up incremental output if option is specified
   if(incremental_output) {
@@ -891,6 +1493,7 @@ int main(int argc, char* argv[]) {
     memory->incremental_output = incremental_output;
     memory->start_framebuffer = start_framebuffer;
     memory->stores_between_output = stores_between_output;
+    memory->incremental_writer = new IncrementalOutput(image_width, image_height);
   }
 
   int memory_size = memory->getSize();
@@ -919,7 +1522,7 @@ int main(int argc, char* argv[]) {
 
   int jtable_size = 0;
   if(assem_file != NULL) {
-    jtable_size = Assembler::LoadAssem(assem_file, instructions, regs, num_regs, jump_table, ascii_literals, source_names, source_lines, print_symbols, needs_debug_symbols, &dwarfReader);
+    jtable_size = Assembler::LoadAssem(assem_file, instructions, regs, num_regs, jump_table, ascii_literals, source_names, source_lines, print_symbols, needs_debug_symbols, &dwarfReader, &text_labels, program_cache_dir);
     if(jtable_size < 0) {
       printf("assembler returned an error, exiting\n");
       exit(-1);
@@ -927,7 +1530,8 @@ int main(int argc, char* argv[]) {
     if(trax_verbosity)
       printf("data segment: %d bytes\n", jtable_size);
   }
-  else {
+  // trace replay and the memory microbenchmarks drive the caches without a program
+  else if(!replay_file && !memory_bench) {
     printf("Error: no assembly program specified\n");
     return -1;
   }
@@ -1052,22 +1656,127 @@ int main(int argc, char* argv[]) {
   // initialize variables for synchronization
   current_simulation_threads = total_simulation_threads;
 
-  int cores_per_thread = (num_cores * num_L2s) / total_simulation_threads + 1;
-  int remainder_threads = (num_cores * num_L2s) % total_simulation_threads;
-  int start_core = 0;
-  for(int i = 0; i < total_simulation_threads; ++i) {
-    if(remainder_threads == i) {
-      cores_per_thread--;
+  PartitionCores(args, total_simulation_threads, &cores, stop_cycle, sampler != NULL);
+
+  // Each sweep point gets its own L2s, main memory, TMs and DRAM, starting from a copy of the
+  // program and scene loaded above. The machine built from the command line only holds them.
+  if(sweep_file) {
+    std::vector<SweepPoint> points;
+    ReadSweepFile(sweep_file, points);
+    std::vector<SweepResult> results(points.size());
+    // Decided from contents, not host residency: an uncached --load-mem-file page still holds data
+    std::vector<bool> loaded;
+    memory->NonZeroPages(MEMORY_IMAGE_PAGE_WORDS, loaded);
+    L2Cache** base_L2s = L2s;
+
+    for(size_t p = 0; p < points.size(); ++p) {
+      SweepPoint& point = points[p];
+      if(point.num_cores == 0)
+        point.num_cores = num_cores;
+      if(point.simulation_threads == 0)
+        point.simulation_threads = total_simulation_threads;
+      if(point.config_file.empty())
+        point.config_file = config_file;
+      if(point.dcache_params_file.empty())
+        point.dcache_params_file = dcache_params_file;
+      if(!disable_usimm && point.usimm_config_file.empty())
+        point.usimm_config_file = usimm_config_file;
+      if(!disable_usimm && point.usimm_vi_file.empty() && usimm_vi_file)
+        point.usimm_vi_file = usimm_vi_file;
+      int point_threads = point.simulation_threads;
+      if(point_threads > point.num_cores * (int)num_L2s)
+        point_threads = point.num_cores * num_L2s;
+      printf("Sweep point %d of %d: %s (%d TMs, %d simulation threads, %s)\n", (int)p + 1, (int)points.size(),
+             point.name.c_str(), point.num_cores, point_threads, point.config_file.c_str());
+      boost::chrono::system_clock::time_point point_start = boost::chrono::system_clock::now();
+
+      L2s = new L2Cache*[num_L2s];
+      MainMemory* point_memory;
+      double point_L2_size = 0;
+      double point_core_size = 0;
+      GlobalRegisterFile point_globals(num_globals, num_thread_procs * threads_per_proc * point.num_cores * num_L2s, atominc_report_period);
+      ReadConfig point_reader(point.config_file.c_str(), point.dcache_params_file.c_str(), L2s, num_L2s, point_memory,
+                              point_L2_size, disable_usimm, false, l1_off, l2_off, l1_read_copy);
+      if(end_memory > point_memory->getSize()) {
+        printf("ERROR: Scene requires %d blocks while memory_size is only %d for sweep point %s\n",
+               end_memory, point_memory->getSize(), point.name.c_str());
+        exit(-1);
+      }
+      if(huge_pages)
+        point_memory->EnableHugePages();
+
+      // Copy the loaded memory, all-zero pages are already zero in the new memory
+      int copy_words = memory_size < point_memory->getSize() ? memory_size : point_memory->getSize();
+      for(size_t page = 0; page < loaded.size() && (int)(page * MEMORY_IMAGE_PAGE_WORDS) < copy_words; ++page) {
+        if(!loaded[page])
+          continue;
+        int start = page * MEMORY_IMAGE_PAGE_WORDS;
+        int words = copy_words - start < MEMORY_IMAGE_PAGE_WORDS ? copy_words - start : MEMORY_IMAGE_PAGE_WORDS;
+        memcpy(point_memory->getData() + start, memory->getData() + start, words * sizeof(FourByte));
+      }
+      if(!custom_mem_loader)
+        WriteMachineParams(point_memory->getData(), num_thread_procs * point.num_cores, point.num_cores);
+
+      std::vector<TraxCore*> point_cores;
+      BuildCores(point_reader, L2s, num_L2s, point.num_cores, num_thread_procs, threads_per_proc, num_regs,
+                 simd_width, scheduling_scheme, proc_register_trace, run_profile, &instructions, &regs,
+                 &point_globals, &profiler, &debugger, point_cores, point_core_size);
+      for(size_t i = 0; i < point_cores.size(); ++i)
+        point_cores[i]->initialize(icache_params_file, issue_verbosity, num_icaches, icache_banks, simd_width, jump_table, jtable_size, ascii_literals);
+
+      if(!disable_usimm) {
+        // the command line's DRAM (or the previous point's) goes first
+        usimm_teardown();
+        if(usimm_setup((char*)point.usimm_config_file.c_str(),
+                       point.usimm_vi_file.empty() ? NULL : (char*)point.usimm_vi_file.c_str()) < 0) {
+          printf("unable to initialize usimm\n");
+          exit(1);
+        }
+      }
+
+      pthread_t* point_threadids = new pthread_t[point_threads];
+      CoreThreadArgs* point_args = new CoreThreadArgs[point_threads];
+      PartitionCores(point_args, point_threads, &point_cores, stop_cycle, true);
+      RunCores(point_args, point_threads, serial_execution, &attr, point_threadids, deterministic);
+      double host_seconds = boost::chrono::duration<double>(boost::chrono::system_clock::now() - point_start).count();
+      GatherSweepResult(point_cores, L2s, num_L2s, !disable_usimm, host_seconds, results[p]);
+      printf("Sweep point %s: %lld cycles, %.2f s\n\n", point.name.c_str(), results[p].cycles, host_seconds);
+
+      delete[] point_args;
+      delete[] point_threadids;
+      for(size_t i = 0; i < point_cores.size(); ++i)
+        delete point_cores[i];
+      for(size_t i = 0; i < num_L2s; ++i)
+        delete L2s[i];
+      delete[] L2s;
+      delete point_memory;
     }
-    args[i].start_core = start_core;
-    args[i].end_core   = start_core + cores_per_thread;
-    start_core        += cores_per_thread;
-    args[i].thread_num = i;
-    args[i].stop_cycle = stop_cycle;
-    args[i].cores      = &cores;
+    L2s = base_L2s;
+
+    WriteSweepResults(sweep_output, points, results);
+    PrintElapsedTime("Total time", time_start);
+    return 0;
+  }
+
+  // Pick up where a previous run left off. Memory and all unit state are replaced.
+  if(restore_file) {
+    printf("Restoring checkpoint '%s'.\n", restore_file);
+    CheckpointStream checkpoint(restore_file, false);
+    CheckpointSimulator(checkpoint, cores, L2s, num_L2s, &globals, memory, !disable_usimm);
+    printf("Resuming at cycle %lld.\n", cores[0]->cycle_num);
+  }
+
+  // Created after a restore so the first interval starts from the restored counters
+  interval_stats = NULL;
+  if(interval_stats_file)
+    interval_stats = new IntervalStats(interval_stats_file, interval_stats_period, cores, L2s, num_L2s, !disable_usimm);
+
+  host_profiler = NULL;
+  if(host_profile) {
+    host_profiler = new HostProfiler(serial_execution ? 1 : total_simulation_threads, host_profile_period);
+    host_profiler->step_seconds[HOST_SETUP] =
+      boost::chrono::duration<double>(boost::chrono::system_clock::now() - time_start).count();
   }
-  // Have the last thread do the remainder
-  args[total_simulation_threads - 1].end_core = num_cores * num_L2s;
 
   PrintElapsedTime("Setup time", time_start);
 
@@ -1085,36 +1794,125 @@ int main(int argc, char* argv[]) {
   // Allow for the user to set up initial breakpoints
   debugger.run(NULL, NULL); // null args to indicate first invocation 
 
-  //while(true) { // put a loop here for multiple frames
-  boost::chrono::system_clock::time_point prev_frame_time = boost::chrono::system_clock::now();
-  if(serial_execution)
-    SerialExecution(args, num_cores * num_L2s);
-  
-  else {
-    for(int i = 0; i < total_simulation_threads; ++i) {
-      printf("Creating thread %d...\n", (int)i);
-      pthread_create( &threadids[i], &attr, CoreThread, (void *)&args[i] );
+  std::vector<long long int> frame_cycles;
+  long long int cycle_count = 0;
+  for(int frame = 0; frame < num_frames; ++frame) {
+    if(frame > 0) {
+      // Update the scene and restart the program. Cycle counts, stats and caches carry over,
+      // so all frames form one continuous run on the same simulator state.
+      if(animation)
+        animation->LoadFrame(frame, bvh, memory->getData());
+      globals.Reset();
+      for(size_t i = 0; i < num_cores * num_L2s; ++i) {
+        cores[i]->Restart();
+      }
     }
-    
-    // Wait for machine to halt
-    for(int i = 0; i < total_simulation_threads; ++i) {
-      pthread_join( threadids[i], NULL );
+
+    boost::chrono::system_clock::time_point prev_frame_time = boost::chrono::system_clock::now();
+    if(host_profiler)
+      host_profiler->BeginStep(HOST_SIMULATION);
+    bool resume = false;
+    do {
+      // Pause on the checkpoint cycle, save the state, then carry on from the same point
+      for(int i = 0; i < total_simulation_threads; ++i)
+        args[i].pause_cycle = checkpoint_cycle;
+
+      if(functional) {
+        long long int executed = FunctionalExecution(cores, memory);
+        printf("Functional execution: %lld instructions\n", executed);
+      }
+
+      else if(replay_file) {
+        long long int replay_cycles = ReplayMemoryTrace(replay_file, cores, L2s, num_L2s, !disable_usimm);
+        for(size_t i = 0; i < num_cores * num_L2s; ++i)
+          cores[i]->cycle_num = replay_cycles;
+      }
+
+      else if(memory_bench) {
+        long long int bench_cycles = MemoryBenchmark(memory_bench, memory_bench_accesses, memory_bench_footprint,
+                                                     cores, L2s, num_L2s, !disable_usimm);
+        for(size_t i = 0; i < num_cores * num_L2s; ++i)
+          cores[i]->cycle_num = bench_cycles;
+      }
+
+      else if(sampler) {
+        printf("Cores 0 through %d running (sampled, %lld instructions between windows)\n",
+               (int)(num_cores * num_L2s) - 1, sample_interval);
+        // Each window pauses twice: once after warming up, once at the end of the measurement
+        while(sampler->FastForward(cores, memory)) {
+          if(sample_warmup > 0) {
+            for(int i = 0; i < total_simulation_threads; ++i)
+              args[i].pause_cycle = LatestCycle(cores) + sample_warmup;
+            RunCores(args, total_simulation_threads, serial_execution, &attr, threadids, deterministic);
+          }
+          sampler->BeginWindow(cores, L2s, num_L2s, !disable_usimm);
+          for(int i = 0; i < total_simulation_threads; ++i)
+            args[i].pause_cycle = LatestCycle(cores) + sample_window;
+          RunCores(args, total_simulation_threads, serial_execution, &attr, threadids, deterministic);
+          sampler->EndWindow(cores, L2s, num_L2s, !disable_usimm);
+          DrainCores(cores);
+        }
+      }
+
+      else
+        RunCores(args, total_simulation_threads, serial_execution, &attr, threadids, deterministic);
+
+      long long int reached_cycle = 0;
+      bool all_halted = true;
+      for(size_t i = 0; i < num_cores * num_L2s; ++i) {
+        if(cores[i]->cycle_num > reached_cycle)
+          reached_cycle = cores[i]->cycle_num;
+        if(!cores[i]->issuer->halted)
+          all_halted = false;
+      }
+      if(wait_usimm && usimmIsBusy())
+        all_halted = false;
+
+      resume = false;
+      if(checkpoint_cycle >= 0 && reached_cycle == checkpoint_cycle) {
+        printf("Writing checkpoint at cycle %lld to '%s'.\n", reached_cycle, checkpoint_file);
+        CheckpointStream checkpoint(checkpoint_file, true);
+        CheckpointSimulator(checkpoint, cores, L2s, num_L2s, &globals, memory, !disable_usimm);
+        checkpoint_cycle = -1;
+        resume = !all_halted && reached_cycle != stop_cycle;
+      }
+    } while(resume);
+    if(host_profiler)
+      host_profiler->EndStep(HOST_SIMULATION);
+    PrintElapsedTime("Frame time", prev_frame_time);
+
+    // After reaching this point, the machine has halted.
+    // get highest cycle count
+    long long int frame_start_cycle = cycle_count;
+    for(size_t i = 0; i < num_cores * num_L2s; ++i) {
+      if(cores[i]->cycle_num > cycle_count)
+        cycle_count = cores[i]->cycle_num;
+    }
+    frame_cycles.push_back(cycle_count - frame_start_cycle);
+    if(num_frames > 1)
+      printf("Frame %d complete: %lld cycles\n", frame, frame_cycles.back());
+
+    if(print_png) {
+      if(host_profiler)
+        host_profiler->BeginStep(HOST_IMAGE_OUTPUT);
+      // a single frame keeps the plain output name
+      WriteFrameImage(memory->getData(), start_framebuffer, image_width, image_height,
+                      output_prefix, use_png_ext_for_output, num_frames > 1 ? frame : -1);
+      if(host_profiler)
+        host_profiler->EndStep(HOST_IMAGE_OUTPUT);
     }
   }
-  PrintElapsedTime("Frame time", prev_frame_time);
 
   delete[] args;
 
-  // After reaching this point, the machine has halted.
-  // Take a look and print relevant stats
-  
-  // get highest cycle count
-  long long int cycle_count = 0;
-  for(size_t i = 0; i < num_cores * num_L2s; ++i) {
-    if(cores[i]->cycle_num > cycle_count) 
-      cycle_count = cores[i]->cycle_num;
+  if(interval_stats) {
+    // the last row covers whatever is left of the final interval
+    interval_stats->Sample(cycle_count);
+    delete interval_stats;
   }
 
+  // Take a look and print relevant stats
+
   if(run_profile)
     {
       FILE* profile_output = fopen("profile.out", "w");      
@@ -1124,10 +1922,27 @@ int main(int argc, char* argv[]) {
 	}
       else
 	{
+	  if(host_profiler)
+	    host_profiler->BeginStep(HOST_PROFILE_OUTPUT);
 	  PrintProfile(assem_file, instructions, source_names, profile_output, profiler, cycle_count * num_cores * num_L2s * num_thread_procs);
 	  fclose(profile_output);
+	  if(host_profiler)
+	    host_profiler->EndStep(HOST_PROFILE_OUTPUT);
 	}
     }
+
+  if(callgrind_file || pprof_file) {
+    std::vector<ProfileFunction> functions;
+    ProfileFunctions(text_labels, functions);
+    if(callgrind_file)
+      WriteCallgrindProfile(callgrind_file, assem_file, instructions, functions, source_names);
+    if(pprof_file)
+      WritePprofProfile(pprof_file, assem_file, instructions, functions, source_names);
+  }
+  if(memory_profile_file)
+    WriteMemoryProfile(memory_profile_file, assem_file, instructions, source_names);
+  if(kernel_trace_file)
+    WriteKernelTrace(kernel_trace_file, cores);
   
   
   if(print_cpi) {
@@ -1297,9 +2112,10 @@ int main(int argc, char* argv[]) {
     
     DRAM_power = getUsimmPower() / 1000;
     
-    double FPS = Hz/static_cast<double>(cycle_count);
+    // energies are totals over all frames
+    double FPS = Hz * num_frames / static_cast<double>(cycle_count);
     
-    DRAM_energy = DRAM_power / FPS;
+    DRAM_energy = DRAM_power * num_frames / FPS;
     double total_energy = compute_energy + L1_energy + L2_energy + icache_energy + localstore_energy + register_energy + DRAM_energy;
     
     
@@ -1313,153 +2129,62 @@ int main(int argc, char* argv[]) {
     printf("   DRAM: \t\t %f\n", DRAM_energy);
     printf("   ------------------------------\n");
     printf("   Total: \t\t %f\n", total_energy);
-    printf("   Power draw (watts): \t %f\n\n", (total_energy / (1.f / FPS)));
+    printf("   Power draw (watts): \t %f\n\n", (total_energy / (num_frames / FPS)));
     
     printf("FPS Statistics:\n");
     printf("   Total clock cycles: \t\t %lld\n", cycle_count);
     printf("   FPS assuming %dMHz clock: \t %.4lf\n", (int)Hz / 1000000, FPS);
+    if(num_frames > 1) {
+      printf("   Frames: \t\t\t %d\n", num_frames);
+      for(int frame = 0; frame < num_frames; ++frame)
+        printf("   Frame %d clock cycles: \t %lld\n", frame, frame_cycles[frame]);
+    }
     
     printf("\n\n");
     
     if(!disable_usimm)
       printUsimmStats();
-  }  // end print_cpu
-  
-  fflush(stdout);
-  
-  if(print_png) {
-
-    const int imgNameLen = strlen(output_prefix);
-    bool outputPrefixHasExtension = false;
-    for(int i=imgNameLen-1; i>=0; --i) {
-      if(output_prefix[i]=='\\' || output_prefix[i]=='/')
-        break;
-      if(output_prefix[i]=='.') {
-        outputPrefixHasExtension = true;
-        break;
-      }
-    }
-
-    // Get output filename with appropriate extension
-    char outputName[512];
-    const char *outputExt = (use_png_ext_for_output ? "png" : "ppm");
-    const bool outputPrefixHasExt = (imgNameLen > 3 &&
-                                     output_prefix[imgNameLen-3] == outputExt[0] &&
-                                     output_prefix[imgNameLen-2] == outputExt[1] &&
-                                     output_prefix[imgNameLen-1] == outputExt[2]);
-
-    // if not extension - just add it at the end
-    if(outputPrefixHasExt) {
-      sprintf(outputName, "%s", output_prefix);
-    }
-    else {
-      sprintf(outputName, "%s.%s", output_prefix, outputExt);
-    }
-
-    // Write out using PNG extension?
-    if(use_png_ext_for_output) {
-
-      // save using lodePNG
-      unsigned char *imgRGBA = new unsigned char[4*image_width*image_height];
-      unsigned char *curImgPixel = imgRGBA;
-      for(int j = (int)(image_height - 1); j >= 0; j--) {
-        for(int i = 0; i < image_width; i++, curImgPixel+=4) {
-          const int index = start_framebuffer + 3 * (j * image_width + i);
-
-          float rgb[3];
-          rgb[0] = memory->getData()[index + 0].fvalue;
-          rgb[1] = memory->getData()[index + 1].fvalue;
-          rgb[2] = memory->getData()[index + 2].fvalue;
-
-          curImgPixel[0] = (char)(int)(rgb[0] * 255);
-          curImgPixel[1] = (char)(int)(rgb[1] * 255);
-          curImgPixel[2] = (char)(int)(rgb[2] * 255);
-          curImgPixel[3] = 255;
-        }
-      }
-
-      unsigned char* png;
-      size_t pngsize;
 
-      unsigned error = lodepng_encode32(&png, &pngsize, imgRGBA, image_width, image_height);
-      if(!error)
-        lodepng_save_file(png, pngsize, outputName);
-      else
-        printf("Error %u: %s\n", error, lodepng_error_text(error));
+    if(latency_histograms)
+      PrintLatencyHistograms(!disable_usimm);
 
-      free(png);
-      delete[] imgRGBA;
-    }
+    // Simulated memory is only committed on the host where it has been touched
+    printf("Simulated memory residency:\n");
+    memory->PrintResidency("Framebuffer", start_framebuffer, start_framebuffer + image_width * image_height * 3);
+    memory->PrintResidency("Loaded data", 0, end_memory);
+    memory->PrintResidency("Above loaded data", end_memory, memory_size);
+    memory->PrintResidency("Total", 0, memory_size);
+    printf("\n");
+  }  // end print_cpu
 
-    // Write out using PPM extension
-    else {
+  if(sampler) {
+    sampler->PrintEstimates(CountInstructions(cores), num_frames,
+                            (int)pow( 2.f, static_cast<float>(L2s[0]->line_size) ));
+    delete sampler;
+  }
 
-      FILE* output = fopen(outputName, "wb");
-      if(!output)
-        printf("Error: Failed to open image output file: %s\n", outputName);
+  if(host_profiler) {
+    host_profiler->PrintSummary(cycle_count, CountInstructions(cores));
+    delete host_profiler;
+  }
 
-#if OBJECTID_MAP
-        srand( (unsigned)time( NULL ) );
-        const int num_ids = 100000;
-        float id_colors[num_ids][3];
-        for (int i = 0; i < num_ids; i++) {
-          id_colors[i][0] = drand48();
-          id_colors[i][1] = drand48();
-          id_colors[i][2] = drand48();
-      }
-#endif
+  if(memory_trace) {
+    printf("Wrote %lld memory accesses to '%s'.\n", memory_trace->num_records, memory_trace_file);
+    delete memory_trace;
+  }
 
-        fprintf(output, "P6\n%d %d\n%d\n", image_width, image_height, 255);
-        for(int j = image_height - 1; j >= 0; j--) {
-          for(int i = 0; i < image_width; i++) {
-            const int index = start_framebuffer + 3 * (j * image_width + i);
+  if(issue_trace_writer) {
+    delete issue_trace_writer;
+    issue_trace_writer = NULL;
+  }
 
-            float rgb[3];
-#if OBJECTID_MAP
-            int object_id = memory->getData()[index].ivalue;
-
-            switch (object_id) {
-              case -1:
-                rgb[0] = .2;
-                rgb[1] = .1;
-                rgb[2] = .5;
-                break;
-              case 0:
-                rgb[0] = 1.;
-                rgb[1] = .4;
-                rgb[2] = 1.;
-                break;
-              case 1:
-                rgb[0] = .2;
-                rgb[1] = .3;
-                rgb[2] = 1.;
-                break;
-              case 2:
-                rgb[0] = 1.;
-                rgb[1] = .3;
-                rgb[2] = .2;
-                break;
-              default:
-                rgb[0] = id_colors[object_id % num_ids][0];
-                rgb[1] = id_colors[object_id % num_ids][1];
-                rgb[2] = id_colors[object_id % num_ids][2];
-                break;
-            };
-#else
-            // for gradient/colors we have the result
-            rgb[0] = memory->getData()[index + 0].fvalue;
-            rgb[1] = memory->getData()[index + 1].fvalue;
-            rgb[2] = memory->getData()[index + 2].fvalue;
-#endif
-            fprintf(output, "%c%c%c",
-                    (char)(int)(rgb[0] * 255),
-                    (char)(int)(rgb[1] * 255),
-                    (char)(int)(rgb[2] * 255));
-          }
-        } // end for j
-        fclose(output);
-      }
-    } // end if print_png
+  if(memory->incremental_writer) {
+    delete memory->incremental_writer;
+    memory->incremental_writer = NULL;
+  }
+  
+  fflush(stdout);
+  
 
 
   // reset the cores for a fresh frame
@@ -1471,8 +2196,6 @@ int main(int argc, char* argv[]) {
   for(size_t i = 0; i < num_L2s; i++)
     L2s[i]->Reset();
   
-  //} // put a loop around all this for multiple frames (see loop comment above)
-  
   // clean up thread stuff
   pthread_attr_destroy(&attr);
   pthread_mutex_destroy(&atominc_mutex);
@@ -10,6 +10,7 @@
 #include "memory_controller.h"
 #include "scheduler.h"
 #include "processor.h"
+#include "LatencyHistograms.h"
 
 extern int trax_verbosity;
 
@@ -175,6 +176,7 @@ void flush_activate_record(int channel, int rank, long long int cycle)
 // initialize dram variables and statistics
 void init_memory_controller_vars()
 {
+        update_mem_count = 0;
         num_read_merge =0;
 	num_write_merge =0;
 	for(int i=0; i<NUM_CHANNELS; i++)
@@ -194,6 +196,14 @@ void init_memory_controller_vars()
 				dram_state[i][j][k].next_pre = -1;
 				dram_state[i][j][k].next_pre = -1;
 
+				// zero like a fresh process, for setting usimm up again (--sweep)
+				dram_state[i][j][k].next_act = 0;
+				dram_state[i][j][k].next_read = 0;
+				dram_state[i][j][k].next_write = 0;
+				dram_state[i][j][k].next_powerdown = 0;
+				dram_state[i][j][k].next_powerup = 0;
+				dram_state[i][j][k].next_refresh = 0;
+
 				cmd_precharge_issuable[i][j][k] = 0;
 
 				stats_num_activate_read[i][j][k]=0;
@@ -231,6 +241,15 @@ void init_memory_controller_vars()
 
 			stats_num_activate[i][j]=0;
 
+			// the rest matter when usimm is set up again in the same process (--sweep)
+			issued_forced_refresh_commands[i][j]=0;
+			last_refresh[i][j]=0;
+			average_gap_between_refreshes[i][j]=0;
+			stats_time_spent_in_active_standby[i][j]=0;
+			stats_time_spent_in_power_up[i][j]=0;
+			stats_time_spent_terminating_reads_from_other_ranks[i][j]=0;
+			stats_time_spent_terminating_writes_to_other_ranks[i][j]=0;
+
 			command_issued_current_cycle[i]=0;
 		}
 
@@ -1293,6 +1312,8 @@ int issue_request_command(request_t * request)
 			//printf("Cycle: %10lld, Reads  Completed = %5lld, this_latency= %5lld, latency = %f\n", CYCLE_VAL, stats_reads_completed[channel], request->latency, stats_average_read_latency[channel]);	
 
 			stats_num_read[channel][rank][bank] ++;
+			if(latency_histograms)
+			  RecordDramRead(request->completion_time - request->arrival_time);
 
 			for(int i=0; i<NUM_RANKS ;i++)
 			{
@@ -1368,6 +1389,8 @@ int issue_request_command(request_t * request)
 		case PRE_CMD :
 
 		  total_col_reads[channel][rank][bank] += current_col_reads[channel][rank][bank];
+		  if(latency_histograms && current_col_reads[channel][rank][bank] > 0)
+		    RecordRowReads(current_col_reads[channel][rank][bank]);
 		  if(current_col_reads[channel][rank][bank] == 1)
 		    total_single_col_reads[channel][rank][bank]++;
 		  
@@ -1960,6 +1983,8 @@ void gather_stats(int channel)
 {
 
   accumulated_read_queue_length[channel] += read_queue_length[channel];
+  if(latency_histograms)
+    RecordDramQueues(channel, read_queue_length[channel], write_queue_length[channel]);
 
 	for(int i=0; i<NUM_RANKS; i++)
 	{
@@ -12,6 +12,9 @@ extern long long int CYCLE_VAL;
 int BANK_CAN_BE_CLOSED[MAX_NUM_CHANNELS][MAX_NUM_RANKS][MAX_NUM_BANKS];
 long long int schedule_count;
 
+// 1 means we are in write-drain mode for that channel
+int drain_writes[MAX_NUM_CHANNELS];
+
 void init_scheduler_vars()
 {
   // initialize all scheduler variables here
@@ -21,6 +24,8 @@ void init_scheduler_vars()
       {
         BANK_CAN_BE_CLOSED[i][j][k] = 0;
       }
+  for (int i=0; i < MAX_NUM_CHANNELS; i++)
+    drain_writes[i] = 0;
   return;
 }
 
@@ -30,9 +35,6 @@ void init_scheduler_vars()
 // end write queue drain once write queue has this many writes in it
 #define LO_WM 20
 
-// 1 means we are in write-drain mode for that channel
-int drain_writes[MAX_NUM_CHANNELS];
-
 /* Each cycle it is possible to issue a valid command from the read or write queues
    OR
    a valid precharge command to any bank (issue_precharge_command())
@@ -7,5 +7,7 @@ void schedule(int); // scheduler function called every cycle
 
 extern long long int CYCLE_VAL;
 extern long long int schedule_count;
+extern int BANK_CAN_BE_CLOSED[MAX_NUM_CHANNELS][MAX_NUM_RANKS][MAX_NUM_BANKS];
+extern int drain_writes[MAX_NUM_CHANNELS];
 
 #endif //__SCHEDULER_H__
@@ -22,6 +22,8 @@ affected threads' ready cycles for the given register.
 #include "memory_controller.h"
 #include "scheduler.h"
 #include "params.h"
+#include "utlist.h"
+#include "Checkpoint.h"
 
 #define MAXTRACELINESIZE 64
 
@@ -258,6 +260,10 @@ int usimm_setup(char* config_filename, char* usimm_vi_file)
   //int maxcr;
   //char newstr[MAXTRACELINESIZE];
 
+  // setup can run more than once in a process (--sweep), start the clock over
+  CYCLE_VAL = 0;
+  expt_done = 0;
+
   max_write_queue_length[0] = 0;
   max_write_queue_length[1] = 0;
   max_write_queue_length[2] = 0;
@@ -738,9 +744,60 @@ int usimm_setup(char* config_filename, char* usimm_vi_file)
 #endif
 
 // DK to close up the setup function, printstats will be below
+  free(nonmemops);
+  free(opertype);
+  free(addr);
+  free(instrpc);
   return 0;
 } 
 
+static void FreeQueue(request_t*& head)
+{
+  request_t* node;
+  request_t* tmp;
+  LL_FOREACH_SAFE(head, node, tmp)
+    {
+      LL_DELETE(head, node);
+      if(node->user_ptr)
+	free(node->user_ptr);
+      delete node;
+    }
+}
+
+void usimm_teardown()
+{
+  // Whatever is still queued belongs to TMs that are gone
+  for(int c = 0; c < NUM_CHANNELS; c++)
+    {
+      FreeQueue(read_queue_head[c]);
+      FreeQueue(write_queue_head[c]);
+      read_queue_length[c] = 0;
+      write_queue_length[c] = 0;
+    }
+
+  for(int i = 0; i < NUMCORES; i++)
+    {
+      free(ROB[i].comptime);
+      free(ROB[i].mem_address);
+      free(ROB[i].instrpc);
+      free(ROB[i].optype);
+    }
+  free(ROB);
+  free(tif);
+  free(committed);
+  free(fetched);
+  free(time_done);
+  free(prefixtable);
+  ROB = NULL;
+  tif = NULL;
+  committed = fetched = time_done = NULL;
+  prefixtable = NULL;
+
+  fclose(config_file);
+  fclose(vi_file);
+  config_file = vi_file = NULL;
+}
+
 float getUsimmPower()
 {
   float total_system_power =0;
@@ -876,6 +933,180 @@ bool usimmIsBusy()
   return false;
 }
 
+// The bank, rank and channel arrays are sized for the maximum configuration,
+// only the part in use is checkpointed.
+template <class T>
+static void CheckpointBankArray(CheckpointStream& cp, T array[MAX_NUM_CHANNELS][MAX_NUM_RANKS][MAX_NUM_BANKS])
+{
+  for(int c = 0; c < NUM_CHANNELS; c++)
+    for(int r = 0; r < NUM_RANKS; r++)
+      cp.Array(array[c][r], NUM_BANKS);
+}
+
+template <class T>
+static void CheckpointRankArray(CheckpointStream& cp, T array[MAX_NUM_CHANNELS][MAX_NUM_RANKS])
+{
+  for(int c = 0; c < NUM_CHANNELS; c++)
+    cp.Array(array[c], NUM_RANKS);
+}
+
+static void CheckpointQueue(CheckpointStream& cp, request_t*& head)
+{
+  int count = 0;
+  request_t* node;
+  LL_FOREACH(head, node)
+    count++;
+  cp.Value(count);
+
+  if(!cp.writing)
+    {
+      FreeQueue(head);
+      for(int i = 0; i < count; i++)
+	{
+	  node = new request_t();
+	  node->user_ptr = NULL;
+	  node->next = NULL;
+	  LL_APPEND(head, node);
+	}
+    }
+
+  LL_FOREACH(head, node)
+    {
+      cp.Value(node->physical_address);
+      cp.Value(node->dram_addr);
+      cp.Value(node->arrival_time);
+      cp.Value(node->dispatch_time);
+      cp.Value(node->completion_time);
+      cp.Value(node->latency);
+      cp.Value(node->thread_id);
+      cp.Value(node->next_command);
+      cp.Value(node->command_issuable);
+      cp.Value(node->operation_type);
+      cp.Value(node->request_served);
+      cp.Value(node->instruction_id);
+      cp.Value(node->instruction_pc);
+      cp.Value(node->op);
+
+      int num_reqs = (int)node->trax_reqs.size();
+      cp.Value(num_reqs);
+      if(!cp.writing)
+	node->trax_reqs.resize(num_reqs);
+      for(int i = 0; i < num_reqs; i++)
+	{
+	  trax_request& req = node->trax_reqs[i];
+	  cp.Value(req.result);
+	  cp.Value(req.which_reg);
+	  cp.Value(req.trax_addr);
+	  cp.Thread(req.thread);
+	  cp.L1(req.L1);
+	  cp.L2(req.L2);
+	}
+    }
+}
+
+void usimmCheckpoint(CheckpointStream& cp)
+{
+  cp.Check(NUM_CHANNELS, "DRAM channels");
+  cp.Check(NUM_RANKS, "DRAM ranks");
+  cp.Check(NUM_BANKS, "DRAM banks");
+
+  cp.Value(CYCLE_VAL);
+  cp.Value(expt_done);
+  cp.Value(committed[0]);
+  cp.Value(fetched[0]);
+  cp.Value(time_done[0]);
+  cp.Value(total_time_done);
+  cp.Value(update_mem_count);
+  cp.Value(schedule_count);
+  cp.Value(num_read_merge);
+  cp.Value(num_write_merge);
+
+  for(int c = 0; c < NUM_CHANNELS; c++)
+    {
+      CheckpointQueue(cp, read_queue_head[c]);
+      CheckpointQueue(cp, write_queue_head[c]);
+    }
+
+  // Activations are recorded in a large ring indexed by cycle, store only the set entries
+  for(int c = 0; c < NUM_CHANNELS; c++)
+    for(int r = 0; r < NUM_RANKS; r++)
+      {
+	std::vector<int> active;
+	for(int w = 0; cp.writing && w < BIG_ACTIVATION_WINDOW; w++)
+	  if(activation_record[c][r][w])
+	    active.push_back(w);
+	cp.Vector(active, 0);
+	if(!cp.writing)
+	  {
+	    memset(activation_record[c][r], 0, sizeof(activation_record[c][r]));
+	    for(size_t i = 0; i < active.size(); i++)
+	      activation_record[c][r][active[i]] = 1;
+	  }
+      }
+
+  CheckpointBankArray(cp, dram_state);
+  CheckpointBankArray(cp, total_col_reads);
+  CheckpointBankArray(cp, total_pre_cmds);
+  CheckpointBankArray(cp, total_single_col_reads);
+  CheckpointBankArray(cp, current_col_reads);
+  CheckpointBankArray(cp, cas_issued_current_cycle);
+  CheckpointBankArray(cp, cmd_precharge_issuable);
+  CheckpointBankArray(cp, BANK_CAN_BE_CLOSED);
+  CheckpointBankArray(cp, stats_num_activate_read);
+  CheckpointBankArray(cp, stats_num_activate_write);
+  CheckpointBankArray(cp, stats_num_activate_spec);
+  CheckpointBankArray(cp, stats_num_precharge);
+  CheckpointBankArray(cp, stats_num_read);
+  CheckpointBankArray(cp, stats_num_write);
+
+  CheckpointRankArray(cp, cmd_all_bank_precharge_issuable);
+  CheckpointRankArray(cp, cmd_powerdown_fast_issuable);
+  CheckpointRankArray(cp, cmd_powerdown_slow_issuable);
+  CheckpointRankArray(cp, cmd_powerup_issuable);
+  CheckpointRankArray(cp, cmd_refresh_issuable);
+  CheckpointRankArray(cp, next_refresh_completion_deadline);
+  CheckpointRankArray(cp, last_refresh_completion_deadline);
+  CheckpointRankArray(cp, forced_refresh_mode_on);
+  CheckpointRankArray(cp, refresh_issue_deadline);
+  CheckpointRankArray(cp, issued_forced_refresh_commands);
+  CheckpointRankArray(cp, num_issued_refreshes);
+  CheckpointRankArray(cp, stats_time_spent_in_active_standby);
+  CheckpointRankArray(cp, stats_time_spent_in_active_power_down);
+  CheckpointRankArray(cp, stats_time_spent_in_precharge_power_down_fast);
+  CheckpointRankArray(cp, stats_time_spent_in_precharge_power_down_slow);
+  CheckpointRankArray(cp, stats_time_spent_in_power_up);
+  CheckpointRankArray(cp, last_activate);
+  CheckpointRankArray(cp, last_refresh);
+  CheckpointRankArray(cp, average_gap_between_activates);
+  CheckpointRankArray(cp, average_gap_between_refreshes);
+  CheckpointRankArray(cp, stats_time_spent_terminating_reads_from_other_ranks);
+  CheckpointRankArray(cp, stats_time_spent_terminating_writes_to_other_ranks);
+  CheckpointRankArray(cp, stats_num_activate);
+  CheckpointRankArray(cp, stats_num_powerdown_slow);
+  CheckpointRankArray(cp, stats_num_powerdown_fast);
+  CheckpointRankArray(cp, stats_num_powerup);
+
+  cp.Array(command_issued_current_cycle, NUM_CHANNELS);
+  cp.Array(drain_writes, NUM_CHANNELS);
+  cp.Array(max_write_queue_length, NUM_CHANNELS);
+  cp.Array(max_read_queue_length, NUM_CHANNELS);
+  cp.Array(accumulated_read_queue_length, NUM_CHANNELS);
+  cp.Array(read_queue_length, NUM_CHANNELS);
+  cp.Array(write_queue_length, NUM_CHANNELS);
+  cp.Array(stats_reads_merged_per_channel, NUM_CHANNELS);
+  cp.Array(stats_writes_merged_per_channel, NUM_CHANNELS);
+  cp.Array(stats_reads_seen, NUM_CHANNELS);
+  cp.Array(stats_writes_seen, NUM_CHANNELS);
+  cp.Array(stats_reads_completed, NUM_CHANNELS);
+  cp.Array(stats_writes_completed, NUM_CHANNELS);
+  cp.Array(stats_average_read_latency, NUM_CHANNELS);
+  cp.Array(stats_average_read_queue_latency, NUM_CHANNELS);
+  cp.Array(stats_average_write_latency, NUM_CHANNELS);
+  cp.Array(stats_average_write_queue_latency, NUM_CHANNELS);
+  cp.Array(stats_page_hits, NUM_CHANNELS);
+  cp.Array(stats_read_row_hit_rate, NUM_CHANNELS);
+}
+
 
 
 
@@ -1,8 +1,15 @@
 #ifndef USIMM_H_
 #define USIMM_H_
+
+class CheckpointStream;
+
 int usimm_setup(char* config_filename, char* usimm_vi_file);
+// frees what usimm_setup allocated and anything still queued, so it can be set up again (--sweep)
+void usimm_teardown();
 float getUsimmPower();
 void printUsimmStats();
 void usimmClock();
 bool usimmIsBusy();
+// saves or restores the queues, bank states and stats of the memory system
+void usimmCheckpoint(CheckpointStream& cp);
 #endif